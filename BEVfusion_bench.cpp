@@ -0,0 +1,706 @@
+// BEVfusion 进程内基准测试
+// 直接链接五个阶段的静态库，不依赖 SIMULATOR_ROOT / sniper / popnet，
+// 在普通 Linux 机器上即可统计各阶段及端到端延迟。
+//
+// 用法: bevfusion_bench [--warmup N] [--iters N] [--random] [--seed S] [--archive 帧归档.bfa] [--check-kernels] [--camera-groups 1,2,3,6] [--lidar-profile] [--lidar-scaling 1,2,4,8]
+//
+// 给出 --archive 时按顺序循环回放录制帧（mmap + 后台预读），否则使用合成输入。
+// --check-kernels 把每个已编译指令集等级的手写内核与标量参考实现逐位对比，再核对稀疏卷积的 gather-GEMM、规则表和 Morton 重排后退出。
+// --camera-groups 只运行 camera_backbone，依次用列出的相机分组数（见 camera_backbone.h）计时后对比退出。
+// --lidar-profile 只运行 lidar_backbone，分别以字典序和 Morton 序存放活跃体素计时，各打印一帧逐层剖析后退出。
+// --lidar-scaling 只运行 lidar_backbone，在 2 万 / 6 万 / 15 万个体素的合成点云上依次用列出的线程数计时后退出。
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "camera_backbone/camera_backbone.h"
+#include "camera_vtransform/camera_vtransform.h"
+#include "lidar_backbone/lidar_backbone.h"
+#include "lidar_backbone/indice_key.h"
+#include "lidar_backbone/sparse_gemm.h"
+#include "fuser/fuser.h"
+#include "head/head.h"
+#include "frame_archive.h"
+#include "cpu_dispatch.h"
+#include "kernels.h"
+
+struct BenchOptions {
+    int warmup = 1;          // 预热帧数，不计入统计
+    int iters = 5;           // 计时帧数
+    bool random = false;     // true: 随机输入; false: 与 main/main.cpp 相同的常量输入
+    unsigned seed = 0;
+    std::string archive;     // 帧归档路径，为空时使用合成输入
+    bool check_kernels = false;
+    std::vector<int> camera_groups;  // 非空时只对比 camera_backbone 的各分组方式
+    bool lidar_profile = false;      // 只对比 lidar_backbone 的体素存放顺序
+    std::vector<int> lidar_threads;  // 非空时只测 lidar_backbone 随线程数的扩展性
+};
+
+// 单个阶段的耗时样本
+struct StageStats {
+    std::string name;
+    std::vector<double> samples_ms;
+
+    explicit StageStats(std::string n) : name(std::move(n)) {}
+
+    void print() const {
+        if (samples_ms.empty()) return;
+        std::vector<double> sorted = samples_ms;
+        std::sort(sorted.begin(), sorted.end());
+        double sum = 0.0;
+        for (double v : sorted) sum += v;
+        std::cout << std::left << std::setw(20) << name << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(12) << sum / sorted.size()
+                  << std::setw(12) << sorted.front()
+                  << std::setw(12) << sorted[sorted.size() / 2]
+                  << std::setw(12) << sorted.back() << std::endl;
+    }
+};
+
+// 合成输入的存储，尺寸与 chiplet 之间的消息一致
+struct SyntheticInputs {
+    std::vector<float> img;     // 1×6×3×256×704
+    std::vector<float> depth;   // 1×6×1×256×704
+    std::vector<float> points;  // 3×5
+
+    bevfusion::FrameView view() const {
+        bevfusion::FrameView v;
+        v.img = img.data();
+        v.depth = depth.data();
+        v.points = points.data();
+        v.num_points = points.size() / bevfusion::kPointDim;
+        return v;
+    }
+};
+
+static BenchOptions parse_args(int argc, char** argv) {
+    BenchOptions opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--warmup" && i + 1 < argc) {
+            opt.warmup = std::atoi(argv[++i]);
+        } else if (arg == "--iters" && i + 1 < argc) {
+            opt.iters = std::atoi(argv[++i]);
+        } else if (arg == "--random") {
+            opt.random = true;
+        } else if (arg == "--seed" && i + 1 < argc) {
+            opt.seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--archive" && i + 1 < argc) {
+            opt.archive = argv[++i];
+        } else if (arg == "--check-kernels") {
+            opt.check_kernels = true;
+        } else if (arg == "--camera-groups" && i + 1 < argc) {
+            std::istringstream list(argv[++i]);
+            for (std::string item; std::getline(list, item, ',');) opt.camera_groups.push_back(std::atoi(item.c_str()));
+        } else if (arg == "--lidar-profile") {
+            opt.lidar_profile = true;
+        } else if (arg == "--lidar-scaling" && i + 1 < argc) {
+            std::istringstream list(argv[++i]);
+            for (std::string item; std::getline(list, item, ',');) opt.lidar_threads.push_back(std::atoi(item.c_str()));
+        } else {
+            std::cerr << "未知参数: " << arg << std::endl;
+            std::cerr << "用法: " << argv[0] << " [--warmup N] [--iters N] [--random] [--seed S] [--archive 帧归档.bfa] [--check-kernels] [--camera-groups 1,2,3,6] [--lidar-profile] [--lidar-scaling 1,2,4,8]" << std::endl;
+            std::exit(1);
+        }
+    }
+    return opt;
+}
+
+static SyntheticInputs make_synthetic_inputs(const BenchOptions& opt) {
+    SyntheticInputs in;
+    in.img.assign(1 * 6 * 3 * 256 * 704, 0.1f);
+    in.depth.assign(1 * 6 * 1 * 256 * 704, 0.2f);
+    in.points.assign(3 * 5, 1.0f);
+    if (opt.random) {
+        std::mt19937 gen(opt.seed);
+        std::uniform_real_distribution<float> dis(0.0f, 1.0f);
+        for (auto& v : in.img) v = dis(gen);
+        for (auto& v : in.depth) v = dis(gen);
+    }
+    return in;
+}
+
+// 合成的 LiDAR 点云：传感器离地 1.84 m，射线仰角在 [-30°, 10°] 内连续取值（相当于多线束多帧叠加），
+// 先碰到每个方位扇区的一堵墙或地面。每个体素只保留一个点，点数即体素数，体素网格与 lidar_backbone.cpp 一致
+static std::vector<float> make_lidar_points(int64_t voxels, unsigned seed) {
+    const float kRange = 54.0f, kZMin = -5.0f, kZMax = 3.0f, kVoxelXY = 0.075f, kVoxelZ = 0.2f;
+    const float kSensorHeight = 1.84f, kPi = 3.14159265f;
+    const int kSectors = 64;
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<float> walls(kSectors);
+    for (auto& w : walls) w = 8.0f + 42.0f * unit(gen);
+
+    std::vector<float> points;
+    std::unordered_set<int64_t> occupied;
+    for (int64_t attempts = 0; static_cast<int64_t>(occupied.size()) < voxels && attempts < voxels * 50; ++attempts) {
+        const float azimuth = 2 * kPi * unit(gen);
+        const float elevation = (-30.0f + 40.0f * unit(gen)) * kPi / 180.0f;
+        float r = walls[static_cast<int>(azimuth / (2 * kPi) * kSectors) % kSectors];
+        float z = r * std::tan(elevation);
+        if (z < -kSensorHeight) {
+            r = kSensorHeight / std::tan(-elevation);
+            z = -kSensorHeight;
+        }
+        const float x = r * std::cos(azimuth), y = r * std::sin(azimuth);
+        if (std::fabs(x) >= kRange || std::fabs(y) >= kRange || z < kZMin || z >= kZMax) continue;
+        const int64_t key = (static_cast<int64_t>((x + kRange) / kVoxelXY) * 1440 +
+                             static_cast<int64_t>((y + kRange) / kVoxelXY)) * 41 +
+                            static_cast<int64_t>((z - kZMin) / kVoxelZ);
+        if (!occupied.insert(key).second) continue;
+        points.insert(points.end(), {x, y, z, unit(gen), 0.0f});
+    }
+    return points;
+}
+
+// 内核输入：覆盖 0 / -0 / NaN / Inf / float16 溢出与非规格化边界，其余为跨多个数量级的随机数
+static std::vector<float> make_kernel_inputs(size_t n, unsigned seed) {
+    const float specials[] = {0.0f, -0.0f, NAN, -NAN, INFINITY, -INFINITY, 65504.0f, 65519.0f, 65520.0f, -65520.0f,
+                              1e-8f, 2.98023224e-8f, 5.96046448e-8f, 6.1035156e-5f, 6.09755516e-5f, 1e-40f, 1.0f, -1.0f};
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> mant(-1.0f, 1.0f);
+    std::uniform_int_distribution<int> exp(-30, 20);
+    std::vector<float> v(n);
+    for (size_t i = 0; i < n; ++i) {
+        v[i] = (i < sizeof(specials) / sizeof(specials[0])) ? specials[i] : std::ldexp(mant(gen), exp(gen));
+    }
+    return v;
+}
+
+// 每个已编译的指令集等级与标量参考实现逐位对比；包含非对齐起点和各种尾部长度
+static bool check_kernels() {
+    using namespace bevfusion;
+    const KernelTable* ref = kernel_table(IsaLevel::Scalar);
+    const size_t lengths[] = {0, 1, 3, 7, 8, 15, 16, 17, 31, 33, 63, 64, 65, 1000, 4099};
+    std::vector<float> in = make_kernel_inputs(4099 + 1, 1234);
+
+    std::cout << "检测到 " << isa_name(detected_isa()) << "，当前使用 " << isa_name(active_isa()) << std::endl;
+    bool all_ok = true;
+    for (IsaLevel level : {IsaLevel::SSE4, IsaLevel::AVX2, IsaLevel::AVX512}) {
+        const KernelTable* t = kernel_table(level);
+        if (!t) continue;
+        if (level > detected_isa()) {
+            std::cout << std::left << std::setw(8) << isa_name(level) << "本机不支持，跳过" << std::endl;
+            continue;
+        }
+        bool relu_ok = true, f16_ok = true;
+        for (size_t n : lengths) {
+            for (size_t offset : {0, 1}) {
+                const float* x = in.data() + offset;
+                std::vector<float> y_ref(n + 1, -1.0f), y(n + 1, -1.0f);
+                ref->relu(x, y_ref.data(), n);
+                t->relu(x, y.data(), n);
+                relu_ok &= std::memcmp(y_ref.data(), y.data(), (n + 1) * sizeof(float)) == 0;
+
+                std::vector<uint16_t> h_ref(n + 1, 0xabcd), h(n + 1, 0xabcd);
+                ref->f32_to_f16(x, h_ref.data(), n);
+                t->f32_to_f16(x, h.data(), n);
+                f16_ok &= std::memcmp(h_ref.data(), h.data(), (n + 1) * sizeof(uint16_t)) == 0;
+            }
+        }
+        // GEMM 微内核允许 FMA 带来的舍入差异，按 Σ|a·b| 给相对误差上限
+        bool gemm_ok = true;
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+        for (int k : {1, 5, 64, 300}) {
+            std::vector<float> a(k * kGemmMR), b(k * kGemmNR);
+            for (auto& v : a) v = dis(gen);
+            for (auto& v : b) v = dis(gen);
+            float c_ref[kGemmMR * kGemmNR], c[kGemmMR * kGemmNR];
+            ref->sgemm_tile(k, a.data(), b.data(), c_ref);
+            t->sgemm_tile(k, a.data(), b.data(), c);
+            for (int i = 0; i < kGemmMR; ++i) {
+                for (int j = 0; j < kGemmNR; ++j) {
+                    double mag = 0;
+                    for (int p = 0; p < k; ++p) mag += std::fabs(a[p * kGemmMR + i] * b[p * kGemmNR + j]);
+                    gemm_ok &= std::fabs(c_ref[i * kGemmNR + j] - c[i * kGemmNR + j]) <= 1e-5 * mag + 1e-30;
+                }
+            }
+        }
+        std::cout << std::left << std::setw(8) << isa_name(level) << "relu " << (relu_ok ? "OK" : "FAIL")
+                  << "  f32_to_f16 " << (f16_ok ? "OK" : "FAIL") << "  sgemm_tile " << (gemm_ok ? "OK" : "FAIL")
+                  << std::endl;
+        all_ok &= relu_ok && f16_ok && gemm_ok;
+    }
+    return all_ok;
+}
+
+// lidar_backbone 的 gather-GEMM 与逐配对的双精度参考对比；覆盖不足一块、不足 4 行一组的尾部和无 bias
+static bool check_sparse_gemm() {
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+    bool ok = true;
+    for (int64_t rows : {1, 5, 37, 1000}) {
+        for (int cin : {5, 16, 33}) {
+            const int K = 27, cout = 16, n = 500;
+            std::vector<int32_t> table(rows * K);
+            for (auto& j : table) j = gen() % 3 == 0 ? static_cast<int32_t>(gen() % n) : -1;
+            std::vector<float> in(static_cast<size_t>(n) * cin), w(static_cast<size_t>(K) * cin * cout), bias(cout);
+            for (auto& v : in) v = dis(gen);
+            for (auto& v : w) v = dis(gen);
+            for (auto& v : bias) v = dis(gen);
+            for (bool with_bias : {true, false}) {
+                std::vector<float> out(rows * cout);
+                bevfusion::sparse_conv_gemm(table.data(), rows, K, in.data(), cin, w.data(),
+                                            with_bias ? bias.data() : nullptr, cout, out.data());
+                for (int64_t o = 0; o < rows; ++o) {
+                    for (int c = 0; c < cout; ++c) {
+                        double ref = with_bias ? bias[c] : 0.0, mag = std::fabs(ref);
+                        for (int k = 0; k < K; ++k) {
+                            const int32_t j = table[o * K + k];
+                            if (j < 0) continue;
+                            for (int i = 0; i < cin; ++i) {
+                                const double v = in[j * cin + i] * w[(static_cast<size_t>(k) * cin + i) * cout + c];
+                                ref += v;
+                                mag += std::fabs(v);
+                            }
+                        }
+                        ok &= std::fabs(out[o * cout + c] - ref) <= 1e-5 * mag + 1e-30;
+                    }
+                }
+            }
+        }
+    }
+    std::cout << "sparse_conv_gemm " << (ok ? "OK" : "FAIL") << std::endl;
+    return ok;
+}
+
+// 稠密网格上的稀疏张量：row_at 为每个格点的行号（-1 为空），features 为 [N][C]（双精度参考值），
+// mag 为各特征的 Σ|·| 上界，用于给逐层累积的舍入误差定上限
+struct DenseGrid {
+    int64_t size[3];
+    std::vector<int32_t> row_at;
+    std::vector<int32_t> coords;
+    std::vector<double> features, mag;
+    int channels = 0;
+
+    int64_t at(int64_t d0, int64_t d1, int64_t d2) const { return (d0 * size[1] + d1) * size[2] + d2; }
+    int32_t row(int64_t d0, int64_t d1, int64_t d2) const {
+        if (d0 < 0 || d0 >= size[0] || d1 < 0 || d1 >= size[1] || d2 < 0 || d2 >= size[2]) return -1;
+        return row_at[at(d0, d1, d2)];
+    }
+};
+
+// 在 size 网格上按 density 随机取活跃体素，行序打乱（与体素化输出一样没有规律）
+static DenseGrid make_sparse_grid(const int64_t size[3], double density, int channels, std::mt19937& gen) {
+    DenseGrid g;
+    std::copy(size, size + 3, g.size);
+    g.channels = channels;
+    g.row_at.assign(size[0] * size[1] * size[2], -1);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::vector<int64_t> cells;
+    for (int64_t c = 0; c < static_cast<int64_t>(g.row_at.size()); ++c) {
+        if (unit(gen) < density) cells.push_back(c);
+    }
+    std::shuffle(cells.begin(), cells.end(), gen);
+    for (size_t i = 0; i < cells.size(); ++i) {
+        const int64_t c = cells[i];
+        g.row_at[c] = static_cast<int32_t>(i);
+        g.coords.insert(g.coords.end(), {static_cast<int32_t>(c / (size[1] * size[2])),
+                                         static_cast<int32_t>(c / size[2] % size[1]), static_cast<int32_t>(c % size[2])});
+    }
+    std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+    g.features.resize(cells.size() * channels);
+    for (auto& v : g.features) v = dis(gen);
+    g.mag.resize(g.features.size());
+    for (size_t i = 0; i < g.features.size(); ++i) g.mag[i] = std::fabs(g.features[i]);
+    return g;
+}
+
+// 稠密参考：输出位置 o 处 bias + Σ_k in(o·stride + k - padding) · W[k]，W 为 [K][cin][cout]，空位置按 0 计
+static void dense_conv_at(const DenseGrid& in, const int32_t o[3], const int64_t kernel[3], const int64_t stride[3],
+                          const int64_t padding[3], const std::vector<float>& w, const std::vector<float>& bias, int cout,
+                          double* ref, double* mag) {
+    const int cin = in.channels;
+    for (int c = 0; c < cout; ++c) {
+        ref[c] = bias[c];
+        mag[c] = std::fabs(bias[c]);
+    }
+    int k = 0;
+    for (int64_t k0 = 0; k0 < kernel[0]; ++k0) {
+        for (int64_t k1 = 0; k1 < kernel[1]; ++k1) {
+            for (int64_t k2 = 0; k2 < kernel[2]; ++k2, ++k) {
+                const int32_t j = in.row(o[0] * stride[0] + k0 - padding[0], o[1] * stride[1] + k1 - padding[1],
+                                         o[2] * stride[2] + k2 - padding[2]);
+                if (j < 0) continue;
+                for (int i = 0; i < cin; ++i) {
+                    const float* wk = w.data() + (static_cast<size_t>(k) * cin + i) * cout;
+                    for (int c = 0; c < cout; ++c) {
+                        ref[c] += in.features[static_cast<size_t>(j) * cin + i] * wk[c];
+                        mag[c] += in.mag[static_cast<size_t>(j) * cin + i] * std::fabs(wk[c]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// 按规则表做 gather-GEMM，与稠密参考逐元素比较
+static bool gemm_matches(const int32_t* table, int64_t rows, int K, const std::vector<float>& in, int cin,
+                         const std::vector<float>& w, const std::vector<float>& bias, int cout,
+                         const std::vector<double>& ref, const std::vector<double>& mag, std::vector<float>* out_keep) {
+    std::vector<float> out(static_cast<size_t>(rows) * cout);
+    bevfusion::sparse_conv_gemm(table, rows, K, in.data(), cin, w.data(), bias.data(), cout, out.data());
+    bool ok = true;
+    for (size_t i = 0; i < out.size(); ++i) ok &= std::fabs(out[i] - ref[i]) <= 1e-5 * mag[i] + 1e-30;
+    if (out_keep) out_keep->swap(out);
+    return ok;
+}
+
+static std::vector<float> random_floats(size_t n, std::mt19937& gen) {
+    std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+    std::vector<float> v(n);
+    for (auto& x : v) x = dis(gen);
+    return v;
+}
+
+// lidar_backbone 的规则表与 Morton 重排和稠密网格上的暴力计算对比：
+//   普通稀疏卷积  逐个输出格点枚举核偏移得到输出集合（字典序）和规则表，特征与稠密卷积比较；
+//                 覆盖 lidar_backbone 用到的 stride 2、d2 方向不补零和 1×1×3 核；
+//   子流形卷积    规则表逐项比较，并像 indice key 缓存那样连续两层共用同一份规则表，与两层稠密卷积比较；
+//   Morton 序     与按 Morton 码 stable_sort 的结果比较（含多块并行基数排序的规模），
+//                 重排后重建规则表的两层结果与稠密卷积比较
+static bool check_sparse_rulebooks() {
+    std::mt19937 gen(11);
+    const int cin = 8, cout = 8;
+
+    // 1. 普通稀疏卷积
+    struct ConvCase {
+        int64_t size[3], kernel[3], stride[3], padding[3];
+        double density;
+    };
+    const ConvCase conv_cases[] = {
+        {{17, 15, 9}, {3, 3, 3}, {2, 2, 2}, {1, 1, 1}, 0.1},
+        {{16, 14, 11}, {3, 3, 3}, {2, 2, 2}, {1, 1, 0}, 0.1},
+        {{9, 9, 5}, {1, 1, 3}, {1, 1, 2}, {0, 0, 0}, 0.3},
+        {{64, 64, 21}, {3, 3, 3}, {2, 2, 2}, {1, 1, 1}, 0.03},
+    };
+    bool conv_ok = true;
+    for (const ConvCase& cc : conv_cases) {
+        DenseGrid in = make_sparse_grid(cc.size, cc.density, cin, gen);
+        const int64_t n = static_cast<int64_t>(in.coords.size() / 3);
+        const int K = static_cast<int>(cc.kernel[0] * cc.kernel[1] * cc.kernel[2]);
+        bevfusion::ConvRulebook rb =
+            bevfusion::build_conv_rulebook(in.coords.data(), n, cc.size, cc.kernel, cc.stride, cc.padding);
+
+        int64_t out_size[3];
+        for (int d = 0; d < 3; ++d) out_size[d] = bevfusion::conv_output_size(cc.size[d], cc.kernel[d], cc.stride[d], cc.padding[d]);
+        std::vector<int32_t> out_coords, table;
+        int64_t pairs = 0;
+        for (int32_t o0 = 0; o0 < out_size[0]; ++o0) {
+            for (int32_t o1 = 0; o1 < out_size[1]; ++o1) {
+                for (int32_t o2 = 0; o2 < out_size[2]; ++o2) {
+                    std::vector<int32_t> nb(K, -1);
+                    int k = 0, hits = 0;
+                    for (int64_t k0 = 0; k0 < cc.kernel[0]; ++k0) {
+                        for (int64_t k1 = 0; k1 < cc.kernel[1]; ++k1) {
+                            for (int64_t k2 = 0; k2 < cc.kernel[2]; ++k2, ++k) {
+                                nb[k] = in.row(o0 * cc.stride[0] + k0 - cc.padding[0], o1 * cc.stride[1] + k1 - cc.padding[1],
+                                               o2 * cc.stride[2] + k2 - cc.padding[2]);
+                                hits += nb[k] >= 0;
+                            }
+                        }
+                    }
+                    if (hits == 0) continue;
+                    pairs += hits;
+                    out_coords.insert(out_coords.end(), {o0, o1, o2});
+                    table.insert(table.end(), nb.begin(), nb.end());
+                }
+            }
+        }
+        conv_ok &= std::equal(out_size, out_size + 3, rb.out_size) && rb.num_pairs == pairs &&
+                   rb.out_coords == out_coords && rb.neighbors == table;
+        if (rb.neighbors != table) continue;
+
+        std::vector<float> w = random_floats(static_cast<size_t>(K) * cin * cout, gen), bias = random_floats(cout, gen);
+        std::vector<double> ref(static_cast<size_t>(rb.num_out) * cout), mag(ref.size());
+        for (int64_t r = 0; r < rb.num_out; ++r) {
+            dense_conv_at(in, &out_coords[r * 3], cc.kernel, cc.stride, cc.padding, w, bias, cout, &ref[r * cout], &mag[r * cout]);
+        }
+        std::vector<float> features(in.features.begin(), in.features.end());
+        conv_ok &= gemm_matches(rb.neighbors.data(), rb.num_out, K, features, cin, w, bias, cout, ref, mag, nullptr);
+    }
+    std::cout << "build_conv_rulebook " << (conv_ok ? "OK" : "FAIL") << std::endl;
+
+    // 2. 子流形卷积：规则表逐项比较；两层共用一份规则表，与两层稠密卷积比较。
+    //    subm_chain 在给定行序的体素上计算，返回第二层输出（行序与输入相同）
+    const int64_t size[3] = {24, 20, 9}, kernel[3] = {3, 3, 3}, one[3] = {1, 1, 1};
+    const int K = 27;
+    std::vector<float> w1 = random_floats(static_cast<size_t>(K) * cin * cout, gen), b1 = random_floats(cout, gen);
+    std::vector<float> w2 = random_floats(static_cast<size_t>(K) * cout * cout, gen), b2 = random_floats(cout, gen);
+    auto subm_chain = [&](const DenseGrid& in, bool* table_ok) {
+        const int64_t n = static_cast<int64_t>(in.coords.size() / 3);
+        bevfusion::SubmRulebook rb = bevfusion::build_subm_rulebook(in.coords.data(), n, size, kernel, one);
+        std::vector<int32_t> table(static_cast<size_t>(n) * K);
+        int64_t pairs = 0;
+        for (int64_t i = 0; i < n; ++i) {
+            const int32_t* c = &in.coords[i * 3];
+            for (int k = 0; k < K; ++k) {
+                table[i * K + k] = in.row(c[0] + k / 9 - 1, c[1] + k / 3 % 3 - 1, c[2] + k % 3 - 1);
+                pairs += k != 13 && table[i * K + k] >= 0;
+            }
+        }
+        *table_ok = rb.center == 13 && rb.num_pairs == pairs && rb.neighbors == table;
+
+        // 第一层的稠密参考作为第二层的输入（只在活跃体素上有值）
+        DenseGrid mid = in;
+        mid.channels = cout;
+        mid.features.assign(static_cast<size_t>(n) * cout, 0.0);
+        mid.mag.assign(mid.features.size(), 0.0);
+        for (int64_t i = 0; i < n; ++i) {
+            dense_conv_at(in, &in.coords[i * 3], kernel, one, one, w1, b1, cout, &mid.features[i * cout], &mid.mag[i * cout]);
+        }
+        std::vector<double> ref(static_cast<size_t>(n) * cout), mag(ref.size());
+        for (int64_t i = 0; i < n; ++i) {
+            dense_conv_at(mid, &in.coords[i * 3], kernel, one, one, w2, b2, cout, &ref[i * cout], &mag[i * cout]);
+        }
+        std::vector<float> x(in.features.begin(), in.features.end()), y;
+        bool ok = gemm_matches(rb.neighbors.data(), n, K, x, cin, w1, b1, cout, mid.features, mid.mag, &y);
+        ok &= gemm_matches(rb.neighbors.data(), n, K, y, cout, w2, b2, cout, ref, mag, nullptr);
+        return ok;
+    };
+    DenseGrid grid = make_sparse_grid(size, 0.2, cin, gen);
+    bool subm_table_ok = false;
+    const bool subm_ok = subm_chain(grid, &subm_table_ok) && subm_table_ok;
+    std::cout << "build_subm_rulebook（两层共用） " << (subm_ok ? "OK" : "FAIL") << std::endl;
+
+    // 3. Morton 序：与 stable_sort 比较；小网格上重排后再算一遍子流形两层
+    bool morton_ok = true;
+    auto sorted_by_code = [](const std::vector<int32_t>& coords) {
+        std::vector<int32_t> order(coords.size() / 3);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](int32_t a, int32_t b) {
+            return bevfusion::morton_code(coords[a * 3], coords[a * 3 + 1], coords[a * 3 + 2]) <
+                   bevfusion::morton_code(coords[b * 3], coords[b * 3 + 1], coords[b * 3 + 2]);
+        });
+        return order;
+    };
+    {
+        // 多块并行的基数排序，坐标可重复（检验稳定性），范围与体素网格 1440×1440×41 相同
+        std::vector<int32_t> coords(3 * 100000);
+        for (size_t i = 0; i < coords.size(); i += 3) {
+            coords[i] = static_cast<int32_t>(gen() % 1440);
+            coords[i + 1] = static_cast<int32_t>(gen() % 1440);
+            coords[i + 2] = static_cast<int32_t>(gen() % 41);
+            if (i >= 3 && gen() % 8 == 0) std::copy(&coords[i - 3], &coords[i], &coords[i]);
+        }
+        morton_ok &= bevfusion::morton_order(coords.data(), static_cast<int64_t>(coords.size() / 3)) == sorted_by_code(coords);
+    }
+    std::vector<int32_t> order = bevfusion::morton_order(grid.coords.data(), static_cast<int64_t>(grid.coords.size() / 3));
+    morton_ok &= order == sorted_by_code(grid.coords);
+    DenseGrid sorted = grid;
+    for (size_t r = 0; r < order.size(); ++r) {
+        const int32_t* c = &grid.coords[order[r] * 3];
+        std::copy(c, c + 3, &sorted.coords[r * 3]);
+        sorted.row_at[sorted.at(c[0], c[1], c[2])] = static_cast<int32_t>(r);
+        std::copy(&grid.features[order[r] * cin], &grid.features[(order[r] + 1) * cin], &sorted.features[r * cin]);
+        std::copy(&grid.mag[order[r] * cin], &grid.mag[(order[r] + 1) * cin], &sorted.mag[r * cin]);
+    }
+    bool sorted_table_ok = false;
+    morton_ok &= subm_chain(sorted, &sorted_table_ok) && sorted_table_ok;
+    std::cout << "morton_order " << (morton_ok ? "OK" : "FAIL") << std::endl;
+
+    return conv_ok && subm_ok && morton_ok;
+}
+
+template <typename F>
+static double time_ms(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// 各阶段的输出缓冲，整个运行期间只分配一次
+struct StageBuffers {
+    std::vector<float> camera_features = std::vector<float>(6 * 32 * 88 * 80);
+    std::vector<float> camera_bev_features = std::vector<float>(1 * 80 * 180 * 180);
+    std::vector<float> lidar_features = std::vector<float>(1 * 256 * 180 * 180);
+    std::vector<float> fused_features = std::vector<float>(1 * 512 * 180 * 180);
+};
+
+// 按 main/main.cpp 中的顺序执行一帧；stats 为空时只跑不记录（预热）。任一阶段失败时打印并返回 false，不记录本帧
+static bool run_frame(const bevfusion::FrameView& in, StageBuffers& buf, std::vector<StageStats>* stats) {
+    static const char* const names[] = {"camera_backbone", "camera_vtransform", "lidar_backbone", "fuser", "head"};
+    double t[5];
+    bool ok[5] = {true, true, true, true, true};
+    float pose[16];
+    bevfusion::lidar_pose(in.calib, pose);
+    t[0] = time_ms([&] { camera_backbone(in.img, in.depth, buf.camera_features.data()); });
+    t[1] = time_ms([&] { ok[1] = camera_vtransform(buf.camera_features.data(), buf.camera_bev_features.data()); });
+    t[2] = time_ms([&] {
+        ok[2] = lidar_backbone(in.points, in.num_points, in.timestamp_us, pose, buf.lidar_features.data());
+    });
+    if (ok[1] && ok[2]) {
+        t[3] = time_ms([&] {
+            ok[3] = fuser(buf.camera_bev_features.data(), buf.lidar_features.data(), buf.fused_features.data());
+        });
+    }
+    if (ok[1] && ok[2] && ok[3]) t[4] = time_ms([&] { ok[4] = head(buf.fused_features.data()); });
+    for (int i = 0; i < 5; ++i) {
+        if (!ok[i]) {
+            std::cerr << names[i] << " 失败，停止计时" << std::endl;
+            return false;
+        }
+    }
+
+    if (stats) {
+        double total = 0.0;
+        for (int i = 0; i < 5; ++i) {
+            (*stats)[i].samples_ms.push_back(t[i]);
+            total += t[i];
+        }
+        (*stats)[5].samples_ms.push_back(total);
+    }
+    return true;
+}
+
+// camera_backbone 的相机分组方式对比：每种分组各自预热后计时
+static int compare_camera_groups(const BenchOptions& opt, const bevfusion::FrameView& in) {
+    std::vector<float> camera_features(6 * 32 * 88 * 80);
+    std::vector<StageStats> stats;
+    for (int groups : opt.camera_groups) {
+        if (!camera_backbone_set_groups(groups)) return 1;
+        std::string name = groups == 0 ? "groups=auto" : "groups=" + std::to_string(groups);
+        StageStats s(name);
+        for (int i = 0; i < opt.warmup; ++i) camera_backbone(in.img, in.depth, camera_features.data());
+        for (int i = 0; i < opt.iters; ++i) {
+            s.samples_ms.push_back(time_ms([&] { camera_backbone(in.img, in.depth, camera_features.data()); }));
+        }
+        if (groups == 0) s.name += "(" + std::to_string(camera_backbone_groups()) + ")";
+        stats.push_back(s);
+    }
+
+    std::cout << "\n===== camera_backbone 相机分组: warmup=" << opt.warmup << " iters=" << opt.iters << " =====" << std::endl;
+    std::cout << std::left << std::setw(20) << "groups" << std::right
+              << std::setw(12) << "mean(ms)" << std::setw(12) << "min(ms)"
+              << std::setw(12) << "p50(ms)" << std::setw(12) << "max(ms)" << std::endl;
+    for (const auto& s : stats) s.print();
+    return 0;
+}
+
+// lidar_backbone 的体素存放顺序对比：每种顺序各自预热后计时，再打开剖析跑一帧
+static int compare_lidar_order(const BenchOptions& opt, const bevfusion::FrameView& in) {
+    std::vector<float> lidar_features(1 * 256 * 180 * 180);
+    std::vector<StageStats> stats;
+    for (bool morton : {false, true}) {
+        lidar_backbone_set_morton(morton);
+        lidar_backbone_set_profile(false);
+        StageStats s(morton ? "morton" : "lexicographic");
+        bool ok = true;
+        for (int i = 0; i < opt.warmup; ++i) ok &= lidar_backbone(in.points, in.num_points, lidar_features.data());
+        for (int i = 0; i < opt.iters; ++i) {
+            s.samples_ms.push_back(time_ms([&] { ok &= lidar_backbone(in.points, in.num_points, lidar_features.data()); }));
+        }
+        lidar_backbone_set_profile(true);
+        ok &= lidar_backbone(in.points, in.num_points, lidar_features.data());
+        if (!ok) return 1;
+        stats.push_back(s);
+    }
+    lidar_backbone_set_profile(false);
+    lidar_backbone_set_morton(true);
+
+    std::cout << "\n===== lidar_backbone 体素顺序: warmup=" << opt.warmup << " iters=" << opt.iters << " =====" << std::endl;
+    std::cout << std::left << std::setw(20) << "order" << std::right
+              << std::setw(12) << "mean(ms)" << std::setw(12) << "min(ms)"
+              << std::setw(12) << "p50(ms)" << std::setw(12) << "max(ms)" << std::endl;
+    for (const auto& s : stats) s.print();
+    return 0;
+}
+
+// lidar_backbone 的多线程扩展性：每种体素规模、每个线程数各自预热后计时，表中为平均耗时和相对第一列的加速比
+static int compare_lidar_scaling(const BenchOptions& opt) {
+    std::vector<float> lidar_features(1 * 256 * 180 * 180);
+    const int64_t sizes[] = {20000, 60000, 150000};
+    std::vector<std::vector<double>> mean_ms;
+    for (int64_t voxels : sizes) {
+        std::vector<float> points = make_lidar_points(voxels, opt.seed);
+        const int64_t num_points = static_cast<int64_t>(points.size() / bevfusion::kPointDim);
+        mean_ms.emplace_back();
+        for (int threads : opt.lidar_threads) {
+            lidar_backbone_set_threads(threads);
+            bool ok = true;
+            for (int i = 0; i < opt.warmup; ++i) ok &= lidar_backbone(points.data(), num_points, lidar_features.data());
+            double sum = 0.0;
+            for (int i = 0; i < opt.iters; ++i) {
+                sum += time_ms([&] { ok &= lidar_backbone(points.data(), num_points, lidar_features.data()); });
+            }
+            if (!ok) return 1;
+            mean_ms.back().push_back(sum / std::max(opt.iters, 1));
+        }
+    }
+
+    std::cout << "\n===== lidar_backbone 线程扩展性: warmup=" << opt.warmup << " iters=" << opt.iters
+              << "，mean(ms) / 加速比 =====" << std::endl;
+    std::cout << std::left << std::setw(12) << "voxels" << std::right;
+    for (int threads : opt.lidar_threads) std::cout << std::setw(18) << "threads=" + std::to_string(threads);
+    std::cout << std::endl;
+    for (size_t s = 0; s < mean_ms.size(); ++s) {
+        std::cout << std::left << std::setw(12) << sizes[s] << std::right << std::fixed;
+        for (double ms : mean_ms[s]) {
+            std::ostringstream cell;
+            cell << std::fixed << std::setprecision(1) << ms << " / " << std::setprecision(2) << mean_ms[s][0] / ms;
+            std::cout << std::setw(18) << cell.str();
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    BenchOptions opt = parse_args(argc, argv);
+    if (opt.check_kernels) {
+        bool ok = check_kernels();
+        ok &= check_sparse_gemm();
+        ok &= check_sparse_rulebooks();
+        return ok ? 0 : 1;
+    }
+    std::cout << "内核指令集: " << bevfusion::isa_name(bevfusion::active_isa()) << std::endl;
+    SyntheticInputs synthetic = make_synthetic_inputs(opt);
+
+    bevfusion::FrameArchiveReader archive;
+    std::unique_ptr<bevfusion::FrameStream> stream;
+    if (!opt.archive.empty()) {
+        if (!archive.open(opt.archive) || archive.num_frames() == 0) return 1;
+        stream.reset(new bevfusion::FrameStream(archive));
+        std::cout << "回放帧归档 " << opt.archive << " (" << archive.num_frames() << " 帧)" << std::endl;
+    }
+    auto next_frame = [&] { return stream ? stream->next() : synthetic.view(); };
+    if (!opt.camera_groups.empty()) return compare_camera_groups(opt, next_frame());
+    if (opt.lidar_profile) return compare_lidar_order(opt, next_frame());
+    if (!opt.lidar_threads.empty()) return compare_lidar_scaling(opt);
+
+    std::vector<StageStats> stats = {
+        StageStats("camera_backbone"), StageStats("camera_vtransform"), StageStats("lidar_backbone"),
+        StageStats("fuser"), StageStats("head"), StageStats("end_to_end"),
+    };
+
+    StageBuffers buffers;
+    for (int i = 0; i < opt.warmup; ++i) {
+        std::cout << "预热帧 " << i + 1 << "/" << opt.warmup << std::endl;
+        if (!run_frame(next_frame(), buffers, nullptr)) return 1;
+    }
+    for (int i = 0; i < opt.iters; ++i) {
+        std::cout << "计时帧 " << i + 1 << "/" << opt.iters << std::endl;
+        if (!run_frame(next_frame(), buffers, &stats)) return 1;
+    }
+
+    std::cout << "\n===== BEVfusion bench: warmup=" << opt.warmup << " iters=" << opt.iters << " =====" << std::endl;
+    std::cout << std::left << std::setw(20) << "stage" << std::right
+              << std::setw(12) << "mean(ms)" << std::setw(12) << "min(ms)"
+              << std::setw(12) << "p50(ms)" << std::setw(12) << "max(ms)" << std::endl;
+    for (const auto& s : stats) s.print();
+    return 0;
+}
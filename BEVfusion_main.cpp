@@ -3,6 +3,8 @@
 #include <memory>
 #include <string>
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
 // #include <torch/torch.h>
 
 // 包含各个模块的头文件
@@ -50,45 +52,44 @@ int main() {
         }
 
         // 2. 相机视角变换 (Camera VTransform)
-        float* camera_bev_features = nullptr;
+        float* camera_bev_features = new float[1*80*180*180];
         {
             std::cout << "处理相机视角变换 (6×32×88×80 -> 1×80×180×180)..." << std::endl;
-            float* camera_features_tmp = new float[1*80*360*360];
-            for(int i = 0; i < 1*80*360*360; i++){
-                camera_features_tmp[i] = 1.0f;
-            }
-            memcpy(camera_features_tmp, camera_features, 6*32*88*80*sizeof(float));
             
             // 调用相机视角变换模块
-            camera_bev_features = camera_vtransform();
-            
-            if (!camera_bev_features) {
+            if (!camera_vtransform(camera_features, camera_bev_features)) {
                 std::cerr << "相机视角变换失败!" << std::endl;
                 return 1;
             }
-            delete[] camera_features_tmp;
         }
 
         // 3. LiDAR骨干网络 (LiDAR Backbone)
-        float* lidar_features = nullptr;
+        float* lidar_features = new float[1*256*180*180];
         {
             std::cout << " 处理LiDAR骨干网络 (1×5 -> 1×256×180×180)..." << std::endl;
+            float* input = new float[3 * 5];
+            for(int i = 0; i < 3 * 5; i++){
+                input[i] = 1.0f;
+            }
             
             // 调用LiDAR骨干网络
-            lidar_features = lidar_backbone();
-            
-            if (!lidar_features) {
-                std::cerr << "LiDAR骨干网络处理失败!" << std::endl;
+            bool ok = lidar_backbone(input, 3, lidar_features);
+            delete[] input;
+            if (!ok) {
+                std::cerr << "LiDAR骨干网络失败!" << std::endl;
                 return 1;
             }
         }
 
         // 4. 特征融合 (Fuser)
-        float *fused_features = nullptr;
+        float *fused_features = new float[1*512*180*180];
         {
             std::cout << "处理特征融合 (1×80×180×180 + 1×256×180×180 -> 1×512×180×180)..." << std::endl;
             
-            fused_features = fuser(camera_bev_features, lidar_features);
+            if (!fuser(camera_bev_features, lidar_features, fused_features)) {
+                std::cerr << "特征融合失败!" << std::endl;
+                return 1;
+            }
         }
 
         // 5. 检测头 (Head)
@@ -100,10 +101,10 @@ int main() {
         }
 
         // 释放内存
-        if (camera_features) delete[] camera_features;
-        if (camera_bev_features) delete[] camera_bev_features;
-        if (fused_features) delete[] fused_features;
-        if (lidar_features) delete[] lidar_features;
+        delete[] camera_features;
+        delete[] camera_bev_features;
+        delete[] fused_features;
+        delete[] lidar_features;
         
 
         std::cout << " BEVfusion 推理完成!" << std::endl;
@@ -1,9 +1,44 @@
 #include <torch/torch.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+
 #include "camera_backbone.h"
-#include "pipe_comm.h"
-#include "apis_c.h"
-InterChiplet::PipeComm global_pipe_comm;
+#include "core_groups.h"
+#include "packed_snapshot.h"
+#include "pointwise_conv.h"
+#include "squeeze_excite.h"
+#include "tensor_pool.h"
+
+// 每帧的计算量统计：卷积、全连接层算完后按实际输出形状累加 2×乘加次数。分组模式下各组线程同时累加。
+// 张量内存的分配次数、字节数和峰值由 tensor_pool.h 统计
+struct CameraCost {
+    std::atomic<int64_t> flops{0};
+    std::atomic<int64_t> fpn_level_ns[4] = {};  // FPN 各层（C2~C5）的耗时，分组模式下为各组之和
+    std::atomic<int64_t> adp_ns[4] = {};        // 其中 ADP 的耗时
+
+    void begin_frame() {
+        flops = 0;
+        for (int i = 0; i < 4; ++i) fpn_level_ns[i] = adp_ns[i] = 0;
+        bevfusion::TensorPool::instance().reset_stats();
+    }
+
+    void add(int64_t layer_flops) { flops += layer_flops; }
+
+    // 卷积/全连接的权重为 [Cout, Cin/groups, ...]，每个输出元素做 weight.numel()/Cout 次乘加
+    void add_layer(const torch::Tensor& weight, const torch::Tensor& output) {
+        add(2 * (weight.numel() / weight.size(0)) * output.numel());
+    }
+};
 
+static CameraCost& camera_cost() {
+    static CameraCost cost;
+    return cost;
+}
 
 // 定义ResNet-50的Bottleneck模块
 struct BottleneckImpl : torch::nn::Module {
@@ -38,25 +73,29 @@ struct BottleneckImpl : torch::nn::Module {
     }
 
     torch::Tensor forward(torch::Tensor x) {
-        auto identity = x.clone();
+        auto identity = x;  // 只引用输入，之后各步都生成新张量，不会改写它
 
         x = conv1->forward(x);
+        camera_cost().add_layer(conv1->weight, x);
         x = bn1->forward(x);
         x = torch::relu(x);
 
         x = conv2->forward(x);
+        camera_cost().add_layer(conv2->weight, x);
         x = bn2->forward(x);
         x = torch::relu(x);
 
         x = conv3->forward(x);
+        camera_cost().add_layer(conv3->weight, x);
         x = bn3->forward(x);
 
         if (!downsample.is_empty()) {
             identity = downsample->forward(identity);
+            camera_cost().add_layer(downsample->ptr<torch::nn::Conv2dImpl>(0)->weight, identity);
         }
 
-        x += identity;
-        return torch::relu(x);
+        // 残差相加与 ReLU 合成一次就地运算，x 是 bn3 刚生成的张量，可以直接改写
+        return at::_add_relu_(x, identity);
     }
 };
 TORCH_MODULE(Bottleneck);
@@ -91,19 +130,28 @@ struct ResNet50Impl : torch::nn::Module {
         return layers;
     }
 
-    // 返回各阶段特征：[C2, C3, C4, C5]
-    std::vector<torch::Tensor> forward(torch::Tensor x) {
+    // 返回各阶段特征 [C2, C3, C4, C5] 中最高的 num_levels 层，不返回的层用完即释放
+    std::vector<torch::Tensor> forward(torch::Tensor x, int num_levels = 4) {
         x = conv1->forward(x);
+        camera_cost().add_layer(conv1->weight, x);
         x = bn1->forward(x);
         x = torch::relu(x);
         x = torch::max_pool2d(x, 3, 2, 1);  // [B, 64, 64, 64]（假设输入256x256）
 
-        auto c2 = layer1->forward(x);       // [B, 256, 64, 64]
-        auto c3 = layer2->forward(c2);      // [B, 512, 32, 32]
-        auto c4 = layer3->forward(c3);      // [B, 1024, 16, 16]
-        auto c5 = layer4->forward(c4);      // [B, 2048, 8, 8]
-
-        return {c2, c3, c4, c5};
+        std::vector<torch::Tensor> outputs;
+        auto keep = [&](int level, const torch::Tensor& c) {
+            if (level + num_levels >= 4) outputs.push_back(c);
+        };
+        x = layer1->forward(x);       // C2 [B, 256, 64, 64]
+        keep(0, x);
+        x = layer2->forward(x);       // C3 [B, 512, 32, 32]
+        keep(1, x);
+        x = layer3->forward(x);       // C4 [B, 1024, 16, 16]
+        keep(2, x);
+        x = layer4->forward(x);       // C5 [B, 2048, 8, 8]
+        keep(3, x);
+
+        return outputs;
     }
 };
 TORCH_MODULE(ResNet50);
@@ -114,6 +162,8 @@ TORCH_MODULE(ResNet50);
 struct ADPImpl : torch::nn::Module {
     torch::nn::Linear fc1{nullptr}, fc2{nullptr};
     int64_t channels;
+    bevfusion::SqueezeExcite fused;  // fc1/fc2 权重的副本，融合内核使用，前向时按需更新
+    bevfusion::PackedSnapshot fused_snapshot;
 
     // 显式定义构造函数参数
     ADPImpl(int64_t channels, int64_t reduction_ratio = 16) : channels(channels) {
@@ -122,8 +172,19 @@ struct ADPImpl : torch::nn::Module {
         fc2 = register_module("fc2", torch::nn::Linear(reduced_channels, channels));
     }
 
-    torch::Tensor forward(torch::Tensor x) {
+    // 融合内核就地缩放 x 并返回 x；use_fused 为 false 时用原来的 libtorch 算子组合，不修改 x
+    torch::Tensor forward(torch::Tensor x, bool use_fused = true) {
         auto batch_size = x.size(0);
+        camera_cost().add(2 * (fc1->weight.numel() + fc2->weight.numel()) * batch_size);
+        if (use_fused) {
+            fused_snapshot.sync({fc1->weight, fc1->bias, fc2->weight, fc2->bias}, [&] {
+                fused.reset(channels, fc1->weight.size(0), fc1->weight.data_ptr<float>(), fc1->bias.data_ptr<float>(),
+                            fc2->weight.data_ptr<float>(), fc2->bias.data_ptr<float>());
+            });
+            x = x.contiguous();
+            fused.forward(x.data_ptr<float>(), batch_size, x.size(2) * x.size(3));
+            return x;
+        }
         auto squeeze = torch::adaptive_avg_pool2d(x, {1, 1}).view({batch_size, channels});
         auto excitation = torch::relu(fc1->forward(squeeze));
         excitation = torch::sigmoid(fc2->forward(excitation)).view({batch_size, channels, 1, 1});
@@ -137,8 +198,12 @@ struct FPNWithADPImpl : torch::nn::Module {
     std::vector<torch::nn::Sequential> lateral_convs{};
     std::vector<torch::nn::Sequential> fpn_convs{};
     std::vector<ADP> adp_modules{};
+    std::vector<bevfusion::PointwiseConv> lateral_pointwise{};  // 侧边 1×1 卷积打包后的权重，前向时按需更新
+    bevfusion::PackedSnapshot lateral_snapshot;  // 各层一起打包
+    int64_t out_channels;
+    bool fused_se = true;  // false: ADP 用原来的 libtorch 算子组合（仅用于对比）
 
-    FPNWithADPImpl(std::vector<int64_t> in_channels_list, int64_t out_channels = 256) {
+    FPNWithADPImpl(std::vector<int64_t> in_channels_list, int64_t out_channels = 256) : out_channels(out_channels) {
         for (auto in_channels : in_channels_list) {
             // 侧边卷积
             auto lateral_conv = register_module(
@@ -149,6 +214,7 @@ struct FPNWithADPImpl : torch::nn::Module {
                 )
             );
             lateral_convs.push_back(lateral_conv);
+            lateral_pointwise.emplace_back();
 
             // FPN卷积
             auto fpn_conv = register_module(
@@ -169,13 +235,36 @@ struct FPNWithADPImpl : torch::nn::Module {
         }
     }
 
+    // 侧边卷积：1×1 卷积走 PointwiseConv 的 GEMM，之后的 BN 仍用 Sequential 中的模块
+    torch::Tensor lateral_forward(size_t i, const torch::Tensor& x) {
+        std::vector<torch::Tensor> weights;
+        for (auto& conv : lateral_convs) weights.push_back(conv->ptr<torch::nn::Conv2dImpl>(0)->weight);
+        lateral_snapshot.sync(weights, [&] {
+            for (size_t level = 0; level < weights.size(); ++level) {
+                const torch::Tensor& w = weights[level];
+                lateral_pointwise[level].reset(w.size(1), w.size(0), w.data_ptr<float>(), nullptr);
+            }
+        });
+        auto input = x.contiguous();
+        auto output = torch::empty({input.size(0), out_channels, input.size(2), input.size(3)}, torch::kFloat32);
+        lateral_pointwise[i].forward(input.data_ptr<float>(), input.size(0), input.size(2) * input.size(3),
+                                     output.data_ptr<float>());
+        camera_cost().add_layer(lateral_convs[i]->ptr<torch::nn::Conv2dImpl>(0)->weight, output);
+        return lateral_convs[i]->ptr<torch::nn::BatchNorm2dImpl>(1)->forward(output);
+    }
+
+    // features 为最高的若干层（最后一个是 C5），只计算这些层的 FPN 输出，返回顺序与 features 相同。
+    // 自顶向下融合时每层只依赖更高的层，调用方只用 C5 层时传入 {C5} 即可跳过下面各层的上采样和 3×3 卷积
     std::vector<torch::Tensor> forward(std::vector<torch::Tensor> features) {
         std::vector<torch::Tensor> fpn_features;
         torch::Tensor prev_feature;
+        const size_t first = lateral_convs.size() - features.size();  // features[0] 对应的层号
 
         // 自顶向下融合
         for (int i = features.size() - 1; i >= 0; i--) {
-            auto lateral_feature = lateral_convs[i]->forward(features[i]);
+            const size_t level = first + i;
+            auto level_start = std::chrono::steady_clock::now();
+            auto lateral_feature = lateral_forward(level, features[i]);
             if (i != features.size() - 1) {
                 // 修复上采样参数
                 prev_feature = torch::upsample_bilinear2d(
@@ -186,9 +275,15 @@ struct FPNWithADPImpl : torch::nn::Module {
                 lateral_feature += prev_feature;
             }
             // 修复ADP调用方式
-            prev_feature = adp_modules[i]->forward(lateral_feature);  // 直接调用forward
-            prev_feature = fpn_convs[i]->forward(prev_feature);
+            auto adp_start = std::chrono::steady_clock::now();
+            prev_feature = adp_modules[level]->forward(lateral_feature, fused_se);  // 直接调用forward
+            auto adp_end = std::chrono::steady_clock::now();
+            prev_feature = fpn_convs[level]->forward(prev_feature);
+            camera_cost().add_layer(fpn_convs[level]->ptr<torch::nn::Conv2dImpl>(0)->weight, prev_feature);
             fpn_features.insert(fpn_features.begin(), prev_feature);
+            auto level_end = std::chrono::steady_clock::now();
+            camera_cost().adp_ns[level] += std::chrono::nanoseconds(adp_end - adp_start).count();
+            camera_cost().fpn_level_ns[level] += std::chrono::nanoseconds(level_end - level_start).count();
         }
 
         return fpn_features;
@@ -202,9 +297,14 @@ struct ProjectorImpl : torch::nn::Module {
     int64_t bev_width;   // BEV网格宽度
     int64_t out_channels; // 输出特征通道数
     int64_t in_channels;  // 输入特征通道数
+    torch::Tensor conv_weight;               // 调整通道数的 1×1 卷积权重
+    bevfusion::PointwiseConv pointwise;      // conv_weight 打包后的缓存，前向时按需更新
+    bevfusion::PackedSnapshot pointwise_snapshot;
 
     ProjectorImpl(int64_t bev_height, int64_t bev_width, int64_t out_channels, int64_t in_channels) 
-        : bev_height(bev_height), bev_width(bev_width), out_channels(out_channels), in_channels(in_channels) {}
+        : bev_height(bev_height), bev_width(bev_width), out_channels(out_channels), in_channels(in_channels) {
+        conv_weight = register_parameter("conv_weight", torch::randn({out_channels, in_channels, 1, 1}));
+    }
 
     torch::Tensor forward(torch::Tensor features, torch::Tensor depth_probs) {
         auto batch_size = features.size(0); // 应该是6 (B*num_cameras)
@@ -233,17 +333,15 @@ struct ProjectorImpl : torch::nn::Module {
                 .mode(torch::kBilinear)
         ); // [B, C, H, W]
 
-        // 3. 调整通道数
-        auto conv_weight = register_parameter(
-            "conv_weight", 
-            torch::randn({out_channels, in_channels, 1, 1})
-        );
-        
-        auto output = torch::nn::functional::conv2d(
-            sampled_features,
-            conv_weight,
-            torch::nn::functional::Conv2dFuncOptions().stride(1)
-        );
+        // 3. 调整通道数：1×1 卷积走 PointwiseConv 的 GEMM
+        sampled_features = sampled_features.contiguous();
+        pointwise_snapshot.sync({conv_weight}, [&] {
+            pointwise.reset(in_channels, out_channels, conv_weight.data_ptr<float>(), nullptr);
+        });
+        auto output = torch::empty({batch_size, out_channels, bev_height, bev_width}, torch::kFloat32);
+        pointwise.forward(sampled_features.data_ptr<float>(), batch_size, bev_height * bev_width,
+                          output.data_ptr<float>());
+        camera_cost().add_layer(conv_weight, output);
 
         return output;
     }
@@ -278,6 +376,24 @@ struct BEVEncoderImpl : torch::nn::Module {
 };
 TORCH_MODULE(BEVEncoder);
 
+// CameraStream 的输出。camera_depth_weights 只在调用方需要时才展开，camera_backbone 不使用它
+struct CameraStreamOutput {
+    torch::Tensor camera_feature;  // [6, 32, 88, 80]
+    torch::Tensor depth_weights;   // [6, 1, 8, 22]
+
+    // camera_depth_weights: [6, 118, 32, 88]
+    torch::Tensor camera_depth_weights() const {
+        // 118 个深度通道相同，先在 1 个通道上插值再 expand，不物化 118 份
+        return torch::nn::functional::interpolate(
+            depth_weights,
+            torch::nn::functional::InterpolateFuncOptions()
+                .size(std::vector<int64_t>{32, 88})
+                .mode(torch::kBilinear)
+                .align_corners(true)
+        ).expand({-1, 118, -1, -1});
+    }
+};
+
 struct CameraStreamImpl : torch::nn::Module {
     ResNet50 resnet{nullptr};
     FPNWithADP fpn{nullptr};
@@ -291,6 +407,7 @@ struct CameraStreamImpl : torch::nn::Module {
     const int out_channels = 32;     // 匹配ONNX输出通道
     const int64_t bev_height = 88;   // BEV特征图高度
     const int64_t bev_width = 80;    // BEV特征图宽度
+    bool full_fpn = false;           // true: 计算全部 4 层 FPN（仅用于对比计算量）
 
     CameraStreamImpl() {
         // 调整输入通道数匹配ONNX的3通道输入
@@ -313,20 +430,15 @@ struct CameraStreamImpl : torch::nn::Module {
             BEVEncoder(/*in_channels*/256, /*out_channels*/out_channels));
     }
 
-    std::pair<torch::Tensor, torch::Tensor> forward(
-        torch::Tensor img,      // [B, 6, 3, 256, 704]
-        torch::Tensor depth     // [B, 6, 1, 256, 704]
-    ) {
-        auto batch_size = img.size(0);
-        img = img.view({batch_size * num_cameras, in_channels, img_shape[0], img_shape[1]});
-        depth = depth.view({batch_size * num_cameras, 1, img_shape[0], img_shape[1]});
-
-        // 1. 特征提取
-        auto features = resnet->forward(img); // [B*6, 2048, 8, 22]
+    // 第 1~4 步：N 个相机各自独立计算，img [N, 3, 256, 704]、depth [N, 1, 256, 704] -> [N, 32, 88, 80]
+    // 相机之间没有数据依赖，可以整批计算，也可以切成几组在不同线程上分别计算
+    torch::Tensor encode(torch::Tensor img, torch::Tensor depth, torch::Tensor* depth_weights_out = nullptr) {
+        // 1. 特征提取：只用到 FPN 的 C5 层，C2~C4 的特征不返回
+        auto features = resnet->forward(img, full_fpn ? 4 : 1); // [..., [N, 2048, 8, 22]]
         
         // 2. FPN特征融合
         auto fpn_features = fpn->forward(features);
-        auto c5_feature = fpn_features.back(); // [B*6, 256, 8, 22]
+        auto c5_feature = fpn_features.back(); // [N, 256, 8, 22]
 
         // 3. 深度处理
         auto depth_downsampled = torch::nn::functional::interpolate(
@@ -335,19 +447,31 @@ struct CameraStreamImpl : torch::nn::Module {
                 .size(std::vector<int64_t>{8, 22})
                 .mode(torch::kBilinear)
                 .align_corners(true)
-        ); // [B*6, 1, 8, 22]
+        ); // [N, 1, 8, 22]
 
         auto depth_weights = torch::sigmoid(depth_downsampled);
         auto weighted_feature = c5_feature * depth_weights;
+        if (depth_weights_out) *depth_weights_out = depth_weights;
 
         // 4. 投影到BEV空间
-        auto bev_feature = projector->forward(
-            weighted_feature,    // [B*6, 256, 8, 22]
-            depth_weights       // [B*6, 1, 8, 22]
-        ); // [B*6, 32, 88, 80]
+        return projector->forward(
+            weighted_feature,    // [N, 256, 8, 22]
+            depth_weights       // [N, 1, 8, 22]
+        ); // [N, 32, 88, 80]
+    }
+
+    CameraStreamOutput forward(
+        torch::Tensor img,      // [B, 6, 3, 256, 704]
+        torch::Tensor depth     // [B, 6, 1, 256, 704]
+    ) {
+        auto batch_size = img.size(0);
+        img = img.view({batch_size * num_cameras, in_channels, img_shape[0], img_shape[1]});
+        depth = depth.view({batch_size * num_cameras, 1, img_shape[0], img_shape[1]});
+
+        torch::Tensor depth_weights;
+        auto bev_feature = encode(img, depth, &depth_weights); // [B*6, 32, 88, 80]
 
         // 调试输出
-        std::cout << "Input feature shape: " << weighted_feature.sizes() << std::endl;
         std::cout << "Input depth shape: " << depth_weights.sizes() << std::endl;
         std::cout << "Projector output shape: " << bev_feature.sizes() << std::endl;
 
@@ -355,66 +479,168 @@ struct CameraStreamImpl : torch::nn::Module {
         // camera_feature: [6, 32, 88, 80]
         bev_feature = bev_feature.view({num_cameras, out_channels, bev_height, bev_width});
 
-        // camera_depth_weights: [6, 118, 32, 88]
-        auto depth_weights_out = depth_weights
-            .view({num_cameras, 1, 8, 22})  // 移除batch维度
-            .expand({-1, 118, -1, -1})      // 扩展到118通道
-            .permute({0, 1, 2, 3});         // 调整维度顺序
+        return {bev_feature, depth_weights.view({num_cameras, 1, 8, 22})};
+    }
+};
+TORCH_MODULE(CameraStream);
 
-        // 将深度权重调整为正确的形状 [6, 118, 32, 88]
-        depth_weights_out = torch::nn::functional::interpolate(
-            depth_weights_out,
-            torch::nn::functional::InterpolateFuncOptions()
-                .size(std::vector<int64_t>{32, 88})
-                .mode(torch::kBilinear)
-                .align_corners(true)
-        );
+namespace {
+
+constexpr int kNumCameras = 6;
+constexpr int64_t kCameraImageSize = 3 * 256 * 704;
+constexpr int64_t kCameraDepthSize = 1 * 256 * 704;
+constexpr int64_t kCameraFeatureSize = 32 * 88 * 80;
+
+// 模型只构建一次；推理模式下 BN 使用滑动统计量，每个相机的结果与同批的其他相机无关，
+// 分组计算与整批计算一致，多个线程并发调用 forward 也不会写模块状态
+CameraStream& camera_model() {
+    static CameraStream model = [] {
+        CameraStream m;
+        m->eval();
+        const char* env = std::getenv("BEVFUSION_CAMERA_FULL_FPN");
+        m->full_fpn = env && strcmp(env, "1") == 0;
+        env = std::getenv("BEVFUSION_CAMERA_FUSED_SE");
+        m->fpn->fused_se = !(env && strcmp(env, "0") == 0);
+        return m;
+    }();
+    return model;
+}
 
-        // std::cout << "Final feature shape: " << bev_feature.sizes() << std::endl;
-        // std::cout << "Final depth weights shape: " << depth_weights_out.sizes() << std::endl;
+// 计算第 first ~ first+count-1 个相机，结果写入 camera_features 的对应位置
+void encode_cameras(const float* img, const float* depth, int first, int count, float* camera_features) {
+    torch::NoGradGuard no_grad;
+    bevfusion::TensorPoolScope pool_scope;
+    // 输入可能直接指向只读的帧归档 mmap 区域，前向过程中不会写入
+    auto img_tensor = torch::from_blob(const_cast<float*>(img + first * kCameraImageSize),
+                                       {count, 3, 256, 704}, torch::kFloat);
+    auto depth_tensor = torch::from_blob(const_cast<float*>(depth + first * kCameraDepthSize),
+                                         {count, 1, 256, 704}, torch::kFloat);
+    auto feature = camera_model()->encode(img_tensor, depth_tensor).contiguous();
+    memcpy(camera_features + first * kCameraFeatureSize, feature.data_ptr<float>(),
+           count * kCameraFeatureSize * sizeof(float));
+}
+
+// 整批模式使用的 intra-op 线程数，在创建任何分组线程之前记录
+int batch_threads() {
+    static const int threads = at::get_num_threads();
+    return threads;
+}
 
-        return {bev_feature, depth_weights_out};
+// 每种分组数一个常驻线程组，组线程的 intra-op 线程数等于该组的核心数
+bevfusion::CoreGroupPool& group_pool(int groups) {
+    static std::map<int, std::unique_ptr<bevfusion::CoreGroupPool>> pools;
+    auto& pool = pools[groups];
+    if (!pool) {
+        batch_threads();
+        pool.reset(new bevfusion::CoreGroupPool(groups, [](int, int cores) {
+            at::init_num_threads();
+            at::set_num_threads(cores);
+        }));
+    }
+    return *pool;
+}
+
+void run_groups(int groups, const float* img, const float* depth, float* camera_features) {
+    if (groups == 1) {
+        at::set_num_threads(batch_threads());
+        encode_cameras(img, depth, 0, kNumCameras, camera_features);
+        return;
+    }
+    int per_group = kNumCameras / groups;
+    group_pool(groups).run([&](int g) { encode_cameras(img, depth, g * per_group, per_group, camera_features); });
+}
+
+// 用第一帧的真实输入依次测量每种分组（分组数不超过核心数），选最快的一种；
+// 返回时 camera_features 已是这一帧的有效输出
+int calibrate_groups(const float* img, const float* depth, float* camera_features) {
+    int cores = static_cast<int>(bevfusion::available_cpus().size());
+    std::vector<int> candidates;
+    for (int g : {1, 2, 3, 6}) {
+        if (g <= cores) candidates.push_back(g);
+    }
+    if (candidates.size() == 1) {
+        run_groups(1, img, depth, camera_features);
+        return 1;
     }
-};
-TORCH_MODULE(CameraStream);
 
-void camera_backbone(float* img, float* depth, float* camera_features){
-    auto img_tensor = torch::from_blob(img, {1, 6, 3, 256, 704}, torch::kFloat);
-    auto depth_tensor = torch::from_blob(depth, {1, 6, 1, 256, 704}, torch::kFloat);
-
-    CameraStream model;
-    auto [feature, depth_weights] = model->forward(img_tensor, depth_tensor);
-    std::cout << "Final feature shape: " << feature.sizes() << std::endl;
-    std::cout<< "feature: " << feature[5][31][87][79] << std::endl;
-    // 将feature转换为float*
-    float* feature_ptr = feature.data_ptr<float>();
-    std::cout << "feature_ptr: " << feature_ptr[6*32*88*80-1] << std::endl;
-    memcpy(camera_features, feature_ptr, 6*32*88*80*sizeof(float));
+    std::cout << "camera_backbone 自动选择相机分组（" << cores << " 核）:";
+    int best = 1;
+    double best_ms = 0.0;
+    for (int g : candidates) {
+        // 先跑一遍预热：组线程第一次计算时要创建卷积原语和分配工作区
+        run_groups(g, img, depth, camera_features);
+        camera_cost().begin_frame();
+        auto start = std::chrono::steady_clock::now();
+        run_groups(g, img, depth, camera_features);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << " " << g << "x" << kNumCameras / g << " " << ms << " ms;";
+        if (g == candidates.front() || ms < best_ms) {
+            best = g;
+            best_ms = ms;
+        }
+    }
+    // 各种批大小的中间张量大小都不同，选定之前的空闲块之后不会再用到
+    int64_t trimmed = bevfusion::TensorPool::instance().trim();
+    std::cout << " 选用 " << best << " 组，释放缓冲池空闲块 " << trimmed / 1048576.0 << " MB" << std::endl;
+    return best;
 }
 
-int main(int argc, char** argv) { // (0,0)
-    int idX = atoi(argv[1]);
-    int idY = atoi(argv[2]);
-    float* img = new float[1 * 6 * 3 * 256 * 704];
-    float* depth = new float[1 * 6 * 1 * 256 * 704];
-    float* camera_backbone_output = new float[6*32*88*80];
-    long long unsigned int timeNow = 1;
-    std::string fileName = InterChiplet::receiveSync(5, 5, idX, idY);
-    global_pipe_comm.read_data(fileName.c_str(), img, 6 * 3 * 256 * 704 * sizeof(float));
-    long long int time_end = InterChiplet::readSync(timeNow, 5, 5, idX, idY, 6 * 3 * 256 * 704 * sizeof(float), 0);
-    std::cout<<"--------------------------------"<<std::endl;
-    fileName = InterChiplet::receiveSync(5, 5, idX, idY);
-    global_pipe_comm.read_data(fileName.c_str(), depth, 6 * 1 * 256 * 704 * sizeof(float));
-    time_end = InterChiplet::readSync(timeNow, 5, 5, idX, idY, 6 * 1 * 256 * 704 * sizeof(float), 0);
-    std::cout<<"--------------------------------"<<std::endl;
-    camera_backbone(img, depth, camera_backbone_output);
-    fileName = InterChiplet::sendSync(idX, idY, 5, 5);
-    global_pipe_comm.write_data(fileName.c_str(), camera_backbone_output, 6 * 32 * 88 * 80 * sizeof(float));
-    time_end = InterChiplet::writeSync(time_end, idX, idY, 5, 5, 6 * 32 * 88 * 80 * sizeof(float), 0);
-    std::cout<<"--------------------------------"<<std::endl;
+int groups_from_env() {
+    const char* env = std::getenv("BEVFUSION_CAMERA_GROUPS");
+    if (!env || !*env || strcmp(env, "auto") == 0) return 0;
+    int groups = std::atoi(env);
+    if (groups > 0 && kNumCameras % groups == 0) return groups;
+    std::cerr << "BEVFUSION_CAMERA_GROUPS 取值无效: " << env << "（可选 1 / 2 / 3 / 6 / auto），使用 auto" << std::endl;
     return 0;
 }
 
+int requested_groups = groups_from_env();  // 0 表示自动
+int active_groups = 0;                     // 自动模式下校准前为 0
+
+}  // namespace
+
+bool camera_backbone_set_groups(int groups) {
+    if (groups < 0 || (groups > 0 && kNumCameras % groups != 0)) {
+        std::cerr << "camera_backbone 分组数无效: " << groups << "（可选 0 / 1 / 2 / 3 / 6）" << std::endl;
+        return false;
+    }
+    requested_groups = groups;
+    active_groups = 0;
+    return true;
+}
+
+int camera_backbone_groups() {
+    return requested_groups > 0 ? requested_groups : active_groups;
+}
+
+void camera_backbone(const float* img, const float* depth, float* camera_features){
+    camera_model();  // 第一帧构建模型，不计入本帧的峰值内存
+    CameraCost& cost = camera_cost();
+    cost.begin_frame();
+    if (requested_groups > 0) {
+        run_groups(requested_groups, img, depth, camera_features);
+    } else if (active_groups > 0) {
+        run_groups(active_groups, img, depth, camera_features);
+    } else {
+        active_groups = calibrate_groups(img, depth, camera_features);
+    }
+    std::cout << "camera_backbone: " << camera_backbone_groups() << " 组 x " << kNumCameras / camera_backbone_groups()
+              << " 相机" << std::endl;
+    std::cout << "feature: " << camera_features[kNumCameras * kCameraFeatureSize - 1] << std::endl;
+    bevfusion::TensorPool::Stats pool = bevfusion::TensorPool::instance().stats();
+    std::cout << "camera_backbone 每帧计算量 " << cost.flops / 1e9 << " GFLOP（" << (camera_model()->full_fpn ? "全部" : "仅 C5")
+              << " FPN 层），张量峰值 " << pool.peak_in_use / 1048576.0 << " MB；分配 " << pool.allocs << " 次 / "
+              << pool.bytes / 1048576.0 << " MB，其中新申请 " << pool.new_allocs << " 次 / " << pool.new_bytes / 1048576.0
+              << " MB，缓冲池共 " << pool.pooled_bytes / 1048576.0 << " MB" << std::endl;
+    std::cout << "FPN 各层耗时（其中 " << (camera_model()->fpn->fused_se ? "融合" : "libtorch") << " ADP）:";
+    for (int level = 0; level < 4; ++level) {
+        if (cost.fpn_level_ns[level] == 0) continue;
+        std::cout << " C" << level + 2 << " " << cost.fpn_level_ns[level] / 1e6 << " (" << cost.adp_ns[level] / 1e6
+                  << ") ms";
+    }
+    std::cout << std::endl;
+}
+
 // int main() {
 //     // 输入：2张256x256的RGB图像
 //     auto input = torch::randn({2, 3, 256, 256}).to(torch::kCUDA);
@@ -443,4 +669,4 @@ int main(int argc, char** argv) { // (0,0)
 //     }
 
 //     return 0;
-// }
\ No newline at end of file
+// }
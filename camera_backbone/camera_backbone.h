@@ -1,6 +1,15 @@
 #ifndef CAMERA_BACKBONE_H
 #define CAMERA_BACKBONE_H
 
-void camera_backbone(float* img, float* depth, float* camera_features);
+void camera_backbone(const float* img, const float* depth, float* camera_features);
 
-#endif
\ No newline at end of file
+// 6 个相机的分组方式：groups 组各用一个绑定到独立核心集合的线程计算 6/groups 个相机，
+// 1 为整批计算（只靠算子内部并行），0 为自动（第一帧时逐一测量 1/2/3/6 组后选最快的）。
+// 默认取环境变量 BEVFUSION_CAMERA_GROUPS（1 / 2 / 3 / 6 / auto），未设置时为自动。
+// groups 不能整除 6 时打印原因并返回 false。
+bool camera_backbone_set_groups(int groups);
+
+// 当前使用的分组数；自动模式下第一帧之前返回 0
+int camera_backbone_groups();
+
+#endif
@@ -0,0 +1,45 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "camera_backbone.h"
+#include "chiplet_link.h"
+#include "stage_pipeline.h"
+
+// shm 后端时输入、输出都直接位于共享内存槽位（见 chiplet_link.h）
+struct CameraBackboneInput {
+    bevfusion::ReceiveBuffer img;    // 1×6×3×256×704
+    bevfusion::ReceiveBuffer depth;  // 1×6×1×256×704
+};
+
+struct CameraBackboneOutput {
+    bevfusion::SendBuffer features;  // 6×32×88×80
+};
+
+// 用法: camera_backbone <idX> <idY> [帧数]
+int main(int argc, char** argv) { // (0,0)
+    int idX = atoi(argv[1]);
+    int idY = atoi(argv[2]);
+    int num_frames = argc > 3 ? atoi(argv[3]) : 1;
+    bevfusion::ChipletLink link(idX, idY);
+    if (!link.open()) return 1;
+    bevfusion::StagePipeline<CameraBackboneInput, CameraBackboneOutput> pipeline;
+    pipeline.set_cancel([&] { link.abort(); });
+    bool ok = pipeline.run(num_frames,
+        [&](CameraBackboneInput& in, int, bevfusion::RowProgress&) {
+            return in.img.receive(link, 1 * 6 * 3 * 256 * 704) && in.depth.receive(link, 1 * 6 * 1 * 256 * 704);
+        },
+        [&](const CameraBackboneInput& in, CameraBackboneOutput& out, int frame, const bevfusion::RowProgress&) {
+            std::cout << "-------------------------------- 帧 " << frame << std::endl;
+            float* features = out.features.acquire(link, 6 * 32 * 88 * 80);
+            if (!features) return false;
+            camera_backbone(in.img.data(), in.depth.data(), features);
+            in.img.release(link);
+            in.depth.release(link);
+            return true;
+        },
+        [&](const CameraBackboneOutput& out, int) {
+            return out.features.send(link);
+        });
+    pipeline.print_stats("camera_backbone");
+    return ok ? 0 : 1;
+}
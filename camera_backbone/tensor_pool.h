@@ -0,0 +1,155 @@
+#ifndef TENSOR_POOL_H
+#define TENSOR_POOL_H
+
+// camera_backbone 的 CPU 张量缓冲池
+//
+// 替换 libtorch 的 CPU 分配器。在 TensorPoolScope 作用域内（camera_backbone 的计算线程）分配的张量
+// 释放时不还给系统，而是按字节数挂回空闲链表，下一次同样大小的分配直接取用。
+// ResNet 每个 layer 内各 Bottleneck 的中间结果形状相同，帧与帧之间也相同，
+// 因此第一帧之后的分配全部命中缓冲池，不再向系统申请内存。缓冲池只增不减，形状变化后用 trim() 释放空闲块。
+// 作用域外的分配（其他阶段、OpenMP 工作线程）原样交给原来的分配器。
+
+#include <torch/torch.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace bevfusion {
+
+class TensorPool : public c10::Allocator {
+public:
+    // 每帧（或任意区间）的统计，reset_stats() 清零
+    struct Stats {
+        int64_t allocs;         // 作用域内的分配次数
+        int64_t bytes;          // 作用域内分配的总字节数
+        int64_t new_allocs;     // 其中缓冲池没有可用块、向系统新申请的次数
+        int64_t new_bytes;
+        int64_t peak_in_use;    // 同时使用中的缓冲池字节数的峰值
+        int64_t pooled_bytes;   // 缓冲池持有的全部字节（使用中 + 空闲）
+    };
+
+    // 第一次调用时安装为 CPU 分配器；缓冲池不析构，避免静态析构顺序问题
+    static TensorPool& instance() {
+        static TensorPool* pool = [] {
+            TensorPool* p = new TensorPool(c10::GetCPUAllocator());
+            c10::SetCPUAllocator(p, /*priority=*/1);
+            return p;
+        }();
+        return *pool;
+    }
+
+    // libtorch 2.3 起 allocate 不再是 const，并新增纯虚函数 copy_data；两种签名都提供，兼容新旧版本
+    c10::DataPtr allocate(size_t nbytes) const { return const_cast<TensorPool*>(this)->allocate_impl(nbytes); }
+    c10::DataPtr allocate(size_t nbytes) { return allocate_impl(nbytes); }
+    void copy_data(void* dest, const void* src, std::size_t count) const { std::memcpy(dest, src, count); }
+
+    Stats stats() const {
+        return Stats{allocs_.load(), bytes_.load(), new_allocs_.load(), new_bytes_.load(), peak_in_use_.load(),
+                     pooled_bytes_.load()};
+    }
+
+    void reset_stats() {
+        allocs_ = 0;
+        bytes_ = 0;
+        new_allocs_ = 0;
+        new_bytes_ = 0;
+        peak_in_use_ = in_use_.load();
+    }
+
+    // 把空闲链表中的块全部还给系统，返回释放的字节数；使用中的块不受影响，释放后照常回到缓冲池。
+    // 空闲链表按确切字节数挂块，换一种批大小（例如自动分组校准依次试过的 6/3/2/1）留下的块之后不会再命中，
+    // 用完这种形状后调用一次
+    int64_t trim() {
+        std::vector<Block*> blocks;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto& entry : free_) blocks.insert(blocks.end(), entry.second.begin(), entry.second.end());
+            free_.clear();
+        }
+        int64_t bytes = 0;
+        for (Block* block : blocks) {
+            bytes += block->bytes;
+            std::free(block->data);
+            delete block;
+        }
+        pooled_bytes_ -= bytes;
+        return bytes;
+    }
+
+    static bool& thread_enabled() {
+        static thread_local bool enabled = false;
+        return enabled;
+    }
+
+private:
+    struct Block {
+        void* data;
+        size_t bytes;
+    };
+
+    explicit TensorPool(c10::Allocator* fallback) : fallback_(fallback) {}
+
+    c10::DataPtr allocate_impl(size_t nbytes) {
+        if (!thread_enabled() || nbytes == 0) return fallback_->allocate(nbytes);
+        allocs_++;
+        bytes_ += nbytes;
+        Block* block = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::vector<Block*>& list = free_[nbytes];
+            if (!list.empty()) {
+                block = list.back();
+                list.pop_back();
+            }
+        }
+        if (!block) {
+            // 64 字节对齐，与 libtorch 默认分配器一致
+            void* data = std::aligned_alloc(64, (nbytes + 63) / 64 * 64);
+            if (!data) return fallback_->allocate(nbytes);
+            block = new Block{data, nbytes};
+            new_allocs_++;
+            new_bytes_ += nbytes;
+            pooled_bytes_ += nbytes;
+        }
+        int64_t in_use = in_use_ += nbytes;
+        int64_t peak = peak_in_use_.load();
+        while (in_use > peak && !peak_in_use_.compare_exchange_weak(peak, in_use)) {}
+        return c10::DataPtr(block->data, block, &TensorPool::release, c10::Device(c10::DeviceType::CPU));
+    }
+
+    static void release(void* ctx) {
+        Block* block = static_cast<Block*>(ctx);
+        TensorPool& pool = instance();
+        pool.in_use_ -= block->bytes;
+        std::lock_guard<std::mutex> lock(pool.mutex_);
+        pool.free_[block->bytes].push_back(block);
+    }
+
+    c10::Allocator* fallback_;
+    std::mutex mutex_;
+    std::unordered_map<size_t, std::vector<Block*>> free_;
+    std::atomic<int64_t> allocs_{0}, bytes_{0}, new_allocs_{0}, new_bytes_{0}, pooled_bytes_{0};
+    std::atomic<int64_t> in_use_{0}, peak_in_use_{0};
+};
+
+// 作用域内当前线程的 CPU 张量分配走缓冲池
+class TensorPoolScope {
+public:
+    TensorPoolScope() : previous_(TensorPool::thread_enabled()) {
+        TensorPool::instance();
+        TensorPool::thread_enabled() = true;
+    }
+    ~TensorPoolScope() { TensorPool::thread_enabled() = previous_; }
+
+private:
+    bool previous_;
+};
+
+}  // namespace bevfusion
+
+#endif  // TENSOR_POOL_H
@@ -16,22 +16,20 @@
 #include <stdint.h>
 #include <string.h>
 // #include <half.hpp>
-#include "readTensorFromFile.h"
 #include <iostream>
-#include <random>
-#include <ctime>
 #include <memory>
 #include "camera_vtransform.h"
-#include "pipe_comm.h"
-#include "apis_c.h"
+#include "kernels.h"
+#include "packed_snapshot.h"
+#include "pointwise_conv.h"
+#include "weight_registry.h"
 #include <torch/torch.h>
 
-InterChiplet::PipeComm global_pipe_comm;
 #define MAX(X,Y) ( X > Y ? X : Y)
 #define MIN(X,Y) ( X < Y ? X : Y)
 #define CLIP(X,L) ( MAX(MIN(X,L), -L) )
 
-// 修改ModelParams结构体，使用动态内存分配
+// 权重与中间缓冲，进程内只创建一次，各帧复用（见 model_params()）
 struct ModelParams {
     float tensor_0_weight[80][80][3][3];
     float tensor_0_bias[80];
@@ -68,7 +66,7 @@ struct ModelParams {
         return tensor_11_data[((b * 80 + c) * 180 + h) * 180 + w];
     }
     
-    // 构造函数动态分配内存
+    // 构造函数动态分配内存（make_unique<float[]> 已清零）；权重由 vtransform_weights() 读入
     ModelParams() {
         memset(tensor_0_weight, 0, sizeof(tensor_0_weight));
         memset(tensor_0_bias, 0, sizeof(tensor_0_bias));
@@ -83,13 +81,6 @@ struct ModelParams {
         tensor_9_data = std::make_unique<float[]>(1 * 80 * 180 * 180);
         tensor_10_data = std::make_unique<float[]>(1 * 80 * 180 * 180);
         tensor_11_data = std::make_unique<float[]>(1 * 80 * 180 * 180);
-        
-        // 初始化为0
-        std::fill_n(tensor_7_data.get(), 1 * 80 * 360 * 360, 0.0f);
-        std::fill_n(tensor_8_data.get(), 1 * 80 * 360 * 360, 0.0f);
-        std::fill_n(tensor_9_data.get(), 1 * 80 * 180 * 180, 0.0f);
-        std::fill_n(tensor_10_data.get(), 1 * 80 * 180 * 180, 0.0f);
-        std::fill_n(tensor_11_data.get(), 1 * 80 * 180 * 180, 0.0f);
     }
 };
 
@@ -109,6 +100,7 @@ static inline void node_Conv_0(const float* x, const float w[80][80][3][3], cons
 	 * strides: 1 1 
 	 */
 	for( uint32_t b=0; b<1; b++ ) {
+	#pragma omp parallel for
 	for( uint32_t m=0; m<80; m++) {
 		for( int32_t o0=0, i0=-1; o0<360; o0++, i0+=1) {
 		for( int32_t o1=0, i1=-1; o1<360; o1++, i1+=1) {
@@ -140,9 +132,7 @@ static inline void node_Conv_0(const float* x, const float w[80][80][3][3], cons
 static inline void node_Relu_1(const float* X, float* Y)
 {
 	/*Relu*/
-	uint32_t i;
-	for( i=0; i<10368000; i++ )
-		Y[i] = X[i] > 0 ? X[i] : 0;
+	bevfusion::relu(X, Y, 10368000);
 }
 
 /*
@@ -161,6 +151,7 @@ static inline void node_Conv_2(const float* x, const float w[80][80][3][3], cons
 	 * strides: 2 2 
 	 */
 	for( uint32_t b=0; b<1; b++ ) {
+	#pragma omp parallel for
 	for( uint32_t m=0; m<80; m++) {
 		for( int32_t o0=0, i0=-1; o0<180; o0++, i0+=2) {
 		for( int32_t o1=0, i1=-1; o1<180; o1++, i1+=2) {
@@ -193,9 +184,7 @@ static inline void node_Conv_2(const float* x, const float w[80][80][3][3], cons
 static inline void node_Relu_3(const float* X, float* Y)
 {
 	/*Relu*/
-	uint32_t i;
-	for( i=0; i<2592000; i++ )
-		Y[i] = X[i] > 0 ? X[i] : 0;
+	bevfusion::relu(X, Y, 2592000);
 }
 
 /*
@@ -214,6 +203,7 @@ static inline void node_Conv_4(const float* x, const float w[80][80][3][3], cons
 	 * strides: 1 1 
 	 */
 	for( uint32_t b=0; b<1; b++ ) {
+	#pragma omp parallel for
 	for( uint32_t m=0; m<80; m++) {
 		for( int32_t o0=0, i0=-1; o0<180; o0++, i0+=1) {
 		for( int32_t o1=0, i1=-1; o1<180; o1++, i1+=1) {
@@ -246,103 +236,58 @@ static inline void node_Conv_4(const float* x, const float w[80][80][3][3], cons
 static inline void node_Relu_5(const float* X, float* Y)
 {
 	/*Relu*/
-	uint32_t i;
-	for( i=0; i<2592000; i++ )
-		Y[i] = X[i] > 0 ? X[i] : 0;
+	bevfusion::relu(X, Y, 2592000);
 }
 
-// 初始化权重和偏置的函数
-std::shared_ptr<ModelParams> init_tensors() {
-    try {
-        std::cout << "正在加载权重文件..." << std::endl;
-        
-        auto params = std::make_shared<ModelParams>();
-        
-        //获取$BENCHMARK_ROOT/BEVfusion-code/camera_vtransform/build/0.weight.txt
-        std::string weight_path = std::string(getenv("BENCHMARK_ROOT")) + "/camera_vtransform/0.weight.txt";
-        // 初始化 tensor_0_weight
-        auto temp_0_weight = read4DTensorFromFile<80,80,3,3>(weight_path);
-        std::cout << "已加载 0.weight.txt" << std::endl;
-        for (size_t i = 0; i < 80; ++i) {
-            for (size_t j = 0; j < 80; ++j) {
-                for (size_t k = 0; k < 3; ++k) {
-                    for (size_t l = 0; l < 3; ++l) {
-                        params->tensor_0_weight[i][j][k][l] = temp_0_weight[i][j][k][l];
-                    }
-                }
-            }
-        }
-        
-        // 初始化 tensor_0_bias
-        std::string bias_path = std::string(getenv("BENCHMARK_ROOT")) + "/camera_vtransform/0.bias.txt";
-        auto temp_0_bias = read1DTensorFromFile<80>(bias_path);
-        std::cout << "已加载 0.bias.txt" << std::endl;
-        for (size_t i = 0; i < 80; ++i) {
-            params->tensor_0_bias[i] = temp_0_bias[i];
-        }
-        
-        // 初始化 tensor_3_weight
-        weight_path = std::string(getenv("BENCHMARK_ROOT")) + "/camera_vtransform/3.weight.txt";
-        auto temp_3_weight = read4DTensorFromFile<80,80,3,3>(weight_path);
-        std::cout << "已加载 3.weight.txt" << std::endl;
-        for (size_t i = 0; i < 80; ++i) {
-            for (size_t j = 0; j < 80; ++j) {
-                for (size_t k = 0; k < 3; ++k) {
-                    for (size_t l = 0; l < 3; ++l) {
-                        params->tensor_3_weight[i][j][k][l] = temp_3_weight[i][j][k][l];
-                    }
-                }
-            }
-        }
-        
-        // 初始化 tensor_3_bias
-        bias_path = std::string(getenv("BENCHMARK_ROOT")) + "/camera_vtransform/3.bias.txt";
-        auto temp_3_bias = read1DTensorFromFile<80>(bias_path);
-        std::cout << "已加载 3.bias.txt" << std::endl;
-        for (size_t i = 0; i < 80; ++i) {
-            params->tensor_3_bias[i] = temp_3_bias[i];
-        }
-        
-        // 初始化 tensor_6_weight
-        weight_path = std::string(getenv("BENCHMARK_ROOT")) + "/camera_vtransform/6.weight.txt";
-        auto temp_6_weight = read4DTensorFromFile<80,80,3,3>(weight_path);
-        std::cout << "已加载 6.weight.txt" << std::endl;
-        for (size_t i = 0; i < 80; ++i) {
-            for (size_t j = 0; j < 80; ++j) {
-                for (size_t k = 0; k < 3; ++k) {
-                    for (size_t l = 0; l < 3; ++l) {
-                        params->tensor_6_weight[i][j][k][l] = temp_6_weight[i][j][k][l];
-                    }
-                }
-            }
-        }
-        
-        // 初始化 tensor_6_bias
-        bias_path = std::string(getenv("BENCHMARK_ROOT")) + "/camera_vtransform/6.bias.txt";
-        auto temp_6_bias = read1DTensorFromFile<80>(bias_path);
-        std::cout << "已加载 6.bias.txt" << std::endl;
-        for (size_t i = 0; i < 80; ++i) {
-            params->tensor_6_bias[i] = temp_6_bias[i];
-        }
-        
-        std::cout << "所有权重和偏置加载完成" << std::endl;
-        return params;
-    } catch (const std::exception& e) {
-        std::cerr << "错误: " << e.what() << std::endl;
-        exit(1);
-    }
+// 第一次调用时创建，之后各帧复用同一份权重和中间缓冲
+static std::shared_ptr<ModelParams>& model_params() {
+    static std::shared_ptr<ModelParams> params = std::make_shared<ModelParams>();
+    return params;
 }
 
-void entry(std::shared_ptr<ModelParams>& params, float* tensor_feat_in, float* tensor_feat_out){
+// 权重登记表，文件在 $BENCHMARK_ROOT/camera_vtransform 下，读入 model_params() 的权重数组。
+// 三个卷积各一组，第一次调用时才登记，静态初始化阶段不读环境变量也不读文件
+static bevfusion::WeightRegistry& vtransform_weights() {
+    static bevfusion::WeightRegistry registry("camera_vtransform", "BENCHMARK_ROOT", "camera_vtransform");
+    static const bool registered = [] {
+        ModelParams& p = *model_params();
+        registry.add(0, "0.weight.txt", p.tensor_0_weight);
+        registry.add(0, "0.bias.txt", p.tensor_0_bias);
+        registry.add(1, "3.weight.txt", p.tensor_3_weight);
+        registry.add(1, "3.bias.txt", p.tensor_3_bias);
+        registry.add(2, "6.weight.txt", p.tensor_6_weight);
+        registry.add(2, "6.bias.txt", p.tensor_6_bias);
+        return true;
+    }();
+    (void)registered;
+    return registry;
+}
+
+void camera_vtransform_prefetch_weights() {
+    vtransform_weights().prefetch();
+}
+
+bool entry(std::shared_ptr<ModelParams>& params, float* tensor_feat_in, float* tensor_feat_out){
     float* feat_in_ptr = tensor_feat_in;
     float* feat_out_ptr = tensor_feat_out;
     
+    // 每个卷积的权重在第一次用到之前读入（已由 camera_vtransform_prefetch_weights() 在后台读取时只是等待）
+    auto require = [](int group) {
+        if (vtransform_weights().require(group)) return true;
+        std::cerr << "camera_vtransform 权重读取失败，见上方的错误信息" << std::endl;
+        return false;
+    };
+
+    if (!require(0)) return false;
     node_Conv_0(feat_in_ptr, params->tensor_0_weight, params->tensor_0_bias, params);
     node_Relu_1(params->tensor_7_data.get(), params->tensor_8_data.get());
+    if (!require(1)) return false;
     node_Conv_2(params->tensor_8_data.get(), params->tensor_3_weight, params->tensor_3_bias, params->tensor_9_data.get());
     node_Relu_3(params->tensor_9_data.get(), params->tensor_10_data.get());
+    if (!require(2)) return false;
     node_Conv_4(params->tensor_10_data.get(), params->tensor_6_weight, params->tensor_6_bias, params->tensor_11_data.get());
     node_Relu_5(params->tensor_11_data.get(), feat_out_ptr);
+    return true;
 }
 
 torch::Tensor view_transform(torch::Tensor input) {
@@ -360,32 +305,31 @@ torch::Tensor view_transform(torch::Tensor input) {
     return input; // (1, 32, 360, 360)
 }
 
-float* camera_vtransform(float *tensor_input){
+bool camera_vtransform(const float* tensor_input, float* tensor_feat_out){
     std::cout << "程序开始执行..." << std::endl;
-    torch::Tensor input = torch::from_blob(tensor_input, {6, 32, 88, 80}, torch::kFloat32);
+    // from_blob 只读使用输入，不会写回
+    torch::Tensor input = torch::from_blob(const_cast<float*>(tensor_input), {6, 32, 88, 80}, torch::kFloat32);
     torch::Tensor bev_features = view_transform(input);
     // 3. 通过 1x1 卷积调整通道数 (32 -> 80)
-    torch::nn::Conv2d conv1x1(torch::nn::Conv2dOptions(32, 80, 1));
-    bev_features = conv1x1(bev_features);
-    // 4. 形状转换 (确保符合 (1, 80, 360, 360))
-    bev_features = bev_features.view({1, 80, 360, 360});
+    // 卷积层只初始化一次，计算走 PointwiseConv 的 GEMM；与 camera_backbone 的 1×1 卷积一样在前向时按需重新打包，
+    // 权重被改写后下一帧即生效
+    static torch::nn::Conv2d conv1x1(torch::nn::Conv2dOptions(32, 80, 1));
+    static bevfusion::PointwiseConv pointwise;
+    static bevfusion::PackedSnapshot pointwise_snapshot;
+    pointwise_snapshot.sync({conv1x1->weight, conv1x1->bias}, [&] {
+        pointwise.reset(32, 80, conv1x1->weight.data_ptr<float>(), conv1x1->bias.data_ptr<float>());
+    });
+    bev_features = bev_features.contiguous();
+    torch::Tensor projected = torch::empty({1, 80, 360, 360}, torch::kFloat32);
+    pointwise.forward(bev_features.data_ptr<float>(), 1, 360 * 360, projected.data_ptr<float>());
+    // 4. 形状 (1, 80, 360, 360)
+    bev_features = projected;
     // 5. 将 torch::Tensor 转换为 float*
     float* tensor_feat_in = bev_features.data_ptr<float>();
 
         
-    // 初始化权重和偏置
-    auto params = init_tensors();
-    
-    // 使用C++的随机数生成器
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
-    
-    // 声明输入和输出张量
-    float *tensor_feat_out = (float*)malloc(1 * 80 * 180 * 180 * sizeof(float));
-    
-    // 调用处理函数
-    entry(params, tensor_feat_in, tensor_feat_out);
+    // 调用处理函数，结果直接写入调用方的输出缓冲
+    if (!entry(model_params(), tensor_feat_in, tensor_feat_out)) return false;
     
     // 打印部分结果用于验证
     std::cout << "Output tensor sample values:" << std::endl;
@@ -399,32 +343,5 @@ float* camera_vtransform(float *tensor_input){
     std::cout << "\nTensor dimensions:" << std::endl;
     std::cout << "Input tensor:  [1][80][360][360]" << std::endl;
     std::cout << "Output tensor: [1][80][180][180]" << std::endl;
-    
-    return tensor_feat_out;
+    return true;
 }
-
-int main(int argc, char** argv) {
-    int idX = atoi(argv[1]);
-    int idY = atoi(argv[2]);
-    float* tensor_feat_in = (float*)malloc(6 * 32 * 88 * 80 * sizeof(float));
-    // // 随机初始化输入数据
-    // for(int c = 0; c < 6; c++) {
-    //     for(int h = 0; h < 32; h++) {
-    //         for(int w = 0; w < 88; w++) {
-    //             for(int d = 0; d < 80; d++) {
-    //                 tensor_feat_in[((c * 32 + h) * 88 + w) * 80 + d] = 1.0f;
-    //             }
-    //         }
-    //     }
-    // }
-    long long unsigned int timeNow = 1;
-    std::string fileName = InterChiplet::receiveSync(5, 5, idX, idY);
-    global_pipe_comm.read_data(fileName.c_str(), tensor_feat_in, 6 * 32 * 88 * 80 * sizeof(float));
-    long long int time_end = InterChiplet::readSync(timeNow, 5, 5, idX, idY, 6 * 32 * 88 * 80 * sizeof(float), 0);
-    std::cout<<"--------------------------------"<<std::endl;
-    float* camera_vtransform_output = camera_vtransform(tensor_feat_in);
-    fileName = InterChiplet::sendSync(idX, idY, 5, 5);
-    global_pipe_comm.write_data(fileName.c_str(), camera_vtransform_output, 1 * 80 * 180 * 180 * sizeof(float));
-    time_end = InterChiplet::writeSync(time_end, idX, idY, 5, 5, 1 * 80 * 180 * 180 * sizeof(float), 0);
-    return 0;
-}
\ No newline at end of file
@@ -1,6 +1,10 @@
 #ifndef CAMERA_VTRANSFORM_H
 #define CAMERA_VTRANSFORM_H
 
-float* camera_vtransform(float *tensor_input);
+// tensor_input: 6×32×88×80，tensor_output: 1×80×180×180，均由调用方分配；权重读取失败时返回 false
+bool camera_vtransform(const float* tensor_input, float* tensor_output);
+
+// 在后台开始读取权重后立即返回，不调用时 camera_vtransform() 在第一次用到各卷积的权重时读取
+void camera_vtransform_prefetch_weights();
 
 #endif
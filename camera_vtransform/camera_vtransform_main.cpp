@@ -0,0 +1,44 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include "camera_vtransform.h"
+#include "chiplet_link.h"
+#include "stage_pipeline.h"
+
+struct VTransformInput {
+    bevfusion::ReceiveBuffer features;  // 6×32×88×80，shm 后端时直接位于共享内存槽位
+};
+
+struct VTransformOutput {
+    std::vector<float> bev = std::vector<float>(1 * 80 * 180 * 180);
+};
+
+// 用法: camera_vtransform <idX> <idY> [帧数]
+int main(int argc, char** argv) {
+    int idX = atoi(argv[1]);
+    int idY = atoi(argv[2]);
+    int num_frames = argc > 3 ? atoi(argv[3]) : 1;
+    bevfusion::ChipletLink link(idX, idY);
+    if (!link.open()) return 1;
+    // 等第一帧输入的同时在后台读取权重
+    camera_vtransform_prefetch_weights();
+    bevfusion::StagePipeline<VTransformInput, VTransformOutput> pipeline;
+    pipeline.set_cancel([&] { link.abort(); });
+    bool ok = pipeline.run(num_frames,
+        [&](VTransformInput& in, int, bevfusion::RowProgress&) {
+            return in.features.receive(link, 6 * 32 * 88 * 80);
+        },
+        [&](const VTransformInput& in, VTransformOutput& out, int frame, const bevfusion::RowProgress&) {
+            std::cout << "-------------------------------- 帧 " << frame << std::endl;
+            bool ok = camera_vtransform(in.features.data(), out.bev.data());
+            in.features.release(link);
+            return ok;
+        },
+        [&](const VTransformOutput& out, int frame) {
+            // 按行带发出，fuser 收到前几个行带即可开始 Conv_1
+            return bevfusion::send_bands(link, bevfusion::BandLayout{80, 180, 180}, frame, out.bev.data());
+        });
+    pipeline.print_stats("camera_vtransform");
+    return ok ? 0 : 1;
+}
@@ -1,2 +1,3 @@
 rm -rf proc*
-rm -f buffer* bench.txt
\ No newline at end of file
+rm -f buffer* bench.txt
+rm -f /dev/shm/bevfusion_*
\ No newline at end of file
@@ -0,0 +1,82 @@
+# BEVfusion 公共编译选项
+# 顶层工程和各阶段的独立工程都会 include 本文件，include_guard 保证只生效一次。
+#
+#   CMAKE_BUILD_TYPE           Release(默认) / RelWithDebInfo / Debug
+#   BEVFUSION_ARCH             native / x86-64-v3 / generic(默认)
+#   BEVFUSION_LTO              ON 时开启链接时优化
+#   BEVFUSION_KERNEL_BACKEND   scalar / openmp，各阶段默认的 onnx2c 循环后端
+#   BEVFUSION_<STAGE>_BACKEND  单独覆盖某个阶段，如 -DBEVFUSION_FUSER_BACKEND=scalar
+include_guard(GLOBAL)
+
+if(NOT CMAKE_BUILD_TYPE AND NOT CMAKE_CONFIGURATION_TYPES)
+    set(CMAKE_BUILD_TYPE Release CACHE STRING "构建类型" FORCE)
+endif()
+set_property(CACHE CMAKE_BUILD_TYPE PROPERTY STRINGS Release RelWithDebInfo Debug)
+
+set(BEVFUSION_ARCH "generic" CACHE STRING "目标指令集: native / x86-64-v3 / generic")
+set_property(CACHE BEVFUSION_ARCH PROPERTY STRINGS native x86-64-v3 generic)
+
+option(BEVFUSION_LTO "开启链接时优化 (LTO)" OFF)
+
+set(BEVFUSION_KERNEL_BACKEND "openmp" CACHE STRING "onnx2c 循环后端: scalar / openmp")
+set_property(CACHE BEVFUSION_KERNEL_BACKEND PROPERTY STRINGS scalar openmp)
+
+if(BEVFUSION_ARCH STREQUAL "native")
+    set(BEVFUSION_ARCH_FLAGS -march=native)
+elseif(BEVFUSION_ARCH STREQUAL "x86-64-v3")
+    set(BEVFUSION_ARCH_FLAGS -march=x86-64-v3)
+elseif(BEVFUSION_ARCH STREQUAL "generic")
+    set(BEVFUSION_ARCH_FLAGS "")
+else()
+    message(FATAL_ERROR "未知的 BEVFUSION_ARCH: ${BEVFUSION_ARCH}")
+endif()
+
+if(BEVFUSION_LTO)
+    include(CheckIPOSupported)
+    check_ipo_supported(RESULT BEVFUSION_LTO_SUPPORTED OUTPUT BEVFUSION_LTO_ERROR)
+    if(NOT BEVFUSION_LTO_SUPPORTED)
+        message(WARNING "编译器不支持 LTO，已忽略: ${BEVFUSION_LTO_ERROR}")
+    endif()
+endif()
+
+find_package(OpenMP)
+
+message(STATUS "BEVfusion: build=${CMAKE_BUILD_TYPE} arch=${BEVFUSION_ARCH} lto=${BEVFUSION_LTO} backend=${BEVFUSION_KERNEL_BACKEND} openmp=${OpenMP_CXX_FOUND}")
+
+# 给目标加上 ISA / LTO 选项
+function(bevfusion_target_options target)
+    if(BEVFUSION_ARCH_FLAGS)
+        target_compile_options(${target} PRIVATE ${BEVFUSION_ARCH_FLAGS})
+    endif()
+    if(BEVFUSION_LTO AND BEVFUSION_LTO_SUPPORTED)
+        set_property(TARGET ${target} PROPERTY INTERPROCEDURAL_OPTIMIZATION TRUE)
+    endif()
+endfunction()
+
+# 阶段静态库：ISA / LTO 选项 + 按后端决定是否链接 OpenMP
+# stage 为阶段名的大写形式，用于查找 BEVFUSION_<STAGE>_BACKEND
+function(bevfusion_stage_options target stage)
+    bevfusion_target_options(${target})
+
+    set(backend ${BEVFUSION_KERNEL_BACKEND})
+    if(DEFINED BEVFUSION_${stage}_BACKEND)
+        set(backend ${BEVFUSION_${stage}_BACKEND})
+    endif()
+
+    if(backend STREQUAL "openmp")
+        if(OpenMP_CXX_FOUND)
+            target_link_libraries(${target} PUBLIC OpenMP::OpenMP_CXX)
+            target_compile_definitions(${target} PRIVATE BEVFUSION_BACKEND_OPENMP)
+        else()
+            message(WARNING "${target}: 未找到 OpenMP，退回 scalar 后端")
+            set(backend scalar)
+        endif()
+    elseif(NOT backend STREQUAL "scalar")
+        message(FATAL_ERROR "${target}: 未知的后端 ${backend}")
+    endif()
+    if(backend STREQUAL "scalar")
+        # 不加 -fopenmp 时 #pragma omp 被忽略，关掉对应告警
+        target_compile_options(${target} PRIVATE -Wno-unknown-pragmas)
+    endif()
+    message(STATUS "  ${target}: backend=${backend}")
+endfunction()
@@ -0,0 +1,155 @@
+#ifndef BEVFUSION_BAND_STREAM_H
+#define BEVFUSION_BAND_STREAM_H
+
+// BEV 特征图按行带分块传输
+//
+// C×H×W 的特征图按 kBandRows 行切成若干行带，每个行带是一条消息：
+//   [BandHeader][通道 0 的 rows×W][通道 1 的 rows×W]...
+// 发送方直接从原张量逐通道取片写出，接收方逐通道读回原位，两端都不做打包拷贝。
+// 消息头带帧序号和行带序号，接收方逐条校验；每收完一个行带就更新 RowProgress，
+// 消费者（fuser 的 Conv_1、head 的 fp16 转换）可以在整帧到齐之前处理已经收到的行。
+// 主控只转发，不解析行带内容，按 BandLayout::message_bytes() 整条收发即可。
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+namespace bevfusion {
+
+constexpr uint32_t kBandMagic = 0x444e4142;  // "BAND"
+constexpr int kBandRows = 16;
+
+struct BandHeader {
+    uint32_t magic;
+    uint32_t frame;     // 帧序号
+    uint32_t band;      // 行带序号
+    uint32_t row0;      // 起始行
+    uint32_t rows;      // 本行带的行数
+    uint32_t channels;
+    uint32_t height;
+    uint32_t width;
+};
+
+// 一段连续内存，用于分段收发同一条消息
+struct IoPiece {
+    void* data;
+    size_t bytes;
+};
+
+struct BandLayout {
+    int channels;
+    int height;
+    int width;
+    int band_rows = kBandRows;
+
+    int num_bands() const { return (height + band_rows - 1) / band_rows; }
+    int row0(int band) const { return band * band_rows; }
+    int rows(int band) const { return std::min(band_rows, height - row0(band)); }
+    size_t message_bytes(int band) const {
+        return sizeof(BandHeader) + static_cast<size_t>(channels) * rows(band) * width * sizeof(float);
+    }
+    size_t max_message_bytes() const { return message_bytes(0); }
+};
+
+// 已到达的行数，接收方单调推进，消费者等待
+class RowProgress {
+public:
+    void reset() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rows_ = 0;
+        aborted_ = false;
+    }
+
+    void publish(int rows) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            rows_ = rows;
+        }
+        cv_.notify_all();
+    }
+
+    // 接收失败时唤醒所有等待者
+    void abort() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            aborted_ = true;
+        }
+        cv_.notify_all();
+    }
+
+    // 等到至少 rows 行到达；中止时返回 false
+    bool wait(int rows) const {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [&] { return aborted_ || rows_ >= rows; });
+        return rows_ >= rows;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    mutable std::condition_variable cv_;
+    int rows_ = 0;
+    bool aborted_ = false;
+};
+
+// 行带 band 的分段描述：消息头加每个通道的一段行
+inline std::vector<IoPiece> band_pieces(const BandLayout& layout, int band, BandHeader* header, float* data) {
+    std::vector<IoPiece> pieces;
+    pieces.reserve(layout.channels + 1);
+    pieces.push_back({header, sizeof(BandHeader)});
+    size_t plane = static_cast<size_t>(layout.height) * layout.width;
+    size_t bytes = static_cast<size_t>(layout.rows(band)) * layout.width * sizeof(float);
+    for (int c = 0; c < layout.channels; ++c) {
+        pieces.push_back({data + c * plane + static_cast<size_t>(layout.row0(band)) * layout.width, bytes});
+    }
+    return pieces;
+}
+
+// Link 需提供 bool send(const IoPiece*, int) 和 bool receive(const IoPiece*, int)，见 chiplet_link.h；
+// 链路失败（例如流水线失败后 abort）时返回 false
+template <typename Link>
+bool send_bands(Link& link, const BandLayout& layout, uint32_t frame, const float* data) {
+    for (int b = 0; b < layout.num_bands(); ++b) {
+        BandHeader h{kBandMagic, frame, static_cast<uint32_t>(b), static_cast<uint32_t>(layout.row0(b)),
+                     static_cast<uint32_t>(layout.rows(b)), static_cast<uint32_t>(layout.channels),
+                     static_cast<uint32_t>(layout.height), static_cast<uint32_t>(layout.width)};
+        std::vector<IoPiece> pieces = band_pieces(layout, b, &h, const_cast<float*>(data));
+        if (!link.send(pieces.data(), static_cast<int>(pieces.size()))) return false;
+    }
+    return true;
+}
+
+// 收一个行带，校验消息头；progress 非空时在校验通过后把已到达的行数推进到 progress_base + 本行带末行，
+// 多路输入共用一个进度时用 progress_base 把后到的一路排在前一路之后
+template <typename Link>
+bool receive_band(Link& link, const BandLayout& layout, uint32_t frame, int band, float* data,
+                  RowProgress* progress = nullptr, int progress_base = 0) {
+    BandHeader h;
+    std::vector<IoPiece> pieces = band_pieces(layout, band, &h, data);
+    if (!link.receive(pieces.data(), static_cast<int>(pieces.size()))) return false;
+    if (h.magic != kBandMagic || h.frame != frame || h.band != static_cast<uint32_t>(band) ||
+        h.row0 != static_cast<uint32_t>(layout.row0(band)) || h.rows != static_cast<uint32_t>(layout.rows(band)) ||
+        h.channels != static_cast<uint32_t>(layout.channels) || h.height != static_cast<uint32_t>(layout.height) ||
+        h.width != static_cast<uint32_t>(layout.width)) {
+        std::cerr << "行带消息不匹配: 期望帧 " << frame << " 行带 " << band << "，收到帧 " << h.frame << " 行带 "
+                  << h.band << " (" << h.channels << "×" << h.rows << "×" << h.width << ")" << std::endl;
+        return false;
+    }
+    if (progress) progress->publish(progress_base + layout.row0(band) + layout.rows(band));
+    return true;
+}
+
+template <typename Link>
+bool receive_bands(Link& link, const BandLayout& layout, uint32_t frame, float* data, RowProgress* progress = nullptr) {
+    for (int b = 0; b < layout.num_bands(); ++b) {
+        if (!receive_band(link, layout, frame, b, data, progress)) return false;
+    }
+    return true;
+}
+
+}  // namespace bevfusion
+
+#endif  // BEVFUSION_BAND_STREAM_H
@@ -0,0 +1,197 @@
+#ifndef BEVFUSION_CHIPLET_LINK_H
+#define BEVFUSION_CHIPLET_LINK_H
+
+// 本 chiplet 与对端（阶段进程的对端是主控 (5,5)，主控的对端是各阶段）之间的收发
+//
+// 只能在一个线程里使用：握手命令和应答共用进程的标准输入输出，并且会阻塞到对端就绪。
+// StagePipeline 的 I/O 线程按固定顺序交替收发，见 stage_pipeline.h。例外是不握手的 acquire_send / release_slot
+// （计算线程取得写结果的槽位、归还读完的槽位）和 abort()：流水线失败时由其他线程调用，
+// 让阻塞在数据传输上的 I/O 线程返回（已经在握手里等待的只能等对端或进程退出）。
+// 数据经哪种后端传输由 BEVFUSION_TRANSPORT 决定，见 transport.h。
+//
+// 整块消息（相机图像、相机特征、点云）用下面的 SendBuffer / ReceiveBuffer 收发：shm 后端时计算直接写进、读自共享内存槽位，
+// 管道后端时落到自有内存。行带消息（band_stream.h）按通道分段、与张量的内存布局不同，仍用拷贝接口。
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "apis_c.h"
+#include "band_stream.h"
+#include "transport.h"
+
+namespace bevfusion {
+
+class ChipletLink {
+public:
+    ChipletLink(int idX, int idY, int hostX = 5, int hostY = 5)
+        : idX_(idX), idY_(idY), hostX_(hostX), hostY_(hostY), transport_(make_transport()) {}
+
+    // 在第一次收发之前调用，准备两个方向的通道
+    bool open() { return transport_->attach(inbound()) && transport_->attach(outbound()); }
+
+    // 以下收发在 abort() 之后返回 false（不再发起新的握手），数据不完整
+
+    // 从对端接收 bytes 字节到 data
+    bool receive(void* data, size_t bytes) {
+        IoPiece piece{data, bytes};
+        return receive(&piece, 1);
+    }
+
+    // 把 data 的 bytes 字节发给对端
+    bool send(const void* data, size_t bytes) {
+        IoPiece piece{const_cast<void*>(data), bytes};
+        return send(&piece, 1);
+    }
+
+    // 一条消息分段读入多块内存（一次握手，按顺序逐段读取）
+    bool receive(const IoPiece* pieces, int count) {
+        if (aborted_) return false;
+        std::string file_name = InterChiplet::receiveSync(hostX_, hostY_, idX_, idY_);
+        if (!transport_->read(file_name, inbound(), pieces, count)) return false;
+        time_end_ = InterChiplet::readSync(kTimeNow, hostX_, hostY_, idX_, idY_, total_bytes(pieces, count), 0);
+        return true;
+    }
+
+    // 多块内存依次写出为一条消息
+    bool send(const IoPiece* pieces, int count) {
+        if (aborted_) return false;
+        std::string file_name = InterChiplet::sendSync(idX_, idY_, hostX_, hostY_);
+        if (!transport_->write(file_name, outbound(), pieces, count)) return false;
+        time_end_ = InterChiplet::writeSync(time_end_, idX_, idY_, hostX_, hostY_, total_bytes(pieces, count), 0);
+        return true;
+    }
+
+    // 从本链路的对端收一条 bytes 字节的消息，原样发给 to 的对端（主控转发行带用，不落到本进程的缓冲里）
+    bool forward(ChipletLink& to, size_t bytes) {
+        if (aborted_ || to.aborted_) return false;
+        std::string in_file = InterChiplet::receiveSync(hostX_, hostY_, idX_, idY_);
+        std::string out_file = InterChiplet::sendSync(to.idX_, to.idY_, to.hostX_, to.hostY_);
+        if (!transport_->forward(in_file, inbound(), *to.transport_, out_file, to.outbound(), bytes)) return false;
+        time_end_ = InterChiplet::readSync(kTimeNow, hostX_, hostY_, idX_, idY_, bytes, 0);
+        to.time_end_ = InterChiplet::writeSync(time_end_, to.idX_, to.idY_, to.hostX_, to.hostY_, bytes, 0);
+        return true;
+    }
+
+    // 零拷贝收发：shm 后端且消息不超过一个槽位时可用，否则用上面的 send/receive
+    bool zero_copy(size_t bytes) const { return bytes > 0 && bytes <= transport_->slot_bytes(); }
+
+    // 取得下一条发出消息的槽位，不握手，可在计算线程调用；之后由 I/O 线程 send_slot 发出
+    bool acquire_send(ShmSlot* slot) { return !aborted_ && transport_->acquire_send(outbound(), slot); }
+
+    bool send_slot(const ShmSlot& slot, size_t bytes) {
+        if (aborted_) return false;
+        std::string file_name = InterChiplet::sendSync(idX_, idY_, hostX_, hostY_);
+        if (!transport_->commit_send(file_name, outbound(), slot, bytes)) return false;
+        time_end_ = InterChiplet::writeSync(time_end_, idX_, idY_, hostX_, hostY_, bytes, 0);
+        return true;
+    }
+
+    // 握手后取得下一条消息所在的槽位，长度须为 bytes；读完用 release_slot 归还（可在计算线程调用）
+    bool receive_slot(size_t bytes, ShmSlot* slot) {
+        if (aborted_) return false;
+        std::string file_name = InterChiplet::receiveSync(hostX_, hostY_, idX_, idY_);
+        if (!transport_->acquire_receive(file_name, inbound(), slot)) return false;
+        if (slot->bytes != bytes) {
+            std::cerr << "共享内存槽位中的消息为 " << slot->bytes << " 字节，期望 " << bytes << " 字节" << std::endl;
+            transport_->release_receive(inbound(), *slot);
+            return false;
+        }
+        time_end_ = InterChiplet::readSync(kTimeNow, hostX_, hostY_, idX_, idY_, bytes, 0);
+        return true;
+    }
+
+    void release_slot(const ShmSlot& slot) { transport_->release_receive(inbound(), slot); }
+
+    // 可从其他线程调用：之后的收发立即失败，正阻塞在共享内存环上的收发随即返回
+    void abort() {
+        aborted_ = true;
+        transport_->abort();
+    }
+
+private:
+    static constexpr long long unsigned int kTimeNow = 1;
+
+    Route inbound() const { return Route{hostX_, hostY_, idX_, idY_}; }
+    Route outbound() const { return Route{idX_, idY_, hostX_, hostY_}; }
+
+    static size_t total_bytes(const IoPiece* pieces, int count) {
+        size_t bytes = 0;
+        for (int i = 0; i < count; ++i) bytes += pieces[i].bytes;
+        return bytes;
+    }
+
+    int idX_, idY_, hostX_, hostY_;
+    long long int time_end_ = 0;  // 最近一次握手返回的时间
+    std::unique_ptr<Transport> transport_;
+    std::atomic<bool> aborted_{false};
+};
+
+// 一条整块 float 消息的接收缓冲：零拷贝时直接指向共享内存槽位，计算读完后 release() 归还；否则收进自有内存（容量只增不减）
+class ReceiveBuffer {
+public:
+    bool receive(ChipletLink& link, size_t count) {
+        const size_t bytes = count * sizeof(float);
+        count_ = count;
+        in_slot_ = false;
+        if (link.zero_copy(bytes)) {
+            if (!link.receive_slot(bytes, &slot_)) return false;
+            in_slot_ = true;
+            data_ = static_cast<const float*>(slot_.data);
+            return true;
+        }
+        if (storage_.size() < count) storage_.resize(count);
+        data_ = storage_.data();
+        return link.receive(storage_.data(), bytes);
+    }
+
+    const float* data() const { return data_; }
+    size_t size() const { return count_; }
+
+    // 计算线程读完本帧后调用
+    void release(ChipletLink& link) const {
+        if (in_slot_) link.release_slot(slot_);
+    }
+
+private:
+    std::vector<float> storage_;
+    const float* data_ = nullptr;
+    size_t count_ = 0;
+    ShmSlot slot_;
+    bool in_slot_ = false;
+};
+
+// 一条整块 float 消息的发送缓冲：零拷贝时计算结果直接写进共享内存槽位，否则写进自有内存
+class SendBuffer {
+public:
+    // 计算线程调用，返回本帧结果的写入位置；链路已中止时返回 nullptr
+    float* acquire(ChipletLink& link, size_t count) {
+        count_ = count;
+        in_slot_ = false;
+        if (link.zero_copy(count * sizeof(float))) {
+            if (!link.acquire_send(&slot_)) return nullptr;
+            in_slot_ = true;
+            return static_cast<float*>(slot_.data);
+        }
+        if (storage_.size() < count) storage_.resize(count);
+        return storage_.data();
+    }
+
+    // I/O 线程调用
+    bool send(ChipletLink& link) const {
+        const size_t bytes = count_ * sizeof(float);
+        return in_slot_ ? link.send_slot(slot_, bytes) : link.send(storage_.data(), bytes);
+    }
+
+private:
+    std::vector<float> storage_;
+    size_t count_ = 0;
+    ShmSlot slot_;
+    bool in_slot_ = false;
+};
+
+}  // namespace bevfusion
+
+#endif  // BEVFUSION_CHIPLET_LINK_H
@@ -0,0 +1,119 @@
+#ifndef BEVFUSION_CORE_GROUPS_H
+#define BEVFUSION_CORE_GROUPS_H
+
+// 按核心集合划分的常驻线程组
+//
+// 把本进程可用的 CPU（sched_getaffinity）平均切成 groups 份，每份一个常驻线程并绑定到这份核心上。
+// 线程启动时先调用 init(g, cores)，调用方在这里设置该线程的 intra-op 线程数（如 at::set_num_threads），
+// 之后该线程派生的 OpenMP 线程继承同样的绑核掩码，各组的算子只在自己的核心上并行，互不争抢。
+// 可用核心少于组数时不绑核，每组 1 个线程。
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace bevfusion {
+
+// 本进程允许运行的 CPU 编号
+inline std::vector<int> available_cpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; ++c) {
+            if (CPU_ISSET(c, &set)) cpus.push_back(c);
+        }
+    }
+    if (cpus.empty()) {
+        for (unsigned c = 0; c < std::max(1u, std::thread::hardware_concurrency()); ++c) cpus.push_back(c);
+    }
+    return cpus;
+}
+
+class CoreGroupPool {
+public:
+    // init 在每个组线程开始时调用一次，cores 为该组的核心数
+    CoreGroupPool(int groups, std::function<void(int group, int cores)> init) : groups_(groups) {
+        std::vector<int> cpus = available_cpus();
+        int per_group = static_cast<int>(cpus.size()) / groups;
+        pinned_ = per_group >= 1;
+        cores_ = std::max(per_group, 1);
+        for (int g = 0; g < groups; ++g) {
+            std::vector<int> mine;
+            if (pinned_) mine.assign(cpus.begin() + g * per_group, cpus.begin() + (g + 1) * per_group);
+            threads_.emplace_back([this, g, mine, init] { worker(g, mine, init); });
+        }
+    }
+
+    ~CoreGroupPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (std::thread& t : threads_) t.join();
+    }
+
+    CoreGroupPool(const CoreGroupPool&) = delete;
+    CoreGroupPool& operator=(const CoreGroupPool&) = delete;
+
+    int groups() const { return groups_; }
+    int cores_per_group() const { return cores_; }
+    bool pinned() const { return pinned_; }
+
+    // 每组线程各执行一次 fn(g)，全部完成后返回；不可重入
+    void run(const std::function<void(int group)>& fn) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        fn_ = &fn;
+        pending_ = groups_;
+        generation_++;
+        cv_.notify_all();
+        done_cv_.wait(lock, [&] { return pending_ == 0; });
+        fn_ = nullptr;
+    }
+
+private:
+    void worker(int g, const std::vector<int>& cpus, const std::function<void(int, int)>& init) {
+        if (!cpus.empty()) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int c : cpus) CPU_SET(c, &set);
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        }
+        if (init) init(g, cores_);
+        unsigned long seen = 0;
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            cv_.wait(lock, [&] { return stop_ || generation_ != seen; });
+            if (stop_) return;
+            seen = generation_;
+            const std::function<void(int)>* fn = fn_;
+            lock.unlock();
+            (*fn)(g);
+            lock.lock();
+            if (--pending_ == 0) done_cv_.notify_one();
+        }
+    }
+
+    int groups_;
+    int cores_ = 1;
+    bool pinned_ = false;
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable done_cv_;
+    const std::function<void(int)>* fn_ = nullptr;
+    unsigned long generation_ = 0;
+    int pending_ = 0;
+    bool stop_ = false;
+};
+
+}  // namespace bevfusion
+
+#endif  // BEVFUSION_CORE_GROUPS_H
@@ -0,0 +1,72 @@
+#include "cpu_dispatch.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace bevfusion {
+
+IsaLevel detected_isa() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return IsaLevel::AVX512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("f16c"))
+        return IsaLevel::AVX2;
+    if (__builtin_cpu_supports("sse4.2")) return IsaLevel::SSE4;
+#endif
+    return IsaLevel::Scalar;
+}
+
+bool isa_compiled(IsaLevel level) {
+#ifdef BEVFUSION_X86_KERNELS
+    (void)level;
+    return true;
+#else
+    return level == IsaLevel::Scalar;
+#endif
+}
+
+const char* isa_name(IsaLevel level) {
+    switch (level) {
+        case IsaLevel::Scalar: return "scalar";
+        case IsaLevel::SSE4: return "sse4";
+        case IsaLevel::AVX2: return "avx2";
+        case IsaLevel::AVX512: return "avx512";
+    }
+    return "unknown";
+}
+
+bool parse_isa(const char* name, IsaLevel* level) {
+    for (IsaLevel l : {IsaLevel::Scalar, IsaLevel::SSE4, IsaLevel::AVX2, IsaLevel::AVX512}) {
+        if (std::strcmp(name, isa_name(l)) == 0) {
+            *level = l;
+            return true;
+        }
+    }
+    return false;
+}
+
+static IsaLevel resolve_active_isa() {
+    IsaLevel level = detected_isa();
+    if (!isa_compiled(level)) level = IsaLevel::Scalar;
+
+    const char* env = std::getenv("BEVFUSION_ISA");
+    if (env && *env) {
+        IsaLevel forced;
+        if (!parse_isa(env, &forced)) {
+            std::cerr << "BEVFUSION_ISA 取值无效: " << env << "，可选 scalar/sse4/avx2/avx512" << std::endl;
+        } else if (forced > level) {
+            std::cerr << "BEVFUSION_ISA=" << env << " 超出本机支持的 " << isa_name(level) << "，忽略" << std::endl;
+        } else {
+            level = forced;
+        }
+    }
+    return level;
+}
+
+IsaLevel active_isa() {
+    static const IsaLevel level = resolve_active_isa();
+    return level;
+}
+
+}  // namespace bevfusion
@@ -0,0 +1,35 @@
+#ifndef CPU_DISPATCH_H
+#define CPU_DISPATCH_H
+
+// 运行时 CPU 特性检测
+//
+// 同一份二进制会部署到不同型号的主机上，手写的向量化内核不能依赖编译期的 -march，
+// 而是在启动时用 cpuid 检测当前 CPU 支持的最高指令集，再从内核函数表（kernels.h）中选取对应实现。
+// 环境变量 BEVFUSION_ISA=scalar|sse4|avx2|avx512 可以强制降到指定等级（不会高于检测结果），便于测试。
+
+namespace bevfusion {
+
+enum class IsaLevel {
+    Scalar = 0,
+    SSE4 = 1,    // SSE4.1 / SSE4.2
+    AVX2 = 2,    // AVX2 + FMA + F16C
+    AVX512 = 3,  // AVX-512F
+};
+
+// 当前 CPU 支持的最高等级
+IsaLevel detected_isa();
+
+// 实际使用的等级：detected_isa() 与 BEVFUSION_ISA 取较低者，首次调用后固定
+IsaLevel active_isa();
+
+// 本次编译是否包含该等级的内核实现（非 x86 平台只有 Scalar）
+bool isa_compiled(IsaLevel level);
+
+const char* isa_name(IsaLevel level);
+
+// 解析 "scalar" / "sse4" / "avx2" / "avx512"，失败返回 false
+bool parse_isa(const char* name, IsaLevel* level);
+
+}  // namespace bevfusion
+
+#endif  // CPU_DISPATCH_H
@@ -0,0 +1,332 @@
+#ifndef FRAME_ARCHIVE_H
+#define FRAME_ARCHIVE_H
+
+// 录制帧归档 (.bfa) 的读写
+//
+// 文件布局（所有偏移按 4096 对齐，mmap 后可直接当 float* 使用）:
+//   [FrameArchiveHeader]
+//   [帧 0 payload][帧 1 payload]...
+//   [FrameIndexEntry × num_frames]
+// 每帧 payload:
+//   img    1×6×3×256×704 float
+//   depth  1×6×1×256×704 float
+//   calib  FrameCalib
+//   points N×5 float (x, y, z, intensity, time_lag)，与 nuScenes .pcd.bin 一致
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bevfusion {
+
+constexpr uint32_t kFrameArchiveMagic = 0x41464542;  // "BEFA"
+constexpr uint32_t kFrameArchiveVersion = 1;
+constexpr uint64_t kFrameArchiveAlign = 4096;
+
+constexpr int kNumCameras = 6;
+constexpr size_t kImgElems = 1 * 6 * 3 * 256 * 704;
+constexpr size_t kDepthElems = 1 * 6 * 1 * 256 * 704;
+constexpr int kPointDim = 5;
+
+// 每帧标定，矩阵均为行主序 4×4
+struct FrameCalib {
+    float camera_intrinsics[kNumCameras][16];
+    float camera2lidar[kNumCameras][16];
+    float lidar2ego[16];
+    float ego2global[16];
+};
+
+struct FrameArchiveHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t num_frames;
+    uint64_t index_offset;
+};
+
+struct FrameIndexEntry {
+    uint64_t offset;        // payload 起始偏移
+    uint64_t num_points;
+    uint64_t timestamp_us;
+};
+
+// 主控发给 LiDAR chiplet 的消息头，随后是 num_points×5 个 float
+struct LidarFrameHeader {
+    uint64_t num_points;
+    uint64_t timestamp_us;
+    float lidar2global[16];   // 本帧 LiDAR 到全局坐标系，多帧合并时用于运动补偿
+};
+
+// 指向 mmap 区域内某一帧的只读视图
+struct FrameView {
+    const float* img = nullptr;
+    const float* depth = nullptr;
+    const FrameCalib* calib = nullptr;
+    const float* points = nullptr;
+    uint64_t num_points = 0;
+    uint64_t timestamp_us = 0;
+};
+
+inline uint64_t align_up(uint64_t v, uint64_t a) { return (v + a - 1) / a * a; }
+
+inline uint64_t frame_payload_bytes(uint64_t num_points) {
+    return (kImgElems + kDepthElems) * sizeof(float) + sizeof(FrameCalib) + num_points * kPointDim * sizeof(float);
+}
+
+inline void set_identity(float m[16]) {
+    for (int i = 0; i < 16; ++i) m[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+}
+
+// LiDAR 到全局坐标系的位姿 ego2global · lidar2ego；没有标定时为单位矩阵
+inline void lidar_pose(const FrameCalib* calib, float pose[16]) {
+    if (!calib) {
+        set_identity(pose);
+        return;
+    }
+    for (int r = 0; r < 4; ++r) {
+        for (int c = 0; c < 4; ++c) {
+            float v = 0.0f;
+            for (int k = 0; k < 4; ++k) v += calib->ego2global[r * 4 + k] * calib->lidar2ego[k * 4 + c];
+            pose[r * 4 + c] = v;
+        }
+    }
+}
+
+class FrameArchiveReader {
+public:
+    FrameArchiveReader() = default;
+    FrameArchiveReader(const FrameArchiveReader&) = delete;
+    FrameArchiveReader& operator=(const FrameArchiveReader&) = delete;
+    ~FrameArchiveReader() { close(); }
+
+    bool open(const std::string& path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "无法打开帧归档: " << path << std::endl;
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) < sizeof(FrameArchiveHeader)) {
+            std::cerr << "帧归档大小无效: " << path << std::endl;
+            ::close(fd);
+            return false;
+        }
+        size_ = static_cast<uint64_t>(st.st_size);
+        void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            std::cerr << "mmap 帧归档失败: " << path << std::endl;
+            return false;
+        }
+        base_ = static_cast<const uint8_t*>(p);
+        madvise(const_cast<uint8_t*>(base_), size_, MADV_SEQUENTIAL);
+
+        header_ = reinterpret_cast<const FrameArchiveHeader*>(base_);
+        if (header_->magic != kFrameArchiveMagic || header_->version != kFrameArchiveVersion ||
+            header_->index_offset + header_->num_frames * sizeof(FrameIndexEntry) > size_) {
+            std::cerr << "帧归档格式错误: " << path << std::endl;
+            close();
+            return false;
+        }
+        index_ = reinterpret_cast<const FrameIndexEntry*>(base_ + header_->index_offset);
+        for (uint64_t i = 0; i < header_->num_frames; ++i) {
+            if (index_[i].offset + frame_payload_bytes(index_[i].num_points) > size_) {
+                std::cerr << "帧归档第 " << i << " 帧越界: " << path << std::endl;
+                close();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void close() {
+        if (base_) munmap(const_cast<uint8_t*>(base_), size_);
+        base_ = nullptr;
+        header_ = nullptr;
+        index_ = nullptr;
+        size_ = 0;
+    }
+
+    bool is_open() const { return base_ != nullptr; }
+    size_t num_frames() const { return header_ ? header_->num_frames : 0; }
+
+    FrameView frame(size_t i) const {
+        FrameView v;
+        const FrameIndexEntry& e = index_[i];
+        const uint8_t* p = base_ + e.offset;
+        v.img = reinterpret_cast<const float*>(p);
+        p += kImgElems * sizeof(float);
+        v.depth = reinterpret_cast<const float*>(p);
+        p += kDepthElems * sizeof(float);
+        v.calib = reinterpret_cast<const FrameCalib*>(p);
+        p += sizeof(FrameCalib);
+        v.points = reinterpret_cast<const float*>(p);
+        v.num_points = e.num_points;
+        v.timestamp_us = e.timestamp_us;
+        return v;
+    }
+
+    // 通知内核异步预读第 i 帧
+    void advise_willneed(size_t i) const {
+        const FrameIndexEntry& e = index_[i];
+        uint64_t begin = e.offset / kFrameArchiveAlign * kFrameArchiveAlign;
+        uint64_t end = e.offset + frame_payload_bytes(e.num_points);
+        madvise(const_cast<uint8_t*>(base_ + begin), end - begin, MADV_WILLNEED);
+    }
+
+    // 逐页触碰第 i 帧，确保其已驻留内存
+    uint64_t touch(size_t i) const {
+        const FrameIndexEntry& e = index_[i];
+        const volatile uint8_t* p = base_ + e.offset;
+        uint64_t bytes = frame_payload_bytes(e.num_points);
+        uint64_t sum = 0;
+        for (uint64_t off = 0; off < bytes; off += kFrameArchiveAlign) sum += p[off];
+        return sum;
+    }
+
+private:
+    const uint8_t* base_ = nullptr;
+    uint64_t size_ = 0;
+    const FrameArchiveHeader* header_ = nullptr;
+    const FrameIndexEntry* index_ = nullptr;
+};
+
+// 按顺序（循环）读取归档中的帧，后台线程提前把后续 readahead 帧读入页缓存，
+// 使消费者拿到 FrameView 时不会因缺页阻塞在磁盘 I/O 上
+class FrameStream {
+public:
+    FrameStream(const FrameArchiveReader& reader, size_t readahead = 2)
+        : reader_(reader), readahead_(readahead) {
+        worker_ = std::thread([this] { prefetch_loop(); });
+    }
+
+    ~FrameStream() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        worker_.join();
+    }
+
+    FrameView next() {
+        size_t cur;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cur = cursor_++ % reader_.num_frames();
+        }
+        cv_.notify_all();
+        return reader_.frame(cur);
+    }
+
+private:
+    void prefetch_loop() {
+        size_t n = reader_.num_frames();
+        size_t prefetched = 0;  // 已预读到的帧序号（不取模）
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stop_) {
+            size_t target = cursor_ + readahead_;
+            if (prefetched >= target) {
+                cv_.wait(lock);
+                continue;
+            }
+            size_t idx = prefetched % n;
+            lock.unlock();
+            reader_.advise_willneed(idx);
+            sink_ += reader_.touch(idx);
+            lock.lock();
+            ++prefetched;
+        }
+    }
+
+    const FrameArchiveReader& reader_;
+    size_t readahead_;
+    size_t cursor_ = 0;
+    bool stop_ = false;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread worker_;
+    std::atomic<uint64_t> sink_{0};
+};
+
+class FrameArchiveWriter {
+public:
+    ~FrameArchiveWriter() {
+        if (file_) std::fclose(file_);
+    }
+
+    bool open(const std::string& path) {
+        file_ = std::fopen(path.c_str(), "wb");
+        if (!file_) {
+            std::cerr << "无法创建帧归档: " << path << std::endl;
+            return false;
+        }
+        pos_ = 0;
+        FrameArchiveHeader h{kFrameArchiveMagic, kFrameArchiveVersion, 0, 0};
+        return write(&h, sizeof(h)) && pad_to(kFrameArchiveAlign);
+    }
+
+    bool append(const float* img, const float* depth, const FrameCalib& calib,
+                const float* points, uint64_t num_points, uint64_t timestamp_us) {
+        FrameIndexEntry e{pos_, num_points, timestamp_us};
+        bool ok = write(img, kImgElems * sizeof(float)) &&
+                  write(depth, kDepthElems * sizeof(float)) &&
+                  write(&calib, sizeof(calib)) &&
+                  write(points, num_points * kPointDim * sizeof(float)) &&
+                  pad_to(align_up(pos_, kFrameArchiveAlign));
+        if (ok) index_.push_back(e);
+        return ok;
+    }
+
+    bool finish() {
+        FrameArchiveHeader h{kFrameArchiveMagic, kFrameArchiveVersion, index_.size(), pos_};
+        bool ok = write(index_.data(), index_.size() * sizeof(FrameIndexEntry)) &&
+                  std::fseek(file_, 0, SEEK_SET) == 0 &&
+                  std::fwrite(&h, sizeof(h), 1, file_) == 1;
+        ok = (std::fclose(file_) == 0) && ok;
+        file_ = nullptr;
+        return ok;
+    }
+
+    size_t num_frames() const { return index_.size(); }
+
+private:
+    bool write(const void* data, uint64_t bytes) {
+        if (bytes && std::fwrite(data, 1, bytes, file_) != bytes) {
+            std::cerr << "写入帧归档失败" << std::endl;
+            return false;
+        }
+        pos_ += bytes;
+        return true;
+    }
+
+    bool pad_to(uint64_t target) {
+        static const char zeros[kFrameArchiveAlign] = {0};
+        while (pos_ < target) {
+            uint64_t n = std::min<uint64_t>(target - pos_, kFrameArchiveAlign);
+            if (!write(zeros, n)) return false;
+        }
+        return true;
+    }
+
+    std::FILE* file_ = nullptr;
+    uint64_t pos_ = 0;
+    std::vector<FrameIndexEntry> index_;
+};
+
+}  // namespace bevfusion
+
+#endif  // FRAME_ARCHIVE_H
@@ -0,0 +1,124 @@
+#ifndef BEVFUSION_GEMM_H
+#define BEVFUSION_GEMM_H
+
+// 单精度 GEMM: C[M×N] = A[M×K] · B[K×N]
+//
+// A、B 以任意行/列步长描述，打包成 kGemmMR / kGemmNR 宽的面板后交给 kernels() 中按指令集分派的
+// 6×16 微内核。结果不写回完整的 C，而是每算完一个 6×16 小块就交给 epilogue，
+// 由调用方决定写到哪里、顺带做哪些逐元素运算（加 bias、BN、ReLU、散射到交错位置等）。
+//
+// 本文件只有模板，编译在调用方的翻译单元里：调用方链接了 OpenMP 时按 N 方向的块并行。
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "kernels.h"
+
+namespace bevfusion {
+
+// 矩阵视图: (r, c) 处的元素为 data[r * row_stride + c * col_stride]
+struct MatrixView {
+    const float* data;
+    ptrdiff_t row_stride;
+    ptrdiff_t col_stride;
+
+    float operator()(int r, int c) const { return data[r * row_stride + c * col_stride]; }
+};
+
+// 打包后的 A：ceil(M/MR) 个面板，面板 p 中第 k 列的 MR 个元素连续存放，不足 MR 行补 0。
+// 权重固定的调用方（卷积层）可以只打包一次，之后每次前向直接复用
+struct GemmPackedA {
+    int M = 0;
+    int K = 0;
+    std::vector<float> panels;
+
+    bool empty() const { return panels.empty(); }
+};
+
+inline void gemm_pack_a(int M, int K, const MatrixView& A, GemmPackedA* packed) {
+    const int num_panels = (M + kGemmMR - 1) / kGemmMR;
+    packed->M = M;
+    packed->K = K;
+    packed->panels.assign(static_cast<size_t>(num_panels) * K * kGemmMR, 0.0f);
+    for (int p = 0; p < num_panels; ++p) {
+        float* dst = packed->panels.data() + static_cast<size_t>(p) * K * kGemmMR;
+        const int rows = std::min(kGemmMR, M - p * kGemmMR);
+        for (int k = 0; k < K; ++k) {
+            for (int i = 0; i < rows; ++i) dst[k * kGemmMR + i] = A(p * kGemmMR + i, k);
+        }
+    }
+}
+
+// B 的 [j0, j0 + cols) 列打包为 NR 宽的面板，不足 NR 列补 0
+inline void gemm_pack_b(int K, int j0, int cols, const MatrixView& B, float* packed) {
+    const int panels = (cols + kGemmNR - 1) / kGemmNR;
+    for (int q = 0; q < panels; ++q) {
+        float* dst = packed + static_cast<size_t>(q) * K * kGemmNR;
+        const int c0 = j0 + q * kGemmNR;
+        const int n = std::min(kGemmNR, cols - q * kGemmNR);
+        for (int k = 0; k < K; ++k) {
+            const float* src = B.data + k * B.row_stride + c0 * B.col_stride;
+            if (B.col_stride == 1) {
+                std::copy(src, src + n, dst + k * kGemmNR);
+            } else {
+                for (int j = 0; j < n; ++j) dst[k * kGemmNR + j] = src[j * B.col_stride];
+            }
+            std::fill(dst + k * kGemmNR + n, dst + (k + 1) * kGemmNR, 0.0f);
+        }
+    }
+}
+
+// N 方向块宽：打包后的 B 块控制在约 256 KB，留在 L2 中供整列 A 面板复用
+inline int gemm_block_cols(int K) {
+    int cols = (256 * 1024 / sizeof(float)) / std::max(K, 1);
+    cols = cols / kGemmNR * kGemmNR;
+    return std::max(cols, kGemmNR);
+}
+
+// epilogue(int row0, int col0, int rows, int cols, const float* tile, int ld_tile)
+// tile 中 (i, j) 对应 C(row0 + i, col0 + j)，只有前 rows×cols 个元素有效。
+// 不同块的 epilogue 可能在不同线程中并发调用
+template <typename Epilogue>
+void sgemm(const GemmPackedA& A, int N, const MatrixView& B, Epilogue&& epilogue) {
+    const SgemmTileFn tile_fn = kernels().sgemm_tile;
+    const int M = A.M;
+    const int K = A.K;
+    const int m_panels = (M + kGemmMR - 1) / kGemmMR;
+    const int block_cols = gemm_block_cols(K);
+    const int n_blocks = (N + block_cols - 1) / block_cols;
+
+    #pragma omp parallel
+    {
+        std::vector<float> b_packed(static_cast<size_t>(block_cols) * K);
+        alignas(64) float tile[kGemmMR * kGemmNR];
+
+        #pragma omp for schedule(dynamic)
+        for (int nb = 0; nb < n_blocks; ++nb) {
+            const int j0 = nb * block_cols;
+            const int cols = std::min(block_cols, N - j0);
+            gemm_pack_b(K, j0, cols, B, b_packed.data());
+            for (int q = 0; q * kGemmNR < cols; ++q) {
+                const float* bp = b_packed.data() + static_cast<size_t>(q) * K * kGemmNR;
+                const int nr = std::min(kGemmNR, cols - q * kGemmNR);
+                for (int p = 0; p < m_panels; ++p) {
+                    tile_fn(K, A.panels.data() + static_cast<size_t>(p) * K * kGemmMR, bp, tile);
+                    epilogue(p * kGemmMR, j0 + q * kGemmNR, std::min(kGemmMR, M - p * kGemmMR), nr, tile, kGemmNR);
+                }
+            }
+        }
+    }
+}
+
+// A 只用一次时的便捷接口
+template <typename Epilogue>
+void sgemm(int M, int N, int K, const MatrixView& A, const MatrixView& B, Epilogue&& epilogue) {
+    GemmPackedA packed;
+    gemm_pack_a(M, K, A, &packed);
+    sgemm(packed, N, B, std::forward<Epilogue>(epilogue));
+}
+
+}  // namespace bevfusion
+
+#endif  // BEVFUSION_GEMM_H
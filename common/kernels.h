@@ -0,0 +1,60 @@
+#ifndef BEVFUSION_KERNELS_H
+#define BEVFUSION_KERNELS_H
+
+// 按指令集分派的手写内核
+//
+// 每个内核族在 KernelTable 里占一个函数指针，各等级的实现分别放在
+// kernels_<isa>.cpp 中，用对应的 -m 选项单独编译。高等级的表先拷贝低一级的表，
+// 再覆盖自己实现了的条目，因此某个等级没有专门实现的内核会自动沿用下一级的版本。
+//
+// 新增内核族：在 KernelTable 中加一项，在 kernels_scalar.cpp 中给出参考实现，
+// 再按需在更高等级的文件里覆盖，并在 bevfusion_bench --check-kernels 中加上对比。
+
+#include <cstddef>
+#include <cstdint>
+
+#include "cpu_dispatch.h"
+
+namespace bevfusion {
+
+// y[i] = max(x[i], 0)，NaN 输出 0；x 与 y 可以是同一块内存
+using ReluFn = void (*)(const float* x, float* y, size_t n);
+// float32 -> IEEE 754 float16 位模式，就近舍入到偶数，溢出为 Inf，保留 NaN
+using F32ToF16Fn = void (*)(const float* x, uint16_t* y, size_t n);
+// GEMM 微内核: c[6×16] = Σ_p a[p*6 + i] * b[p*16 + j]，a/b 为 gemm.h 打包后的面板，c 被覆盖
+using SgemmTileFn = void (*)(int k, const float* a, const float* b, float* c);
+
+constexpr int kGemmMR = 6;
+constexpr int kGemmNR = 16;
+
+struct KernelTable {
+    IsaLevel level;
+    ReluFn relu;
+    F32ToF16Fn f32_to_f16;
+    SgemmTileFn sgemm_tile;
+};
+
+// 当前 active_isa() 对应的表
+const KernelTable& kernels();
+
+// 指定等级的表；该等级未编译时返回 nullptr（用于逐等级对比测试）
+const KernelTable* kernel_table(IsaLevel level);
+
+inline void relu(const float* x, float* y, size_t n) { kernels().relu(x, y, n); }
+inline void f32_to_f16(const float* x, uint16_t* y, size_t n) { kernels().f32_to_f16(x, y, n); }
+
+// 单个元素的参考实现，供标量表和各等级处理尾部元素使用
+uint16_t f32_to_f16_scalar(float value);
+
+namespace detail {
+void fill_scalar_kernels(KernelTable& t);
+#ifdef BEVFUSION_X86_KERNELS
+void fill_sse4_kernels(KernelTable& t);
+void fill_avx2_kernels(KernelTable& t);
+void fill_avx512_kernels(KernelTable& t);
+#endif
+}  // namespace detail
+
+}  // namespace bevfusion
+
+#endif  // BEVFUSION_KERNELS_H
@@ -0,0 +1,60 @@
+// AVX2 实现，本文件以 -mavx2 -mfma -mf16c 编译
+#include "kernels.h"
+
+#include <immintrin.h>
+
+namespace bevfusion {
+
+static void relu_avx2(const float* x, float* y, size_t n) {
+    const __m256 zero = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        _mm256_storeu_ps(y + i, _mm256_max_ps(_mm256_loadu_ps(x + i), zero));
+        _mm256_storeu_ps(y + i + 8, _mm256_max_ps(_mm256_loadu_ps(x + i + 8), zero));
+        _mm256_storeu_ps(y + i + 16, _mm256_max_ps(_mm256_loadu_ps(x + i + 16), zero));
+        _mm256_storeu_ps(y + i + 24, _mm256_max_ps(_mm256_loadu_ps(x + i + 24), zero));
+    }
+    for (; i + 8 <= n; i += 8) _mm256_storeu_ps(y + i, _mm256_max_ps(_mm256_loadu_ps(x + i), zero));
+    for (; i < n; ++i) y[i] = x[i] > 0 ? x[i] : 0;
+}
+
+static void f32_to_f16_avx2(const float* x, uint16_t* y, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i h0 = _mm256_cvtps_ph(_mm256_loadu_ps(x + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m128i h1 = _mm256_cvtps_ph(_mm256_loadu_ps(x + i + 8), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(y + i), h0);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(y + i + 8), h1);
+    }
+    for (; i < n; ++i) y[i] = f32_to_f16_scalar(x[i]);
+}
+
+// 6×16 寄存器分块: 12 个累加器 + 2 个 B 向量 + 1 个广播
+static void sgemm_tile_avx2(int k, const float* a, const float* b, float* c) {
+    __m256 c0[kGemmMR], c1[kGemmMR];
+    for (int i = 0; i < kGemmMR; ++i) c0[i] = c1[i] = _mm256_setzero_ps();
+    for (int p = 0; p < k; ++p) {
+        const __m256 b0 = _mm256_loadu_ps(b + p * kGemmNR);
+        const __m256 b1 = _mm256_loadu_ps(b + p * kGemmNR + 8);
+        for (int i = 0; i < kGemmMR; ++i) {
+            const __m256 ai = _mm256_broadcast_ss(a + p * kGemmMR + i);
+            c0[i] = _mm256_fmadd_ps(ai, b0, c0[i]);
+            c1[i] = _mm256_fmadd_ps(ai, b1, c1[i]);
+        }
+    }
+    for (int i = 0; i < kGemmMR; ++i) {
+        _mm256_storeu_ps(c + i * kGemmNR, c0[i]);
+        _mm256_storeu_ps(c + i * kGemmNR + 8, c1[i]);
+    }
+}
+
+namespace detail {
+void fill_avx2_kernels(KernelTable& t) {
+    t.level = IsaLevel::AVX2;
+    t.relu = relu_avx2;
+    t.f32_to_f16 = f32_to_f16_avx2;
+    t.sgemm_tile = sgemm_tile_avx2;
+}
+}  // namespace detail
+
+}  // namespace bevfusion
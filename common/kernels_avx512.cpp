@@ -0,0 +1,56 @@
+// AVX-512 实现，本文件以 -mavx512f 编译
+#include "kernels.h"
+
+#include <immintrin.h>
+
+namespace bevfusion {
+
+static void relu_avx512(const float* x, float* y, size_t n) {
+    const __m512 zero = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        _mm512_storeu_ps(y + i, _mm512_max_ps(_mm512_loadu_ps(x + i), zero));
+        _mm512_storeu_ps(y + i + 16, _mm512_max_ps(_mm512_loadu_ps(x + i + 16), zero));
+        _mm512_storeu_ps(y + i + 32, _mm512_max_ps(_mm512_loadu_ps(x + i + 32), zero));
+        _mm512_storeu_ps(y + i + 48, _mm512_max_ps(_mm512_loadu_ps(x + i + 48), zero));
+    }
+    if (i < n) {
+        // 尾部用掩码读写，避免越界
+        for (; i < n; i += 16) {
+            __mmask16 m = (n - i >= 16) ? __mmask16(0xffff) : __mmask16((1u << (n - i)) - 1);
+            _mm512_mask_storeu_ps(y + i, m, _mm512_max_ps(_mm512_maskz_loadu_ps(m, x + i), zero));
+        }
+    }
+}
+
+static void f32_to_f16_avx512(const float* x, uint16_t* y, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i h0 = _mm512_cvtps_ph(_mm512_loadu_ps(x + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256i h1 = _mm512_cvtps_ph(_mm512_loadu_ps(x + i + 16), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(y + i), h0);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(y + i + 16), h1);
+    }
+    for (; i < n; ++i) y[i] = f32_to_f16_scalar(x[i]);
+}
+
+static void sgemm_tile_avx512(int k, const float* a, const float* b, float* c) {
+    __m512 acc[kGemmMR];
+    for (int i = 0; i < kGemmMR; ++i) acc[i] = _mm512_setzero_ps();
+    for (int p = 0; p < k; ++p) {
+        const __m512 bv = _mm512_loadu_ps(b + p * kGemmNR);
+        for (int i = 0; i < kGemmMR; ++i) acc[i] = _mm512_fmadd_ps(_mm512_set1_ps(a[p * kGemmMR + i]), bv, acc[i]);
+    }
+    for (int i = 0; i < kGemmMR; ++i) _mm512_storeu_ps(c + i * kGemmNR, acc[i]);
+}
+
+namespace detail {
+void fill_avx512_kernels(KernelTable& t) {
+    t.level = IsaLevel::AVX512;
+    t.relu = relu_avx512;
+    t.f32_to_f16 = f32_to_f16_avx512;
+    t.sgemm_tile = sgemm_tile_avx512;
+}
+}  // namespace detail
+
+}  // namespace bevfusion
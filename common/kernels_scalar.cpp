@@ -0,0 +1,104 @@
+// 标量参考实现，同时负责按等级组装内核表
+#include "kernels.h"
+
+#include <cstring>
+
+namespace bevfusion {
+
+uint16_t f32_to_f16_scalar(float value) {
+    // 与 F16C 的 vcvtps2ph(就近舍入到偶数) 结果逐位一致
+    const uint32_t f32_infty = 255u << 23;
+    const uint32_t f16_max = (127u + 16u) << 23;           // 65536.0f，不小于它的值舍入后都是 Inf
+    const uint32_t denorm_magic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+    uint32_t f;
+    std::memcpy(&f, &value, sizeof(f));
+    uint32_t sign = f & 0x80000000u;
+    f ^= sign;
+
+    uint16_t h;
+    if (f >= f16_max) {
+        h = (f > f32_infty) ? 0x7e00 : 0x7c00;  // NaN / Inf
+    } else if (f < (113u << 23)) {
+        // 结果为 float16 非规格化数或 0：借助浮点加法完成舍入
+        float fv, magic;
+        std::memcpy(&fv, &f, sizeof(fv));
+        std::memcpy(&magic, &denorm_magic, sizeof(magic));
+        fv += magic;
+        std::memcpy(&f, &fv, sizeof(f));
+        h = static_cast<uint16_t>(f - denorm_magic);
+    } else {
+        uint32_t mant_odd = (f >> 13) & 1u;
+        f += (uint32_t(15 - 127) << 23) + 0xfffu;
+        f += mant_odd;
+        h = static_cast<uint16_t>(f >> 13);
+    }
+    return static_cast<uint16_t>(h | (sign >> 16));
+}
+
+static void relu_scalar(const float* x, float* y, size_t n) {
+    for (size_t i = 0; i < n; ++i) y[i] = x[i] > 0 ? x[i] : 0;
+}
+
+static void f32_to_f16_scalar_n(const float* x, uint16_t* y, size_t n) {
+    for (size_t i = 0; i < n; ++i) y[i] = f32_to_f16_scalar(x[i]);
+}
+
+static void sgemm_tile_scalar(int k, const float* a, const float* b, float* c) {
+    float acc[kGemmMR][kGemmNR] = {};
+    for (int p = 0; p < k; ++p) {
+        for (int i = 0; i < kGemmMR; ++i) {
+            const float ai = a[p * kGemmMR + i];
+            for (int j = 0; j < kGemmNR; ++j) acc[i][j] += ai * b[p * kGemmNR + j];
+        }
+    }
+    std::memcpy(c, acc, sizeof(acc));
+}
+
+namespace detail {
+void fill_scalar_kernels(KernelTable& t) {
+    t.level = IsaLevel::Scalar;
+    t.relu = relu_scalar;
+    t.f32_to_f16 = f32_to_f16_scalar_n;
+    t.sgemm_tile = sgemm_tile_scalar;
+}
+}  // namespace detail
+
+namespace {
+struct KernelTables {
+    KernelTable tables[4];
+    bool compiled[4] = {false, false, false, false};
+
+    KernelTables() {
+        detail::fill_scalar_kernels(tables[0]);
+        compiled[0] = true;
+#ifdef BEVFUSION_X86_KERNELS
+        void (*fill[])(KernelTable&) = {detail::fill_sse4_kernels, detail::fill_avx2_kernels,
+                                        detail::fill_avx512_kernels};
+        for (int i = 1; i < 4; ++i) {
+            tables[i] = tables[i - 1];
+            fill[i - 1](tables[i]);
+            compiled[i] = true;
+        }
+#endif
+    }
+};
+
+const KernelTables& all_tables() {
+    static const KernelTables t;
+    return t;
+}
+}  // namespace
+
+const KernelTable* kernel_table(IsaLevel level) {
+    const KernelTables& t = all_tables();
+    int i = static_cast<int>(level);
+    return t.compiled[i] ? &t.tables[i] : nullptr;
+}
+
+const KernelTable& kernels() {
+    static const KernelTable* table = kernel_table(active_isa());
+    return *table;
+}
+
+}  // namespace bevfusion
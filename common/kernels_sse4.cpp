@@ -0,0 +1,30 @@
+// SSE4 实现，本文件以 -msse4.2 编译
+#include "kernels.h"
+
+#include <immintrin.h>
+
+namespace bevfusion {
+
+static void relu_sse4(const float* x, float* y, size_t n) {
+    const __m128 zero = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        // maxps 在任一操作数为 NaN 时返回第二个操作数，与标量版本一样输出 0
+        _mm_storeu_ps(y + i, _mm_max_ps(_mm_loadu_ps(x + i), zero));
+        _mm_storeu_ps(y + i + 4, _mm_max_ps(_mm_loadu_ps(x + i + 4), zero));
+        _mm_storeu_ps(y + i + 8, _mm_max_ps(_mm_loadu_ps(x + i + 8), zero));
+        _mm_storeu_ps(y + i + 12, _mm_max_ps(_mm_loadu_ps(x + i + 12), zero));
+    }
+    for (; i + 4 <= n; i += 4) _mm_storeu_ps(y + i, _mm_max_ps(_mm_loadu_ps(x + i), zero));
+    for (; i < n; ++i) y[i] = x[i] > 0 ? x[i] : 0;
+}
+
+namespace detail {
+// SSE4 没有 F16C，f32_to_f16 沿用标量版本
+void fill_sse4_kernels(KernelTable& t) {
+    t.level = IsaLevel::SSE4;
+    t.relu = relu_sse4;
+}
+}  // namespace detail
+
+}  // namespace bevfusion
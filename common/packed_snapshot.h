@@ -0,0 +1,48 @@
+#ifndef BEVFUSION_PACKED_SNAPSHOT_H
+#define BEVFUSION_PACKED_SNAPSHOT_H
+
+// 手写内核使用的打包权重与模块参数的同步
+//
+// 参数按版本号（libtorch 张量的 _version()，就地修改和 torch::load 都会递增）判断是否改写过：
+// 第一次前向时打包，参数之后被改写则在下一次前向重新打包。多个线程同时进入时只有一个线程打包，
+// 其余等它完成；版本号未变时只读一个原子变量。本头文件不依赖 libtorch，参数类型只需提供 _version()。
+
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include <mutex>
+#include <vector>
+
+namespace bevfusion {
+
+class PackedSnapshot {
+public:
+    template <typename Tensor, typename Pack>
+    void sync(std::initializer_list<Tensor> params, Pack pack) {
+        sync(params.begin(), params.end(), pack);
+    }
+
+    template <typename Tensor, typename Pack>
+    void sync(const std::vector<Tensor>& params, Pack pack) {
+        sync(params.begin(), params.end(), pack);
+    }
+
+private:
+    template <typename It, typename Pack>
+    void sync(It begin, It end, Pack& pack) {
+        int64_t version = 0;
+        for (It p = begin; p != end; ++p) version += p->_version();  // 版本号只增不减，和相同即都未改写
+        if (version_.load(std::memory_order_acquire) == version) return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (version_.load(std::memory_order_relaxed) == version) return;
+        pack();
+        version_.store(version, std::memory_order_release);
+    }
+
+    std::mutex mutex_;
+    std::atomic<int64_t> version_{-1};
+};
+
+}  // namespace bevfusion
+
+#endif  // BEVFUSION_PACKED_SNAPSHOT_H
@@ -0,0 +1,66 @@
+#ifndef BEVFUSION_POINTWISE_CONV_H
+#define BEVFUSION_POINTWISE_CONV_H
+
+// 1×1 卷积
+//
+// NCHW 下 1×1 卷积就是 (Cout×Cin)·(Cin×HW) 的 GEMM。构造时把权重打包成 GEMM 的 A 面板并缓存，
+// 之后每次前向只打包输入，按 HW 方向分块多线程执行（调用方链接 OpenMP 时），bias 和 ReLU 在写出时完成。
+
+#include <vector>
+
+#include "gemm.h"
+
+namespace bevfusion {
+
+class PointwiseConv {
+public:
+    PointwiseConv() = default;
+
+    // weight: [cout][cin]（即 [cout][cin][1][1] 连续存放），bias 可为 nullptr
+    PointwiseConv(int cin, int cout, const float* weight, const float* bias) { reset(cin, cout, weight, bias); }
+
+    void reset(int cin, int cout, const float* weight, const float* bias) {
+        cin_ = cin;
+        cout_ = cout;
+        gemm_pack_a(cout, cin, MatrixView{weight, cin, 1}, &packed_);
+        bias_.assign(cout, 0.0f);
+        if (bias) bias_.assign(bias, bias + cout);
+    }
+
+    bool empty() const { return packed_.empty(); }
+    int in_channels() const { return cin_; }
+    int out_channels() const { return cout_; }
+
+    // x: [batch][cin][hw]，y: [batch][cout][hw]，x 与 y 不能重叠
+    void forward(const float* x, int batch, int hw, float* y, bool relu = false) const {
+        for (int b = 0; b < batch; ++b) {
+            const float* xb = x + static_cast<size_t>(b) * cin_ * hw;
+            float* yb = y + static_cast<size_t>(b) * cout_ * hw;
+            sgemm(packed_, hw, MatrixView{xb, hw, 1}, [&](int m0, int n0, int rows, int cols, const float* tile, int ld) {
+                for (int i = 0; i < rows; ++i) {
+                    const float bias = bias_[m0 + i];
+                    const float* t = tile + i * ld;
+                    float* dst = yb + static_cast<size_t>(m0 + i) * hw + n0;
+                    if (relu) {
+                        for (int j = 0; j < cols; ++j) {
+                            float v = t[j] + bias;
+                            dst[j] = v > 0 ? v : 0;
+                        }
+                    } else {
+                        for (int j = 0; j < cols; ++j) dst[j] = t[j] + bias;
+                    }
+                }
+            });
+        }
+    }
+
+private:
+    int cin_ = 0;
+    int cout_ = 0;
+    GemmPackedA packed_;
+    std::vector<float> bias_;
+};
+
+}  // namespace bevfusion
+
+#endif  // BEVFUSION_POINTWISE_CONV_H
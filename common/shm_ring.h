@@ -0,0 +1,313 @@
+#ifndef BEVFUSION_SHM_RING_H
+#define BEVFUSION_SHM_RING_H
+
+// 跨进程的单生产者/单消费者共享内存槽位环
+//
+// 同一主机上的两个 chiplet 进程用 shm_open 打开同名对象。数据区分成 num_slots 个固定大小的槽位，一个槽位放一条消息：
+//   生产者 acquire_write 取得下一个空槽位的指针，直接在共享内存里写（或算）出消息，commit_write 发布；
+//   消费者 acquire_read 取得下一个已发布槽位的指针，原地读完后 release_read 归还。
+// 两侧都不经过中间缓冲，整条消息装得下一个槽位时收发都是零拷贝。write/read 是在此之上的拷贝接口：
+// 按顺序把各段拷进（拷出）槽位，超过一个槽位的消息依次占用多个槽位。
+//
+// head/tail 是已发布/已归还的累计槽位数，只增不减；两侧各有一个 32 位序号作为 futex 字，推进 head/tail 后递增序号并唤醒对方，
+// 等待方先自旋一小段再 futex 睡眠。同一侧可以有多个槽位同时在用（例如计算线程正在读第 k 帧、I/O 线程已经收下第 k+1 帧），
+// 发布和归还的先后不必与取得的顺序一致：head/tail 只越过连续完成的槽位，未完成的槽位不会被对方看到或覆盖。
+//
+// 对象只在 ftruncate 时清零一次，正常结束时 head == tail，下次运行直接复用。open 时检查 magic、槽位大小与个数，
+// 不是本程序的环时报错；head != tail 说明上次运行异常退出、环里残留了消息，丢弃残留后继续。
+// 丢弃是安全的：每条消息先经 interchiplet 握手配对才开始写，两侧都 open 之前环里不会有本次运行的数据。
+//
+// abort() 只作用于本进程：唤醒本进程中等在环上的线程，之后的 acquire_write/acquire_read 与 write/read 返回 false。
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "band_stream.h"
+
+namespace bevfusion {
+
+constexpr uint32_t kShmRingMagic = 0x544f4c53;  // "SLOT"
+
+struct ShmRingHeader {
+    std::atomic<uint32_t> magic;
+    std::atomic<uint32_t> num_slots;
+    std::atomic<uint64_t> slot_bytes;
+    alignas(64) std::atomic<uint64_t> head;     // 生产者已发布的累计槽位数
+    std::atomic<uint32_t> head_seq;             // futex 字：head 每推进一次加一
+    alignas(64) std::atomic<uint64_t> tail;     // 消费者已归还的累计槽位数
+    std::atomic<uint32_t> tail_seq;             // futex 字：tail 每推进一次加一
+    alignas(64) std::atomic<uint64_t> lengths[];  // 每个槽位中消息的字节数，随后是按页对齐的数据区
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "共享内存中的原子变量必须无锁");
+
+// 一个取得的槽位：data 指向共享内存，bytes 为可写容量（生产者）或消息长度（消费者），seq 为槽位的累计序号
+struct ShmSlot {
+    void* data = nullptr;
+    size_t bytes = 0;
+    uint64_t seq = 0;
+};
+
+class ShmRing {
+public:
+    ShmRing() = default;
+    ShmRing(const ShmRing&) = delete;
+    ShmRing& operator=(const ShmRing&) = delete;
+    ~ShmRing() {
+        if (header_) munmap(header_, mapped_bytes_);
+    }
+
+    // 打开（不存在则创建）名为 name 的环，两侧的槽位大小和个数必须一致
+    bool open(const std::string& name, uint64_t slot_bytes, uint32_t num_slots) {
+        int fd = shm_open(name.c_str(), O_RDWR | O_CREAT, 0600);
+        if (fd < 0) {
+            std::cerr << "shm_open 失败: " << name << std::endl;
+            return false;
+        }
+        const uint64_t data_offset = (sizeof(ShmRingHeader) + num_slots * sizeof(uint64_t) + kPage - 1) / kPage * kPage;
+        const uint64_t bytes = data_offset + slot_bytes * num_slots;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (static_cast<uint64_t>(st.st_size) < bytes && ftruncate(fd, bytes) != 0)) {
+            std::cerr << "设置共享内存大小失败: " << name << std::endl;
+            ::close(fd);
+            return false;
+        }
+        void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            std::cerr << "mmap 共享内存失败: " << name << std::endl;
+            return false;
+        }
+        header_ = static_cast<ShmRingHeader*>(p);
+        mapped_bytes_ = bytes;
+        data_ = static_cast<char*>(p) + data_offset;
+        slot_bytes_ = slot_bytes;
+        num_slots_ = num_slots;
+        // 新建的对象全为 0；两侧写入相同的值，先后无关
+        uint32_t magic = 0;
+        header_->magic.compare_exchange_strong(magic, kShmRingMagic);
+        if (magic != 0 && magic != kShmRingMagic) {
+            std::cerr << "共享内存对象 " << name << " 不是本程序的环（magic 0x" << std::hex << magic << std::dec
+                      << "），请先删除 /dev/shm" << name << std::endl;
+            return false;
+        }
+        uint64_t expected_bytes = 0;
+        uint32_t expected_slots = 0;
+        header_->slot_bytes.compare_exchange_strong(expected_bytes, slot_bytes);
+        header_->num_slots.compare_exchange_strong(expected_slots, num_slots);
+        if ((expected_bytes != 0 && expected_bytes != slot_bytes) || (expected_slots != 0 && expected_slots != num_slots)) {
+            std::cerr << "共享内存环 " << name << " 的槽位（" << expected_slots << " × " << expected_bytes
+                      << " 字节）与本进程的（" << num_slots << " × " << slot_bytes << " 字节）不一致，请先删除 /dev/shm"
+                      << name << std::endl;
+            return false;
+        }
+        uint64_t head = header_->head.load(std::memory_order_acquire);
+        uint64_t tail = header_->tail.load(std::memory_order_acquire);
+        if (tail > head || head - tail > num_slots) {
+            std::cerr << "共享内存环 " << name << " 状态损坏（head " << head << "，tail " << tail
+                      << "），请先删除 /dev/shm" << name << std::endl;
+            return false;
+        }
+        if (head != tail) {
+            // 两侧可能都看到残留并各自丢弃，结果相同
+            std::cerr << "共享内存环 " << name << " 残留上次运行的 " << head - tail << " 条消息，已丢弃" << std::endl;
+            header_->tail.compare_exchange_strong(tail, head, std::memory_order_acq_rel);
+        }
+        next_write_ = next_read_ = head;
+        done_.assign(num_slots, 0);
+        return true;
+    }
+
+    uint64_t slot_bytes() const { return slot_bytes_; }
+
+    // 生产者：等到有空槽位后取得它（slot->bytes 为槽位容量），写完调用 commit_write；已 abort 时返回 false。
+    // 可以连续取得多个槽位再依次（或乱序）发布
+    bool acquire_write(ShmSlot* slot) {
+        uint64_t seq = take(next_write_);
+        uint64_t tail;
+        if (!wait_until([&] { return header_->tail.load(std::memory_order_acquire); },
+                        [&](uint64_t t) { return seq - t < num_slots_; }, header_->tail_seq, &tail)) {
+            return false;
+        }
+        *slot = ShmSlot{data_ + (seq % num_slots_) * slot_bytes_, slot_bytes_, seq};
+        return true;
+    }
+
+    // 发布槽位中 bytes 字节的消息
+    void commit_write(const ShmSlot& slot, size_t bytes) {
+        header_->lengths[slot.seq % num_slots_].store(bytes, std::memory_order_relaxed);
+        complete(slot.seq, header_->head, header_->head_seq);
+    }
+
+    // 消费者：等到下一条消息发布后取得它所在的槽位（slot->bytes 为消息长度），读完调用 release_read；已 abort 时返回 false
+    bool acquire_read(ShmSlot* slot) {
+        uint64_t seq = take(next_read_);
+        uint64_t head;
+        if (!wait_until([&] { return header_->head.load(std::memory_order_acquire); },
+                        [&](uint64_t h) { return h > seq; }, header_->head_seq, &head)) {
+            return false;
+        }
+        *slot = ShmSlot{data_ + (seq % num_slots_) * slot_bytes_,
+                        header_->lengths[seq % num_slots_].load(std::memory_order_relaxed), seq};
+        return true;
+    }
+
+    void release_read(const ShmSlot& slot) { complete(slot.seq, header_->tail, header_->tail_seq); }
+
+    // 拷贝接口：各段依次拷进槽位，写满一个槽位发布一个；abort 后返回 false
+    bool write(const IoPiece* pieces, int count) {
+        ShmSlot slot;
+        size_t used = 0;
+        bool open_slot = false;
+        for (int i = 0; i < count; ++i) {
+            const char* src = static_cast<const char*>(pieces[i].data);
+            size_t bytes = pieces[i].bytes;
+            while (bytes > 0) {
+                if (!open_slot) {
+                    if (!acquire_write(&slot)) return false;
+                    used = 0;
+                    open_slot = true;
+                }
+                size_t n = std::min(bytes, slot.bytes - used);
+                std::memcpy(static_cast<char*>(slot.data) + used, src, n);
+                used += n;
+                src += n;
+                bytes -= n;
+                if (used == slot.bytes) {
+                    commit_write(slot, used);
+                    open_slot = false;
+                }
+            }
+        }
+        if (open_slot) commit_write(slot, used);
+        return true;
+    }
+
+    // 按消息总长逐个槽位读出；槽位里的数据多于剩余长度说明两侧的消息不一致，返回 false
+    bool read(const IoPiece* pieces, int count) {
+        ShmSlot slot;
+        size_t used = 0;
+        bool open_slot = false;
+        for (int i = 0; i < count; ++i) {
+            char* dst = static_cast<char*>(pieces[i].data);
+            size_t bytes = pieces[i].bytes;
+            while (bytes > 0) {
+                if (!open_slot) {
+                    if (!acquire_read(&slot)) return false;
+                    used = 0;
+                    open_slot = true;
+                }
+                size_t n = std::min(bytes, slot.bytes - used);
+                std::memcpy(dst, static_cast<const char*>(slot.data) + used, n);
+                used += n;
+                dst += n;
+                bytes -= n;
+                if (used == slot.bytes) {
+                    release_read(slot);
+                    open_slot = false;
+                }
+            }
+        }
+        if (open_slot) {
+            std::cerr << "共享内存环中的消息比接收方期望的长 " << slot.bytes - used << " 字节" << std::endl;
+            release_read(slot);
+            return false;
+        }
+        return true;
+    }
+
+    // 可从任意线程调用。先置标志再推进两侧序号并唤醒：已读到旧序号、正要睡眠的等待方会因序号变化立即返回。
+    // 对端进程中的等待方也会被唤醒，它们重新检查条件后继续等待
+    void abort() {
+        aborted_.store(true);
+        for (std::atomic<uint32_t>* seq : {&header_->head_seq, &header_->tail_seq}) {
+            seq->fetch_add(1);
+            futex_wake(*seq);
+        }
+    }
+
+private:
+    static constexpr uint64_t kPage = 4096;
+
+    uint64_t take(uint64_t& next) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return next++;
+    }
+
+    // 标记序号 seq 的槽位已完成，并把 counter 推进到第一个未完成的槽位；本进程中只有一侧使用 counter，
+    // 已完成标记 done_ 在两种用途之间不会混用（一个环在一个进程里只作生产者或只作消费者）
+    void complete(uint64_t seq, std::atomic<uint64_t>& counter, std::atomic<uint32_t>& counter_seq) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_[seq % num_slots_] = 1;
+            uint64_t value = counter.load(std::memory_order_relaxed);
+            const uint64_t start = value;
+            while (done_[value % num_slots_]) {
+                done_[value % num_slots_] = 0;
+                ++value;
+            }
+            if (value == start) return;
+            counter.store(value, std::memory_order_release);
+        }
+        counter_seq.fetch_add(1, std::memory_order_release);
+        futex_wake(counter_seq);
+    }
+
+    // 先读 futex 序号再检查条件，条件不满足时在该序号上睡眠，避免错过唤醒。单核上对端不可能同时推进，不自旋。
+    // 条件满足时把读到的值写入 value 并返回 true，已 abort 时返回 false
+    template <typename Load, typename Ready>
+    bool wait_until(Load load, Ready ready, std::atomic<uint32_t>& seq, uint64_t* value) const {
+        static const int max_spin = std::thread::hardware_concurrency() > 1 ? 1000 : 0;
+        for (int spin = 0;; ++spin) {
+            uint32_t s = seq.load();
+            if (aborted_.load()) return false;
+            uint64_t v = load();
+            if (ready(v)) {
+                *value = v;
+                return true;
+            }
+            if (spin < max_spin) {
+#if defined(__x86_64__) || defined(__i386__)
+                __builtin_ia32_pause();
+#endif
+                continue;
+            }
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&seq), FUTEX_WAIT, s, nullptr, nullptr, 0);
+        }
+    }
+
+    static void futex_wake(std::atomic<uint32_t>& seq) {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&seq), FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+    }
+
+    ShmRingHeader* header_ = nullptr;
+    size_t mapped_bytes_ = 0;
+    char* data_ = nullptr;
+    uint64_t slot_bytes_ = 0;
+    uint32_t num_slots_ = 0;
+    uint64_t next_write_ = 0;  // 本进程作生产者时下一个要取得的槽位序号
+    uint64_t next_read_ = 0;   // 本进程作消费者时下一个要取得的槽位序号
+    std::vector<char> done_;   // 已发布（生产者）或已归还（消费者）、但 head/tail 还没越过的槽位
+    std::mutex mutex_;
+    std::atomic<bool> aborted_{false};
+};
+
+}  // namespace bevfusion
+
+#endif  // BEVFUSION_SHM_RING_H
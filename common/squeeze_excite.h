@@ -0,0 +1,99 @@
+#ifndef BEVFUSION_SQUEEZE_EXCITE_H
+#define BEVFUSION_SQUEEZE_EXCITE_H
+
+// 融合的 squeeze-and-excitation（通道注意力）
+//
+// x[b][c][:] *= sigmoid(W2 · relu(W1 · mean(x[b]) + b1) + b2)[c]
+// 一遍流式读取求各通道均值，两层小 MLP 之后就地缩放，不生成池化结果和乘积这两个中间张量。
+// 三步都按 batch×通道 划分给线程（调用方链接 OpenMP 时），同一个并行区内用隐式屏障分隔。
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace bevfusion {
+
+class SqueezeExcite {
+public:
+    SqueezeExcite() = default;
+
+    // fc1: [reduced][channels]，fc2: [channels][reduced]（即 torch::nn::Linear 的权重布局），bias 可为 nullptr
+    SqueezeExcite(int channels, int reduced, const float* fc1_weight, const float* fc1_bias, const float* fc2_weight,
+                  const float* fc2_bias) {
+        reset(channels, reduced, fc1_weight, fc1_bias, fc2_weight, fc2_bias);
+    }
+
+    void reset(int channels, int reduced, const float* fc1_weight, const float* fc1_bias, const float* fc2_weight,
+               const float* fc2_bias) {
+        channels_ = channels;
+        reduced_ = reduced;
+        fc1_.assign(fc1_weight, fc1_weight + static_cast<size_t>(reduced) * channels);
+        fc2_.assign(fc2_weight, fc2_weight + static_cast<size_t>(channels) * reduced);
+        b1_.assign(reduced, 0.0f);
+        b2_.assign(channels, 0.0f);
+        if (fc1_bias) b1_.assign(fc1_bias, fc1_bias + reduced);
+        if (fc2_bias) b2_.assign(fc2_bias, fc2_bias + channels);
+    }
+
+    int channels() const { return channels_; }
+
+    // x: [batch][channels][hw]，就地缩放
+    void forward(float* x, int batch, int hw) const {
+        const int C = channels_;
+        const int R = reduced_;
+        const int planes = batch * C;
+        std::vector<float> mean(planes), hidden(static_cast<size_t>(batch) * R);
+
+        #pragma omp parallel
+        {
+            // 1. 各通道均值：8 路部分和便于向量化
+            #pragma omp for schedule(static)
+            for (int p = 0; p < planes; ++p) {
+                const float* xp = x + static_cast<size_t>(p) * hw;
+                float acc[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+                int j = 0;
+                for (; j + 8 <= hw; j += 8) {
+                    for (int l = 0; l < 8; ++l) acc[l] += xp[j + l];
+                }
+                float sum = ((acc[0] + acc[4]) + (acc[1] + acc[5])) + ((acc[2] + acc[6]) + (acc[3] + acc[7]));
+                for (; j < hw; ++j) sum += xp[j];
+                mean[p] = sum / hw;
+            }
+
+            // 2. fc1 + ReLU
+            #pragma omp for schedule(static)
+            for (int q = 0; q < batch * R; ++q) {
+                const int b = q / R;
+                const int r = q % R;
+                const float* w = fc1_.data() + static_cast<size_t>(r) * C;
+                const float* m = mean.data() + static_cast<size_t>(b) * C;
+                float v = b1_[r];
+                for (int c = 0; c < C; ++c) v += w[c] * m[c];
+                hidden[q] = v > 0 ? v : 0;
+            }
+
+            // 3. fc2 + sigmoid，随即缩放该通道
+            #pragma omp for schedule(static)
+            for (int p = 0; p < planes; ++p) {
+                const int b = p / C;
+                const int c = p % C;
+                const float* w = fc2_.data() + static_cast<size_t>(c) * R;
+                const float* h = hidden.data() + static_cast<size_t>(b) * R;
+                float v = b2_[c];
+                for (int r = 0; r < R; ++r) v += w[r] * h[r];
+                const float scale = 1.0f / (1.0f + std::exp(-v));
+                float* xp = x + static_cast<size_t>(p) * hw;
+                for (int j = 0; j < hw; ++j) xp[j] *= scale;
+            }
+        }
+    }
+
+private:
+    int channels_ = 0;
+    int reduced_ = 0;
+    std::vector<float> fc1_, fc2_, b1_, b2_;
+};
+
+}  // namespace bevfusion
+
+#endif  // BEVFUSION_SQUEEZE_EXCITE_H
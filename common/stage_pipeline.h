@@ -0,0 +1,210 @@
+#ifndef BEVFUSION_STAGE_PIPELINE_H
+#define BEVFUSION_STAGE_PIPELINE_H
+
+// chiplet 阶段的双缓冲流水线
+//
+// 常驻的阶段进程连续处理 num_frames 帧。输入、输出各有两块预分配的缓冲，第 k 帧使用第 k%2 块：
+//   计算线程（调用 run() 的线程）读 input[k%2]、写 output[k%2]；
+//   同时 I/O 线程把第 k+1 帧收进 input[(k+1)%2]，再把第 k-1 帧从 output[(k-1)%2] 发出。
+// 每块缓冲同一时刻只属于一个线程，所有权按 Free -> Writing -> Ready -> Reading -> Free 流转，
+// 线程之间只交接缓冲的所有权，不拷贝数据。
+//
+// stream_input 为 true 时计算线程不必等整帧到齐：输入缓冲一开始接收就交给计算回调，
+// 回调通过 RowProgress 等待自己需要的行（见 band_stream.h），算完后等接收结束再释放缓冲。
+//
+// interchiplet 的握手经进程标准输入输出，并且要等对端就绪才返回，不能由两个线程同时发起，
+// 所以收发都在同一个 I/O 线程里，顺序固定为 收0, 收1, 发0, 收2, 发1, ...，
+// 与主控“先发第 k+1 帧输入、再收第 k-1 帧结果”的顺序一致（见 main/main.cpp）。
+//
+// 本头文件不依赖 InterChiplet，具体收发由调用方在回调里完成（见 chiplet_link.h）。
+//
+// 任一线程失败时调用 set_cancel() 设置的取消回调（通常是 ChipletLink::abort），让阻塞在收发上的 I/O 线程返回。
+// 管道和握手的阻塞无法在进程内打断：失败后 I/O 线程 kIoGraceMs 内仍未退出时直接结束进程，不再等对端。
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include "band_stream.h"
+
+namespace bevfusion {
+
+enum class SlotState { Free, Writing, Ready, Reading };
+
+// 计算线程的耗时统计，用于判断 I/O 是否被计算掩盖
+struct PipelineStats {
+    int frames = 0;
+    double compute_ms = 0.0;      // 计算回调总耗时
+    double wait_input_ms = 0.0;   // 计算线程等待输入到齐的时间
+    double wait_output_ms = 0.0;  // 计算线程等待输出缓冲发完的时间
+    double total_ms = 0.0;        // run() 的墙钟时间
+};
+
+template <typename Input, typename Output>
+class StagePipeline {
+public:
+    // rows: 本帧输入的已到达行数，只有按行带接收的阶段需要推进它
+    using ReceiveFn = std::function<bool(Input&, int frame, RowProgress& rows)>;
+    using ComputeFn = std::function<bool(const Input&, Output&, int frame, const RowProgress& rows)>;
+    using SendFn = std::function<bool(const Output&, int frame)>;
+
+    StagePipeline() = default;
+    StagePipeline(const StagePipeline&) = delete;
+    StagePipeline& operator=(const StagePipeline&) = delete;
+
+    // 流水线失败时调用（在失败的线程里，不持有内部锁），用来中断 I/O 线程上正在进行的收发
+    void set_cancel(std::function<void()> cancel) { cancel_ = std::move(cancel); }
+
+    // 预分配的缓冲，run() 之前可按需初始化
+    Input& input(int slot) { return inputs_[slot]; }
+    Output& output(int slot) { return outputs_[slot]; }
+
+    // 处理 num_frames 帧，任一回调返回 false 时停止并返回 false
+    bool run(int num_frames, ReceiveFn receive, ComputeFn compute, SendFn send, bool stream_input = false) {
+        auto start = std::chrono::steady_clock::now();
+        stats_ = PipelineStats();
+        failed_ = false;
+        io_done_ = false;
+        for (int i = 0; i < 2; ++i) in_state_[i] = out_state_[i] = SlotState::Free;
+
+        auto io_loop = [&] {
+            for (int k = 0; k <= num_frames; ++k) {
+                if (k < num_frames) {
+                    if (!acquire(in_state_[k % 2], SlotState::Free, SlotState::Writing, &in_rows_[k % 2])) return;
+                    if (!receive(inputs_[k % 2], k, in_rows_[k % 2])) return fail("接收", k);
+                    release(in_state_[k % 2], SlotState::Ready);
+                }
+                if (k > 0) {
+                    int j = k - 1;
+                    if (!acquire(out_state_[j % 2], SlotState::Ready, SlotState::Reading)) return;
+                    if (!send(outputs_[j % 2], j)) return fail("发送", j);
+                    release(out_state_[j % 2], SlotState::Free);
+                }
+            }
+        };
+        std::thread io([&] {
+            io_loop();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                io_done_ = true;
+            }
+            cv_.notify_all();
+        });
+
+        for (int k = 0; k < num_frames; ++k) {
+            double waited_in = time_ms([&] {
+                return stream_input ? wait_streaming(in_state_[k % 2])
+                                    : acquire(in_state_[k % 2], SlotState::Ready, SlotState::Reading);
+            });
+            double waited_out = time_ms([&] { return acquire(out_state_[k % 2], SlotState::Free, SlotState::Writing); });
+            if (failed()) break;
+            bool ok = true;
+            double t = time_ms([&] { return ok = compute(inputs_[k % 2], outputs_[k % 2], k, in_rows_[k % 2]); });
+            if (!ok) {
+                fail("计算", k);
+                break;
+            }
+            // 流式输入：接收线程可能还没把缓冲标成 Ready
+            if (stream_input && !acquire(in_state_[k % 2], SlotState::Ready, SlotState::Reading)) break;
+            release(in_state_[k % 2], SlotState::Free);
+            release(out_state_[k % 2], SlotState::Ready);
+            stats_.frames++;
+            stats_.compute_ms += t;
+            stats_.wait_input_ms += waited_in;
+            stats_.wait_output_ms += waited_out;
+        }
+
+        if (failed()) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!cv_.wait_for(lock, std::chrono::milliseconds(kIoGraceMs), [&] { return io_done_; })) {
+                std::cerr << "流水线失败后 I/O 线程仍阻塞在握手或管道上，进程直接退出" << std::endl;
+                std::cout.flush();
+                std::_Exit(1);
+            }
+        }
+        io.join();
+        stats_.total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return !failed();
+    }
+
+    const PipelineStats& stats() const { return stats_; }
+
+    void print_stats(const char* name) const {
+        std::cout << name << " 流水线: " << stats_.frames << " 帧, 总计 " << stats_.total_ms << " ms, 计算 "
+                  << stats_.compute_ms << " ms, 等待输入 " << stats_.wait_input_ms << " ms, 等待发送 "
+                  << stats_.wait_output_ms << " ms" << std::endl;
+    }
+
+private:
+    static constexpr int kIoGraceMs = 2000;
+
+    template <typename F>
+    static double time_ms(F&& f) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // 等待缓冲进入 from 状态后取得所有权；rows 非空时同时清零已到达行数。流水线失败时返回 false
+    bool acquire(SlotState& state, SlotState from, SlotState to, RowProgress* rows = nullptr) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [&] { return failed_ || state == from; });
+        if (failed_) return false;
+        if (rows) rows->reset();
+        state = to;
+        return true;
+    }
+
+    // 流式输入：等到接收线程开始写这块缓冲（或已写完），不转移所有权
+    bool wait_streaming(const SlotState& state) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [&] { return failed_ || state == SlotState::Writing || state == SlotState::Ready; });
+        return !failed_;
+    }
+
+    void release(SlotState& state, SlotState to) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            state = to;
+        }
+        cv_.notify_all();
+    }
+
+    // 只报告第一次失败：取消链路后 I/O 线程的收发随之失败，不再重复打印
+    void fail(const char* what, int frame) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (failed_) return;
+            failed_ = true;
+        }
+        std::cerr << "流水线第 " << frame << " 帧" << what << "失败" << std::endl;
+        cv_.notify_all();
+        for (RowProgress& rows : in_rows_) rows.abort();
+        if (cancel_) cancel_();
+    }
+
+    bool failed() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return failed_;
+    }
+
+    Input inputs_[2];
+    Output outputs_[2];
+    SlotState in_state_[2] = {SlotState::Free, SlotState::Free};
+    SlotState out_state_[2] = {SlotState::Free, SlotState::Free};
+    RowProgress in_rows_[2];
+    bool failed_ = false;
+    bool io_done_ = false;
+    std::function<void()> cancel_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    PipelineStats stats_;
+};
+
+}  // namespace bevfusion
+
+#endif  // BEVFUSION_STAGE_PIPELINE_H
@@ -0,0 +1,184 @@
+#include "tensor_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace bevfusion {
+
+namespace {
+
+constexpr uint32_t kTensorCacheMagic = 0x32336642;  // "Bf32"
+constexpr uint32_t kTensorCacheVersion = 1;
+
+struct TensorCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t count;
+    uint64_t source_size;      // 文本文件的字节数
+    int64_t source_mtime_ns;   // 文本文件的修改时间
+    uint64_t hash;             // 数据部分的哈希
+};
+
+bool cache_enabled() {
+    static const bool enabled = [] {
+        const char* env = std::getenv("BEVFUSION_WEIGHT_CACHE");
+        return !(env && std::strcmp(env, "0") == 0);
+    }();
+    return enabled;
+}
+
+uint64_t hash_floats(const float* data, size_t count) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    size_t bytes = count * sizeof(float);
+    uint64_t h = 0xcbf29ce484222325ull ^ bytes;
+    size_t i = 0;
+    for (; i + 8 <= bytes; i += 8) {
+        uint64_t w;
+        std::memcpy(&w, p + i, 8);
+        h = (h ^ w) * 0x9e3779b97f4a7c15ull;
+        h ^= h >> 29;
+    }
+    for (; i < bytes; ++i) h = (h ^ p[i]) * 0x100000001b3ull;
+    return h;
+}
+
+int64_t mtime_ns(const struct stat& st) {
+    return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+}
+
+bool read_fully(int fd, void* data, size_t bytes, off_t offset) {
+    char* p = static_cast<char*>(data);
+    while (bytes > 0) {
+        ssize_t n = pread(fd, p, bytes, offset);
+        if (n <= 0) return false;
+        p += n;
+        offset += n;
+        bytes -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool write_fully(int fd, const void* data, size_t bytes) {
+    const char* p = static_cast<const char*>(data);
+    while (bytes > 0) {
+        ssize_t n = ::write(fd, p, bytes);
+        if (n <= 0) return false;
+        p += n;
+        bytes -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool load_cache(const std::string& cache_path, const struct stat& source, float* data, size_t count) {
+    int fd = ::open(cache_path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    TensorCacheHeader h;
+    bool ok = read_fully(fd, &h, sizeof(h), 0) && h.magic == kTensorCacheMagic && h.version == kTensorCacheVersion &&
+              h.count == count && h.source_size == static_cast<uint64_t>(source.st_size) &&
+              h.source_mtime_ns == mtime_ns(source) && read_fully(fd, data, count * sizeof(float), sizeof(h)) &&
+              hash_floats(data, count) == h.hash;
+    ::close(fd);
+    return ok;
+}
+
+// 先写临时文件再改名，多个进程同时启动时不会读到写了一半的缓存
+void store_cache(const std::string& cache_path, const struct stat& source, const float* data, size_t count) {
+    std::string tmp = cache_path + ".tmp." + std::to_string(getpid());
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return;
+    TensorCacheHeader h{kTensorCacheMagic, kTensorCacheVersion, count, static_cast<uint64_t>(source.st_size),
+                        mtime_ns(source), hash_floats(data, count)};
+    bool ok = write_fully(fd, &h, sizeof(h)) && write_fully(fd, data, count * sizeof(float));
+    ::close(fd);
+    if (!ok || std::rename(tmp.c_str(), cache_path.c_str()) != 0) std::remove(tmp.c_str());
+}
+
+inline bool is_number_start(char c) {
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'n' || c == 'i' || c == 'N' || c == 'I';
+}
+
+}  // namespace
+
+bool parse_tensor_text(const char* p, const char* end, float* data, size_t count) {
+    size_t n = 0;
+    while (p < end) {
+        if (!is_number_start(*p)) {
+            ++p;
+            continue;
+        }
+        if (*p == '+') ++p;  // from_chars 不接受前导 +
+        float v;
+        std::from_chars_result r = std::from_chars(p, end, v);
+        if (r.ec == std::errc::invalid_argument) {
+            std::cerr << "文件中的数据无效: 第 " << n << " 个数值附近 \""
+                      << std::string(p, std::min<size_t>(16, end - p)) << "\"" << std::endl;
+            return false;
+        }
+        // 超出 float 范围时 from_chars 不写 v，与 std::stof 一样视为错误
+        if (r.ec == std::errc::result_out_of_range) {
+            std::cerr << "数据超出范围: 第 " << n << " 个数值" << std::endl;
+            return false;
+        }
+        if (n == count) {
+            std::cerr << "错误: 数据数量多于张量大小 " << count << std::endl;
+            return false;
+        }
+        data[n++] = v;
+        p = r.ptr;
+    }
+    if (n != count) {
+        std::cerr << "错误: 数据数量 " << n << " 与张量大小 " << count << " 不匹配" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool read_tensor_file(const std::string& path, float* data, size_t count, bool* cache_hit) {
+    if (cache_hit) *cache_hit = false;
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "无法打开文件: " << path << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        std::cerr << "文件为空或无法读取: " << path << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    std::string cache_path = path + ".f32";
+    if (cache_enabled() && load_cache(cache_path, st, data, count)) {
+        ::close(fd);
+        if (cache_hit) *cache_hit = true;
+        return true;
+    }
+
+    void* text = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (text == MAP_FAILED) {
+        std::cerr << "mmap 失败: " << path << std::endl;
+        return false;
+    }
+    madvise(text, st.st_size, MADV_SEQUENTIAL);
+    const char* begin = static_cast<const char*>(text);
+    bool ok = parse_tensor_text(begin, begin + st.st_size, data, count);
+    munmap(text, st.st_size);
+    if (!ok) {
+        std::cerr << "解析失败: " << path << std::endl;
+        return false;
+    }
+    if (cache_enabled()) store_cache(cache_path, st, data, count);
+    return true;
+}
+
+}  // namespace bevfusion
@@ -0,0 +1,42 @@
+#ifndef TENSOR_FILE_H
+#define TENSOR_FILE_H
+
+// 文本权重文件（PyTorch 导出的 {{...}, ...} 格式，数值带 f 后缀）的快速读取
+//
+// 文件整体 mmap 后单遍扫描，用 std::from_chars 解析，不分行、不建临时字符串；
+// 花括号、逗号、空白和 f 后缀都当作分隔符，数值按出现顺序写入连续的 float 缓冲。
+//
+// 解析结果缓存在同目录的 <文件名>.f32 中：消息头记录文本的大小、修改时间和数据的哈希，
+// 三者都匹配时直接读缓存，否则重新解析并覆盖缓存。目录不可写时只是不生成缓存。
+// 环境变量 BEVFUSION_WEIGHT_CACHE=0 关闭缓存（既不读也不写）。
+
+#include <cstddef>
+#include <string>
+#include <type_traits>
+
+namespace bevfusion {
+
+// 一个待读取的张量：从 path 读 count 个 float 到 data
+struct TensorFileJob {
+    std::string path;
+    float* data;
+    size_t count;
+};
+
+// 以 std::array 嵌套张量（或其他只含 float 的平凡类型）为目标构造读取任务
+template <typename Tensor>
+TensorFileJob tensor_file_job(const std::string& path, Tensor& tensor) {
+    static_assert(std::is_trivially_copyable<Tensor>::value && sizeof(Tensor) % sizeof(float) == 0,
+                  "张量必须是连续的 float 数组");
+    return TensorFileJob{path, reinterpret_cast<float*>(&tensor), sizeof(Tensor) / sizeof(float)};
+}
+
+// 解析 [begin, end) 中的全部数值，数量必须恰好为 count
+bool parse_tensor_text(const char* begin, const char* end, float* data, size_t count);
+
+// 读取单个文件（优先用缓存）；失败时打印原因并返回 false，data 内容未定义
+bool read_tensor_file(const std::string& path, float* data, size_t count, bool* cache_hit = nullptr);
+
+}  // namespace bevfusion
+
+#endif  // TENSOR_FILE_H
@@ -0,0 +1,223 @@
+#ifndef BEVFUSION_TRANSPORT_H
+#define BEVFUSION_TRANSPORT_H
+
+// chiplet 之间消息数据的传输后端
+//
+// 握手和计时（sendSync/receiveSync/readSync/writeSync）始终走 interchiplet，传输后端只负责搬数据：
+//   pipe  interchiplet 的命名管道（PipeComm），默认；
+//   shm   POSIX 共享内存槽位环（shm_ring.h），每个消息方向一个环，要求各进程在同一主机上。
+// 由环境变量 BEVFUSION_TRANSPORT 选择，所有进程必须一致；BEVFUSION_SHM_SLOT_MB 设置槽位大小（默认 16，
+// 须装得下最大的整块消息，即 13 MB 的相机图像），BEVFUSION_SHM_SLOTS 设置每个环的槽位数（默认 4），各进程须一致。
+//
+// write/read 是拷贝接口，两种后端都支持。shm 后端另有零拷贝接口 acquire_send/commit_send/acquire_receive/release_receive：
+// 发送方直接在槽位里写出消息，接收方原地读取；管道后端的 slot_bytes() 为 0，调用方据此改用拷贝接口。
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "band_stream.h"
+#include "pipe_comm.h"
+#include "shm_ring.h"
+
+namespace bevfusion {
+
+enum class TransportKind { Pipe, Shm };
+
+// 读取 BEVFUSION_TRANSPORT，进程内只解析一次
+inline TransportKind transport_kind() {
+    static const TransportKind kind = [] {
+        const char* env = std::getenv("BEVFUSION_TRANSPORT");
+        if (!env || !*env || std::strcmp(env, "pipe") == 0) return TransportKind::Pipe;
+        if (std::strcmp(env, "shm") == 0) return TransportKind::Shm;
+        std::cerr << "BEVFUSION_TRANSPORT 取值无效: " << env << "（可选 pipe / shm），使用 pipe" << std::endl;
+        return TransportKind::Pipe;
+    }();
+    return kind;
+}
+
+inline uint64_t shm_slot_bytes() {
+    static const uint64_t bytes = [] {
+        const char* env = std::getenv("BEVFUSION_SHM_SLOT_MB");
+        long mb = env && *env ? std::atol(env) : 16;
+        if (mb <= 0) {
+            std::cerr << "BEVFUSION_SHM_SLOT_MB 取值无效: " << env << "，使用 16" << std::endl;
+            mb = 16;
+        }
+        return static_cast<uint64_t>(mb) << 20;
+    }();
+    return bytes;
+}
+
+// 接收方同时占用的槽位：正在计算的一帧加上 I/O 线程已经收下的下一帧，相机骨干网络每帧两条消息，至少要 4 个
+inline uint32_t shm_num_slots() {
+    static const uint32_t slots = [] {
+        const char* env = std::getenv("BEVFUSION_SHM_SLOTS");
+        long n = env && *env ? std::atol(env) : 4;
+        if (n < 4 || n > 1024) {
+            std::cerr << "BEVFUSION_SHM_SLOTS 取值无效: " << env << "（4 ~ 1024），使用 4" << std::endl;
+            n = 4;
+        }
+        return static_cast<uint32_t>(n);
+    }();
+    return slots;
+}
+
+// 一个消息方向：src -> dst
+struct Route {
+    int src_x, src_y, dst_x, dst_y;
+
+    std::string shm_name() const {
+        return "/bevfusion_" + std::to_string(src_x) + "_" + std::to_string(src_y) + "_" + std::to_string(dst_x) + "_" +
+               std::to_string(dst_y);
+    }
+};
+
+class Transport {
+public:
+    virtual ~Transport() = default;
+
+    // 在第一次收发之前准备 route 方向的通道
+    virtual bool attach(const Route&) { return true; }
+
+    // file_name 为握手返回的管道名；abort() 之后返回 false，数据不完整
+    virtual bool write(const std::string& file_name, const Route& route, const IoPiece* pieces, int count) = 0;
+    virtual bool read(const std::string& file_name, const Route& route, const IoPiece* pieces, int count) = 0;
+
+    // 从本后端的 in 方向读 bytes 字节，原样写到 out 后端的 out_route 方向；默认经一块中转缓冲分段搬运
+    virtual bool forward(const std::string& in_file, const Route& in_route, Transport& out, const std::string& out_file,
+                         const Route& out_route, size_t bytes) {
+        bounce_.resize(std::min<size_t>(bytes, kBounceBytes));
+        while (bytes > 0) {
+            IoPiece piece{bounce_.data(), std::min(bytes, bounce_.size())};
+            if (!read(in_file, in_route, &piece, 1) || !out.write(out_file, out_route, &piece, 1)) return false;
+            bytes -= piece.bytes;
+        }
+        return true;
+    }
+
+    // 零拷贝接口可用的最大消息字节数，0 表示不支持（管道）
+    virtual size_t slot_bytes() const { return 0; }
+
+    // 发送方取得下一条消息的槽位，不握手，可以早于 commit_send 在另一个线程调用；
+    // file_name 为握手返回的管道名，commit_send 发布槽位中 bytes 字节的消息
+    virtual bool acquire_send(const Route&, ShmSlot*) { return false; }
+    virtual bool commit_send(const std::string& file_name, const Route&, const ShmSlot&, size_t bytes) { return false; }
+
+    // 接收方取得下一条消息所在的槽位并原地读取，读完 release_receive 归还（可在另一个线程调用）
+    virtual bool acquire_receive(const std::string& file_name, const Route&, ShmSlot*) { return false; }
+    virtual void release_receive(const Route&, const ShmSlot&) {}
+
+    // 让本进程中阻塞在收发上的线程尽快返回（可从其他线程调用），之后的收发都失败。
+    // 默认不做任何事：管道读写阻塞在 interchiplet 内部，只能等对端关闭或进程退出
+    virtual void abort() {}
+
+private:
+    static constexpr size_t kBounceBytes = 1 << 20;
+    std::vector<char> bounce_;
+};
+
+class PipeTransport : public Transport {
+public:
+    bool write(const std::string& file_name, const Route&, const IoPiece* pieces, int count) override {
+        for (int i = 0; i < count; ++i) comm_.write_data(file_name.c_str(), pieces[i].data, pieces[i].bytes);
+        return true;
+    }
+
+    bool read(const std::string& file_name, const Route&, const IoPiece* pieces, int count) override {
+        for (int i = 0; i < count; ++i) comm_.read_data(file_name.c_str(), pieces[i].data, pieces[i].bytes);
+        return true;
+    }
+
+private:
+    InterChiplet::PipeComm comm_;
+};
+
+// 共享内存槽位环。拷贝接口两端各拷贝一次；零拷贝接口不拷贝；主控转发时从上游的槽位直接拷进下游的槽位，只拷贝一次
+class ShmTransport : public Transport {
+public:
+    bool attach(const Route& route) override { return ring(route) != nullptr; }
+
+    bool write(const std::string&, const Route& route, const IoPiece* pieces, int count) override {
+        return ring(route)->write(pieces, count);
+    }
+
+    bool read(const std::string&, const Route& route, const IoPiece* pieces, int count) override {
+        return ring(route)->read(pieces, count);
+    }
+
+    bool forward(const std::string& in_file, const Route& in_route, Transport& out, const std::string& out_file,
+                 const Route& out_route, size_t bytes) override {
+        ShmTransport* shm_out = dynamic_cast<ShmTransport*>(&out);
+        if (!shm_out) return Transport::forward(in_file, in_route, out, out_file, out_route, bytes);
+        ShmRing* src = ring(in_route);
+        ShmRing* dst = shm_out->ring(out_route);
+        // 上游按发送方的槽位大小切分消息，各进程的槽位大小一致，逐个槽位搬运即可
+        while (bytes > 0) {
+            ShmSlot from, to;
+            if (!src->acquire_read(&from)) return false;
+            if (from.bytes > bytes || from.bytes > dst->slot_bytes()) {
+                std::cerr << "转发的消息比期望的长 " << from.bytes - std::min(from.bytes, bytes) << " 字节" << std::endl;
+                src->release_read(from);
+                return false;
+            }
+            if (!dst->acquire_write(&to)) return false;
+            std::memcpy(to.data, from.data, from.bytes);
+            dst->commit_write(to, from.bytes);
+            src->release_read(from);
+            bytes -= from.bytes;
+        }
+        return true;
+    }
+
+    size_t slot_bytes() const override { return shm_slot_bytes(); }
+
+    bool acquire_send(const Route& route, ShmSlot* slot) override { return ring(route)->acquire_write(slot); }
+
+    bool commit_send(const std::string&, const Route& route, const ShmSlot& slot, size_t bytes) override {
+        ring(route)->commit_write(slot, bytes);
+        return true;
+    }
+
+    bool acquire_receive(const std::string&, const Route& route, ShmSlot* slot) override {
+        return ring(route)->acquire_read(slot);
+    }
+
+    void release_receive(const Route& route, const ShmSlot& slot) override { ring(route)->release_read(slot); }
+
+    // 环在 attach 时已全部打开，之后 rings_ 不再增删，可以与收发线程并发遍历
+    void abort() override {
+        for (auto& entry : rings_) {
+            if (entry.second) entry.second->abort();
+        }
+    }
+
+private:
+    // 按方向打开环并缓存；失败时返回 nullptr（attach 已经报告过）。
+    // 两个方向都在 ChipletLink::open() 里打开，之后计算线程和 I/O 线程只查找、不插入
+    ShmRing* ring(const Route& route) {
+        const std::string name = route.shm_name();
+        auto it = rings_.find(name);
+        if (it != rings_.end()) return it->second.get();
+        std::unique_ptr<ShmRing> r(new ShmRing());
+        if (!r->open(name, shm_slot_bytes(), shm_num_slots())) r.reset();
+        return (rings_[name] = std::move(r)).get();
+    }
+
+    std::map<std::string, std::unique_ptr<ShmRing>> rings_;
+};
+
+inline std::unique_ptr<Transport> make_transport() {
+    if (transport_kind() == TransportKind::Shm) return std::unique_ptr<Transport>(new ShmTransport());
+    return std::unique_ptr<Transport>(new PipeTransport());
+}
+
+}  // namespace bevfusion
+
+#endif  // BEVFUSION_TRANSPORT_H
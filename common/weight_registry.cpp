@@ -0,0 +1,139 @@
+#include "weight_registry.h"
+
+#include <sys/resource.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+namespace bevfusion {
+
+double peak_rss_mb() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0.0;
+    return usage.ru_maxrss / 1024.0;  // Linux 上单位为 KB
+}
+
+double process_uptime_ms() {
+    // /proc/self/stat 第 22 项是进程启动时刻（开机后的时钟节拍数），comm 可能含空格，从最后一个 ')' 之后数
+    std::ifstream stat_file("/proc/self/stat");
+    std::ifstream uptime_file("/proc/uptime");
+    std::string stat((std::istreambuf_iterator<char>(stat_file)), std::istreambuf_iterator<char>());
+    double uptime_s = 0.0;
+    size_t paren = stat.rfind(')');
+    if (paren == std::string::npos || !(uptime_file >> uptime_s)) return 0.0;
+    std::istringstream fields(stat.substr(paren + 2));
+    std::string field;
+    for (int i = 3; i <= 22; ++i) fields >> field;
+    double start_s = std::strtod(field.c_str(), nullptr) / sysconf(_SC_CLK_TCK);
+    return (uptime_s - start_s) * 1000.0;
+}
+
+WeightRegistry::WeightRegistry(const char* name, const char* root_env, const char* subdir)
+    : name_(name), root_env_(root_env), subdir_(subdir), created_(std::chrono::steady_clock::now()) {}
+
+WeightRegistry::~WeightRegistry() {
+    for (std::thread& t : prefetchers_) t.join();
+}
+
+void WeightRegistry::add(int group, const std::string& file_name, float* data, size_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.push_back(Entry{group, file_name, data, count, nullptr});
+}
+
+void WeightRegistry::add(int group, const std::string& file_name, size_t count,
+                         std::function<void(const float*)> unpack) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.push_back(Entry{group, file_name, nullptr, count, std::move(unpack)});
+}
+
+// 第一次读取时才查环境变量，未设置时报告一次，之后所有读取都失败
+bool WeightRegistry::resolve_root() {
+    if (!root_resolved_) {
+        root_resolved_ = true;
+        const char* root = std::getenv(root_env_);
+        root_ok_ = root && *root;
+        if (root_ok_) {
+            root_ = std::string(root) + "/" + subdir_ + "/";
+        } else {
+            std::cerr << name_ << ": 未设置环境变量 " << root_env_ << "，无法读取权重" << std::endl;
+        }
+    }
+    return root_ok_;
+}
+
+void WeightRegistry::load(size_t i, std::unique_lock<std::mutex>& lock) {
+    entries_[i].state = State::Loading;
+    bool ok = resolve_root();
+    std::string path = root_ + entries_[i].file_name;
+    float* data = entries_[i].data;
+    size_t count = entries_[i].count;
+    std::function<void(const float*)> unpack = entries_[i].unpack;
+    lock.unlock();
+    if (unpack) {
+        std::vector<float> staging(ok ? count : 0);
+        ok = ok && read_tensor_file(path, staging.data(), count);
+        if (ok) unpack(staging.data());
+    } else {
+        ok = ok && read_tensor_file(path, data, count);
+    }
+    lock.lock();
+    entries_[i].state = ok ? State::Loaded : State::Failed;
+    loaded_++;
+    if (ok) bytes_ += count * sizeof(float);
+    failed_ = failed_ || !ok;
+    if (loaded_ == entries_.size() && !failed_ && !reported_) {
+        reported_ = true;
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - created_).count();
+        std::cout << name_ << " 权重就绪: " << entries_.size() << " 个张量, " << bytes_ / 1048576.0 << " MB, 读取 " << ms
+                  << " ms, 距进程启动 " << process_uptime_ms() << " ms, 峰值 RSS " << peak_rss_mb() << " MB" << std::endl;
+    }
+    cv_.notify_all();
+}
+
+bool WeightRegistry::require_entry(size_t i, std::unique_lock<std::mutex>& lock) {
+    if (entries_[i].state == State::Pending) load(i, lock);
+    cv_.wait(lock, [&] { return entries_[i].state == State::Loaded || entries_[i].state == State::Failed; });
+    return entries_[i].state == State::Loaded;
+}
+
+void WeightRegistry::prefetch() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!prefetchers_.empty()) return;
+    // 大张量先读，各线程的结束时间更接近
+    auto order = std::make_shared<std::vector<size_t>>(entries_.size());
+    for (size_t i = 0; i < order->size(); ++i) (*order)[i] = i;
+    std::stable_sort(order->begin(), order->end(), [&](size_t a, size_t b) { return entries_[a].count > entries_[b].count; });
+    size_t num_threads = std::min<size_t>(entries_.size(), std::max(1u, std::thread::hardware_concurrency()));
+    for (size_t t = 0; t < num_threads; ++t) {
+        prefetchers_.emplace_back([this, order] {
+            std::unique_lock<std::mutex> lock(mutex_);
+            for (size_t i : *order) {
+                if (entries_[i].state == State::Pending) load(i, lock);
+            }
+        });
+    }
+}
+
+bool WeightRegistry::require(int group) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    bool ok = true;
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        if (entries_[i].group == group) ok = require_entry(i, lock) && ok;
+    }
+    return ok;
+}
+
+bool WeightRegistry::require_all() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    bool ok = true;
+    for (size_t i = 0; i < entries_.size(); ++i) ok = require_entry(i, lock) && ok;
+    return ok;
+}
+
+}  // namespace bevfusion
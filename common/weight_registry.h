@@ -0,0 +1,97 @@
+#ifndef WEIGHT_REGISTRY_H
+#define WEIGHT_REGISTRY_H
+
+// 阶段权重的登记表
+//
+// 各阶段把权重张量（目标内存 + 相对 $root_env/subdir 的文件名）按分组登记进来，登记时不读文件、不查环境变量。
+// 之后两种读取方式可以混用：
+//   require(group)  首次使用前在当前线程读取该组（已在后台读取中则等待），之后直接返回；
+//   prefetch()      启动后台线程读取全部张量，立即返回。阶段进程在等第一帧输入时调用，读文件与握手等待重叠。
+// 每个张量只读一次，直接写入登记的目标内存，不保留临时副本（需要重排的张量读入临时缓冲、重排后即释放）。读取用 tensor_file.h（含解析缓存）。
+// 全部张量就绪时打印一次读取耗时、距进程启动的时间和当时的峰值 RSS。
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tensor_file.h"
+
+namespace bevfusion {
+
+// 进程的峰值常驻内存 (MB)，即 getrusage 的 ru_maxrss
+double peak_rss_mb();
+
+// 进程启动至今的时间 (ms)，读取 /proc 失败时返回 0
+double process_uptime_ms();
+
+class WeightRegistry {
+public:
+    // name: 打印用的阶段名；文件路径为 $root_env/subdir/<文件名>
+    WeightRegistry(const char* name, const char* root_env, const char* subdir);
+    ~WeightRegistry();
+    WeightRegistry(const WeightRegistry&) = delete;
+    WeightRegistry& operator=(const WeightRegistry&) = delete;
+
+    void add(int group, const std::string& file_name, float* data, size_t count);
+
+    // 文件内容与计算用的布局不同时（例如按输入通道拆成几块）：读入临时缓冲后交给 unpack 写到目标位置，
+    // 随即释放临时缓冲，进程里只保留拆分后的一份
+    void add(int group, const std::string& file_name, size_t count, std::function<void(const float*)> unpack);
+
+    template <typename Tensor>
+    void add(int group, const std::string& file_name, Tensor& tensor) {
+        TensorFileJob job = tensor_file_job(file_name, tensor);
+        add(group, job.path, job.data, job.count);
+    }
+
+    // 后台读取全部张量，重复调用无效果
+    void prefetch();
+
+    // 确保 group 组的张量都已读入；任一读取失败返回 false
+    bool require(int group);
+    bool require_all();
+
+private:
+    enum class State { Pending, Loading, Loaded, Failed };
+
+    struct Entry {
+        int group;
+        std::string file_name;
+        float* data;
+        size_t count;
+        std::function<void(const float*)> unpack;   // 非空时 data 为 nullptr
+        State state = State::Pending;
+    };
+
+    // 读取第 i 项，调用时持有 lock 且该项为 Pending；读取期间释放锁
+    void load(size_t i, std::unique_lock<std::mutex>& lock);
+    bool require_entry(size_t i, std::unique_lock<std::mutex>& lock);
+    bool resolve_root();
+
+    const char* name_;
+    const char* root_env_;
+    const char* subdir_;
+    std::string root_;
+    bool root_resolved_ = false;
+    bool root_ok_ = false;
+
+    std::vector<Entry> entries_;
+    size_t loaded_ = 0;
+    size_t bytes_ = 0;
+    bool failed_ = false;
+    bool reported_ = false;
+    std::chrono::steady_clock::time_point created_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<std::thread> prefetchers_;
+};
+
+}  // namespace bevfusion
+
+#endif  // WEIGHT_REGISTRY_H
@@ -0,0 +1,141 @@
+#include "conv_chain.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+constexpr int kMaxWidth = 512;
+
+// 按行访问的特征图: 普通张量 (ring == 0) 或 ring 行的环形缓冲
+struct RowBuffer {
+    float* base;
+    size_t channel_stride;
+    int ring;
+    int width;
+
+    float* row(int c, int r) const {
+        int slot = ring ? r % ring : r;
+        return base + c * channel_stride + static_cast<size_t>(slot) * width;
+    }
+};
+
+// 计算一层的输出行 [r0, r1)，越界的输入行按 0 填充
+void conv3x3_relu_rows(const ChainLayer& L, int height, int width, const RowBuffer& in, const RowBuffer& out,
+                       int r0, int r1) {
+    #pragma omp parallel for
+    for (int m = 0; m < L.cout; ++m) {
+        float acc[kMaxWidth];
+        const float* wm = L.weight + static_cast<size_t>(m) * L.cin * 9;
+        for (int r = r0; r < r1; ++r) {
+            std::fill(acc, acc + width, L.bias[m]);
+            for (int c = 0; c < L.cin; ++c) {
+                for (int k0 = 0; k0 < 3; ++k0) {
+                    int ii0 = r - 1 + k0;
+                    if (ii0 < 0 || ii0 >= height) continue;
+                    const float* src = in.row(c, ii0);
+                    for (int k1 = 0; k1 < 3; ++k1) {
+                        const float w = wm[c * 9 + k0 * 3 + k1];
+                        int x_begin = k1 == 0 ? 1 : 0;
+                        int x_end = k1 == 2 ? width - 1 : width;
+                        const float* s = src + k1 - 1;
+                        for (int x = x_begin; x < x_end; ++x) acc[x] += s[x] * w;
+                    }
+                }
+            }
+            float* dst = out.row(m, r);
+            for (int x = 0; x < width; ++x) dst[x] = acc[x] > 0 ? acc[x] : 0;
+        }
+    }
+}
+
+size_t plane_bytes(int channels, int height, int width) {
+    return static_cast<size_t>(channels) * height * width * sizeof(float);
+}
+
+size_t weight_bytes(const ChainLayer& L) {
+    return (static_cast<size_t>(L.cout) * L.cin * 9 + L.cout) * sizeof(float);
+}
+
+}  // namespace
+
+int conv_chain_tile_rows(const std::vector<ChainLayer>& layers, int width) {
+    const char* env = std::getenv("BEVFUSION_FUSER_TILE_ROWS");
+    if (env && *env) return std::atoi(env);
+
+    long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if (l2 <= 0) l2 = 1 << 20;
+    // 一半留给权重流和其他数据；层内热数据是输入的 (T+2) 行加输出的 T 行
+    size_t budget = static_cast<size_t>(l2) / 2;
+    int rows = 1 << 30;
+    for (size_t l = 0; l < layers.size(); ++l) {
+        size_t in_row = static_cast<size_t>(layers[l].cin) * width * sizeof(float);
+        size_t out_row = static_cast<size_t>(layers[l].cout) * width * sizeof(float);
+        long t = budget > 2 * in_row ? static_cast<long>((budget - 2 * in_row) / (in_row + out_row)) : 1;
+        rows = std::min<long>(rows, std::max<long>(t, 1));
+    }
+    return std::max(rows, 1);
+}
+
+ChainStats run_conv_chain(const std::vector<ChainLayer>& layers, int height, int width, int tile_rows,
+                          const float* input, float* output) {
+    const int num_layers = static_cast<int>(layers.size());
+    const int T = std::max(1, std::min(tile_rows, height));
+    const int R = T + 2;
+    if (width > kMaxWidth) {
+        std::cerr << "conv chain: width " << width << " 超过上限 " << kMaxWidth << std::endl;
+        return ChainStats();
+    }
+
+    // 第 l 层 (l < num_layers-1) 的输出环形缓冲
+    std::vector<std::vector<float>> rings(num_layers - 1);
+    for (int l = 0; l + 1 < num_layers; ++l) rings[l].assign(static_cast<size_t>(layers[l].cout) * R * width, 0.0f);
+
+    int bands = 0;
+    // 第 k 步时第 l 层计算输出行 [kT - l, kT - l + T)；最后一层写到 output。
+    // 第 0 层在第 k+1 步最早读到输入行 (k+1)T - 1，而此时 output 只写到 kT + T - num_layers 行，
+    // 所以 num_layers >= 2 时原地执行是安全的
+    for (int k = 0; k * T - (num_layers - 1) < height; ++k) {
+        for (int l = 0; l < num_layers; ++l) {
+            int r0 = std::max(k * T - l, 0);
+            int r1 = std::min(k * T - l + T, height);
+            if (r0 >= r1) continue;
+            RowBuffer in = l == 0 ? RowBuffer{const_cast<float*>(input), static_cast<size_t>(height) * width, 0, width}
+                                  : RowBuffer{rings[l - 1].data(), static_cast<size_t>(R) * width, R, width};
+            RowBuffer out = l == num_layers - 1 ? RowBuffer{output, static_cast<size_t>(height) * width, 0, width}
+                                                : RowBuffer{rings[l].data(), static_cast<size_t>(R) * width, R, width};
+            conv3x3_relu_rows(layers[l], height, width, in, out, r0, r1);
+        }
+        ++bands;
+    }
+
+    ChainStats s;
+    s.tile_rows = T;
+    s.bands = bands;
+    size_t weights_total = 0;
+    for (int l = 0; l < num_layers; ++l) {
+        const ChainLayer& L = layers[l];
+        weights_total += weight_bytes(L);
+        size_t in = plane_bytes(L.cin, height, width);
+        size_t out = plane_bytes(L.cout, height, width);
+        s.layerwise_working_set_bytes = std::max(s.layerwise_working_set_bytes, in + out + weight_bytes(L));
+        s.layerwise_dram_bytes += in + 3 * out;
+        if (l + 1 < num_layers) s.working_set_bytes += rings[l].size() * sizeof(float);
+    }
+    s.working_set_bytes += weights_total;
+    s.dram_bytes = plane_bytes(layers.front().cin, height, width) + plane_bytes(layers.back().cout, height, width);
+    s.weight_reload_bytes = weights_total * bands;
+    return s;
+}
+
+void print_chain_stats(const char* name, int num_layers, const ChainStats& s) {
+    const double MB = 1024.0 * 1024.0;
+    std::printf("%s: %d 层, 行带 %d 行 x %d, 峰值工作集 %.1f MB (逐层 %.1f MB), "
+                "估计 DRAM 流量 %.1f MB (逐层 %.1f MB), 权重重读 %.1f MB\n",
+                name, num_layers, s.tile_rows, s.bands, s.working_set_bytes / MB, s.layerwise_working_set_bytes / MB,
+                s.dram_bytes / MB, s.layerwise_dram_bytes / MB, s.weight_reload_bytes / MB);
+}
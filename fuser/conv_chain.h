@@ -0,0 +1,44 @@
+#ifndef CONV_CHAIN_H
+#define CONV_CHAIN_H
+
+// 3×3 卷积链的深度优先分块执行
+//
+// 逐层执行时每层都要把整张 C×H×W 特征图写回内存再读出来（128×180×180 即 16.6 MB），
+// 远超 L2/L3。这里把特征图按行切成高度为 tile_rows 的行带，一个行带穿过链上所有层后再处理下一个:
+// 第 l 层比最后一层超前 l 行，层与层之间只保留 (tile_rows + 2) 行的环形缓冲，
+// 上一行带末尾的 2 行留在环里作为下一行带的 halo，不需要重算。
+// 每层的 ReLU 融合在卷积输出里，累加顺序与 onnx2c 生成的逐层实现相同。
+
+#include <cstddef>
+#include <vector>
+
+// 链上的一层: 3×3、stride 1、pad 1 卷积，后接 ReLU
+struct ChainLayer {
+    int cin;
+    int cout;
+    const float* weight;  // [cout][cin][3][3]
+    const float* bias;    // [cout]
+};
+
+// 一次执行的统计，流量均为估计值（假设整张特征图放不进末级缓存、权重能留在 L3）
+struct ChainStats {
+    int tile_rows = 0;
+    int bands = 0;
+    size_t working_set_bytes = 0;            // 分块: 环形行缓冲 + 链上全部权重
+    size_t layerwise_working_set_bytes = 0;  // 逐层: max(输入 + 输出 + 本层权重)
+    size_t dram_bytes = 0;                   // 分块: 读一次输入 + 写一次输出
+    size_t layerwise_dram_bytes = 0;         // 逐层: 每层 读输入、写卷积结果、ReLU 读写各一次
+    size_t weight_reload_bytes = 0;          // 分块: 每个行带重新从 L3 读一遍权重
+};
+
+// 根据 L2 大小选择行带高度；环境变量 BEVFUSION_FUSER_TILE_ROWS 可强制指定
+int conv_chain_tile_rows(const std::vector<ChainLayer>& layers, int width);
+
+// 执行整条链。input: [layers[0].cin][height][width]，output: [layers.back().cout][height][width]，
+// 层数 >= 2 时 input 与 output 可以是同一块内存
+ChainStats run_conv_chain(const std::vector<ChainLayer>& layers, int height, int width, int tile_rows,
+                          const float* input, float* output);
+
+void print_chain_stats(const char* name, int num_layers, const ChainStats& s);
+
+#endif  // CONV_CHAIN_H
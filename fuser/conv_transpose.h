@@ -0,0 +1,47 @@
+#ifndef CONV_TRANSPOSE_H
+#define CONV_TRANSPOSE_H
+
+// kernel == stride、pad 0 的转置卷积
+//
+// 输出位置 (i0*s + k0, i1*s + k1) 只由输入 (i0, i1) 和权重 (k0, k1) 决定，s×s 个核位置互不重叠，
+// 每个核位置就是一个 1×1 卷积 (Cout×Cin)·(Cin×H·W)。这 s×s 个 GEMM 共用同一个输入，
+// 把它们沿 M 方向叠成一个 (Cout·s·s × Cin)·(Cin × H·W) 的 GEMM，输入只读一遍。
+// 结果在 epilogue 中直接散射到交错位置，输出每个元素恰好写一次，不需要先 memset。
+
+#include <cstddef>
+
+#include "gemm.h"
+
+// x: [cin][h][w]，weight: [cin][cout][s][s]（ONNX ConvTranspose 布局），y: [cout][h*s][w*s]
+// epi(m, v) 返回通道 m 上累加值 v 的最终输出，用来融合 BN、ReLU 等逐通道运算
+template <typename Epi>
+void conv_transpose_nonoverlap(int cin, int cout, int h, int w, int s, const float* x, const float* weight,
+                               float* y, Epi epi) {
+    const int ss = s * s;
+    const int out_w = w * s;
+    const size_t out_plane = static_cast<size_t>(h) * s * out_w;
+
+    // A 的第 r 行 = (m, k0, k1)，r = m*s*s + k0*s + k1，A(r, c) = weight[c][m][k0][k1]
+    bevfusion::MatrixView A{weight, 1, static_cast<ptrdiff_t>(cout) * ss};
+    bevfusion::MatrixView B{x, static_cast<ptrdiff_t>(h) * w, 1};
+
+    bevfusion::sgemm(cout * ss, h * w, cin, A, B, [&](int r0, int n0, int rows, int cols, const float* tile, int ld) {
+        for (int i = 0; i < rows; ++i) {
+            const int r = r0 + i;
+            const int m = r / ss;
+            const int k0 = (r / s) % s;
+            const int k1 = r % s;
+            float* ym = y + m * out_plane + k0 * out_w + k1;
+            int i0 = n0 / w, i1 = n0 % w;
+            for (int j = 0; j < cols; ++j) {
+                ym[static_cast<size_t>(i0) * s * out_w + i1 * s] = epi(m, tile[i * ld + j]);
+                if (++i1 == w) {
+                    i1 = 0;
+                    ++i0;
+                }
+            }
+        }
+    });
+}
+
+#endif  // CONV_TRANSPOSE_H
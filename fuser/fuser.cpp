@@ -15,94 +15,68 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
+#include <stdlib.h>
+#include <iostream>
 //#include <half.hpp>
-#include "readTensorFromFile.h"
+#include "weight_registry.h"
 #include "fuser.h"
-#include "pipe_comm.h"
-#include "apis_c.h"
+#include "kernels.h"
+#include "conv_chain.h"
+#include "conv_transpose.h"
+#include "pointwise_conv.h"
+#include "band_stream.h"
 
-InterChiplet::PipeComm global_pipe_comm;
 #define MAX(X,Y) ( X > Y ? X : Y)
 #define MIN(X,Y) ( X < Y ? X : Y)
 #define CLIP(X,L) ( MAX(MIN(X,L), -L) )
 
-/*
- * Operand:           Concat
- * Name in ONNX file: Concat_0
- */
-static inline void node_Concat_0( const float input_0[1][80][180][180], const float input_1[1][256][180][180], float output[1][336][180][180] )
-{
-	/* Concat */
-	int64_t outputOffset;
-	outputOffset = 0;
-	for (int64_t i = 0, j = 0; i < 2592000; i++) {
-		*((float*)output + (outputOffset + i)) = *((float*)input_0 + i);
-		if (++j == 2592000) {
-			outputOffset += (8294400);
-			j = 0;
-		}
-	}
-	outputOffset = 2592000;
-	for (int64_t i = 0, j = 0; i < 8294400; i++) {
-		*((float*)output + (outputOffset + i)) = *((float*)input_1 + i);
-		if (++j == 8294400) {
-			outputOffset += (2592000);
-			j = 0;
-		}
-	}
-}
-
 /*
  * Operand:           Conv
  * Name in ONNX file: Conv_1
  */
-static inline void node_Conv_1( const float x[1][336][180][180], const float w[256][336][3][3], const float bias[256], float y[1][256][180][180] )
-{
-	/* Conv
-	 *
-	 * auto_pad: NOTSET
-	 * dilations: 1 1 
-	 * group: 1
-	 * kernel_shape: 3 3 
-	 * pads: 1 1 1 1 
-	 * strides: 1 1 
-	 */
-	for( uint32_t b=0; b<1; b++ ) {
-	for( uint32_t m=0; m<256; m++) {
-		for( int32_t o0=0, i0=-1; o0<180; o0++, i0+=1) {
-		for( int32_t o1=0, i1=-1; o1<180; o1++, i1+=1) {
-			y[b][m][o0][o1] = bias[m];
-			for( int32_t c=0; c<336; c++ ) {
-			for( uint32_t k0=0; k0<3; k0++ ) {
-			for( uint32_t k1=0; k1<3; k1++ ) {
-				int ii0 = i0+k0 * 1;
-				if( ii0<0) continue;
-				if( ii0>=180) continue;
-				int ii1 = i1+k1 * 1;
-				if( ii1<0) continue;
-				if( ii1>=180) continue;
-				y[b][m][o0][o1] += x[b][c][ii0][ii1] *w[m][c][k0][k1];
-			} /* k */
+/* Conv_1 作用在 camera (80) 与 lidar (256) 两路的 Concat_0 上，按输入通道拆成两个部分和：
+ *   Conv_1(concat(camera, lidar)) = conv(camera, W[:, :80]) + conv(lidar, W[:, 80:]) + bias
+ * 不再生成 336 通道的拼接张量。bias 非空时输出行先置为 bias，否则累加到已有的部分和上。
+ * 只计算输出行 [row0, row1)，需要输入行 [row0-1, row1] 已就绪；3×3、pad 1、stride 1
+ */
+static inline void node_Conv_1_part( const float* x, int32_t cin, const float* w, const float* bias, float y[1][256][180][180], int32_t row0, int32_t row1 )
+{
+	#pragma omp parallel for
+	for( int32_t m=0; m<256; m++) {
+		float acc[180];
+		const float* wm = w + (size_t)m * cin * 9;
+		for( int32_t r=row0; r<row1; r++) {
+			float* dst = &y[0][m][r][0];
+			for( int32_t o1=0; o1<180; o1++) acc[o1] = bias ? bias[m] : dst[o1];
+			for( int32_t c=0; c<cin; c++ ) {
+			for( int32_t k0=0; k0<3; k0++ ) {
+				int32_t ii0 = r-1+k0;
+				if( ii0<0 || ii0>=180) continue;
+				const float* src = x + ((size_t)c * 180 + ii0) * 180;
+				for( int32_t k1=0; k1<3; k1++ ) {
+					const float wv = wm[c * 9 + k0 * 3 + k1];
+					int32_t begin = k1 == 0 ? 1 : 0;
+					int32_t end = k1 == 2 ? 179 : 180;
+					const float* s = src + k1 - 1;
+					for( int32_t o1=begin; o1<end; o1++) acc[o1] += s[o1] * wv;
+				} /* k */
 			} /* k */
 			} /* c */
-		} /* o */
+			memcpy(dst, acc, sizeof(acc));
 		} /* o */
 	} /* m */
-	} /* b */
 }
 
 /*
  * Operand:           Relu
  * Name in ONNX file: Relu_2
  */
-static inline void node_Relu_2( const float X[1][256][180][180], float Y[1][256][180][180] )
+static inline void node_Relu_2( const float X[1][256][180][180], float Y[1][256][180][180], int32_t row0, int32_t row1 )
 {
-	/*Relu*/
-	float *X_ptr = (float*)X;
-	float *Y_ptr = (float*)Y;
-	for( uint32_t i=0; i<8294400; i++ )
-		Y_ptr[i] = X_ptr[i] > 0 ? X_ptr[i] : 0;
-
+	/*Relu，只处理 [row0, row1) 行*/
+	for( int32_t c=0; c<256; c++ ) {
+		bevfusion::relu(&X[0][c][row0][0], &Y[0][c][row0][0], (size_t)(row1 - row0) * 180);
+	}
 }
 
 /*
@@ -121,6 +95,7 @@ static inline void node_Conv_3( const float x[1][256][180][180], const float w[1
 	 * strides: 1 1 
 	 */
 	for( uint32_t b=0; b<1; b++ ) {
+	#pragma omp parallel for
 	for( uint32_t m=0; m<128; m++) {
 		for( int32_t o0=0, i0=-1; o0<180; o0++, i0+=1) {
 		for( int32_t o1=0, i1=-1; o1<180; o1++, i1+=1) {
@@ -151,10 +126,7 @@ static inline void node_Conv_3( const float x[1][256][180][180], const float w[1
 static inline void node_Relu_4( const float X[1][128][180][180], float Y[1][128][180][180] )
 {
 	/*Relu*/
-	float *X_ptr = (float*)X;
-	float *Y_ptr = (float*)Y;
-	for( uint32_t i=0; i<4147200; i++ )
-		Y_ptr[i] = X_ptr[i] > 0 ? X_ptr[i] : 0;
+	bevfusion::relu((const float*)X, (float*)Y, 4147200);
 
 }
 
@@ -174,6 +146,7 @@ static inline void node_Conv_5( const float x[1][128][180][180], const float w[1
 	 * strides: 1 1 
 	 */
 	for( uint32_t b=0; b<1; b++ ) {
+	#pragma omp parallel for
 	for( uint32_t m=0; m<128; m++) {
 		for( int32_t o0=0, i0=-1; o0<180; o0++, i0+=1) {
 		for( int32_t o1=0, i1=-1; o1<180; o1++, i1+=1) {
@@ -204,10 +177,7 @@ static inline void node_Conv_5( const float x[1][128][180][180], const float w[1
 static inline void node_Relu_6( const float X[1][128][180][180], float Y[1][128][180][180] )
 {
 	/*Relu*/
-	float *X_ptr = (float*)X;
-	float *Y_ptr = (float*)Y;
-	for( uint32_t i=0; i<4147200; i++ )
-		Y_ptr[i] = X_ptr[i] > 0 ? X_ptr[i] : 0;
+	bevfusion::relu((const float*)X, (float*)Y, 4147200);
 
 }
 
@@ -227,6 +197,7 @@ static inline void node_Conv_7( const float x[1][128][180][180], const float w[1
 	 * strides: 1 1 
 	 */
 	for( uint32_t b=0; b<1; b++ ) {
+	#pragma omp parallel for
 	for( uint32_t m=0; m<128; m++) {
 		for( int32_t o0=0, i0=-1; o0<180; o0++, i0+=1) {
 		for( int32_t o1=0, i1=-1; o1<180; o1++, i1+=1) {
@@ -257,10 +228,7 @@ static inline void node_Conv_7( const float x[1][128][180][180], const float w[1
 static inline void node_Relu_8( const float X[1][128][180][180], float Y[1][128][180][180] )
 {
 	/*Relu*/
-	float *X_ptr = (float*)X;
-	float *Y_ptr = (float*)Y;
-	for( uint32_t i=0; i<4147200; i++ )
-		Y_ptr[i] = X_ptr[i] > 0 ? X_ptr[i] : 0;
+	bevfusion::relu((const float*)X, (float*)Y, 4147200);
 
 }
 
@@ -280,6 +248,7 @@ static inline void node_Conv_9( const float x[1][128][180][180], const float w[1
 	 * strides: 1 1 
 	 */
 	for( uint32_t b=0; b<1; b++ ) {
+	#pragma omp parallel for
 	for( uint32_t m=0; m<128; m++) {
 		for( int32_t o0=0, i0=-1; o0<180; o0++, i0+=1) {
 		for( int32_t o1=0, i1=-1; o1<180; o1++, i1+=1) {
@@ -310,10 +279,7 @@ static inline void node_Conv_9( const float x[1][128][180][180], const float w[1
 static inline void node_Relu_10( const float X[1][128][180][180], float Y[1][128][180][180] )
 {
 	/*Relu*/
-	float *X_ptr = (float*)X;
-	float *Y_ptr = (float*)Y;
-	for( uint32_t i=0; i<4147200; i++ )
-		Y_ptr[i] = X_ptr[i] > 0 ? X_ptr[i] : 0;
+	bevfusion::relu((const float*)X, (float*)Y, 4147200);
 
 }
 
@@ -333,6 +299,7 @@ static inline void node_Conv_11( const float x[1][128][180][180], const float w[
 	 * strides: 1 1 
 	 */
 	for( uint32_t b=0; b<1; b++ ) {
+	#pragma omp parallel for
 	for( uint32_t m=0; m<128; m++) {
 		for( int32_t o0=0, i0=-1; o0<180; o0++, i0+=1) {
 		for( int32_t o1=0, i1=-1; o1<180; o1++, i1+=1) {
@@ -363,10 +330,7 @@ static inline void node_Conv_11( const float x[1][128][180][180], const float w[
 static inline void node_Relu_12( const float X[1][128][180][180], float Y[1][128][180][180] )
 {
 	/*Relu*/
-	float *X_ptr = (float*)X;
-	float *Y_ptr = (float*)Y;
-	for( uint32_t i=0; i<4147200; i++ )
-		Y_ptr[i] = X_ptr[i] > 0 ? X_ptr[i] : 0;
+	bevfusion::relu((const float*)X, (float*)Y, 4147200);
 
 }
 
@@ -386,6 +350,7 @@ static inline void node_Conv_13( const float x[1][128][180][180], const float w[
 	 * strides: 1 1 
 	 */
 	for( uint32_t b=0; b<1; b++ ) {
+	#pragma omp parallel for
 	for( uint32_t m=0; m<128; m++) {
 		for( int32_t o0=0, i0=-1; o0<180; o0++, i0+=1) {
 		for( int32_t o1=0, i1=-1; o1<180; o1++, i1+=1) {
@@ -416,10 +381,7 @@ static inline void node_Conv_13( const float x[1][128][180][180], const float w[
 static inline void node_Relu_14( const float X[1][128][180][180], float Y[1][128][180][180] )
 {
 	/*Relu*/
-	float *X_ptr = (float*)X;
-	float *Y_ptr = (float*)Y;
-	for( uint32_t i=0; i<4147200; i++ )
-		Y_ptr[i] = X_ptr[i] > 0 ? X_ptr[i] : 0;
+	bevfusion::relu((const float*)X, (float*)Y, 4147200);
 
 }
 
@@ -439,6 +401,7 @@ static inline void node_Conv_15( const float x[1][128][180][180], const float w[
 	 * strides: 2 2 
 	 */
 	for( uint32_t b=0; b<1; b++ ) {
+	#pragma omp parallel for
 	for( uint32_t m=0; m<256; m++) {
 		for( int32_t o0=0, i0=-1; o0<90; o0++, i0+=2) {
 		for( int32_t o1=0, i1=-1; o1<90; o1++, i1+=2) {
@@ -469,10 +432,7 @@ static inline void node_Conv_15( const float x[1][128][180][180], const float w[
 static inline void node_Relu_16( const float X[1][256][90][90], float Y[1][256][90][90] )
 {
 	/*Relu*/
-	float *X_ptr = (float*)X;
-	float *Y_ptr = (float*)Y;
-	for( uint32_t i=0; i<2073600; i++ )
-		Y_ptr[i] = X_ptr[i] > 0 ? X_ptr[i] : 0;
+	bevfusion::relu((const float*)X, (float*)Y, 2073600);
 
 }
 
@@ -492,6 +452,7 @@ static inline void node_Conv_17( const float x[1][256][90][90], const float w[25
 	 * strides: 1 1 
 	 */
 	for( uint32_t b=0; b<1; b++ ) {
+	#pragma omp parallel for
 	for( uint32_t m=0; m<256; m++) {
 		for( int32_t o0=0, i0=-1; o0<90; o0++, i0+=1) {
 		for( int32_t o1=0, i1=-1; o1<90; o1++, i1+=1) {
@@ -522,10 +483,7 @@ static inline void node_Conv_17( const float x[1][256][90][90], const float w[25
 static inline void node_Relu_18( const float X[1][256][90][90], float Y[1][256][90][90] )
 {
 	/*Relu*/
-	float *X_ptr = (float*)X;
-	float *Y_ptr = (float*)Y;
-	for( uint32_t i=0; i<2073600; i++ )
-		Y_ptr[i] = X_ptr[i] > 0 ? X_ptr[i] : 0;
+	bevfusion::relu((const float*)X, (float*)Y, 2073600);
 
 }
 
@@ -545,6 +503,7 @@ static inline void node_Conv_19( const float x[1][256][90][90], const float w[25
 	 * strides: 1 1 
 	 */
 	for( uint32_t b=0; b<1; b++ ) {
+	#pragma omp parallel for
 	for( uint32_t m=0; m<256; m++) {
 		for( int32_t o0=0, i0=-1; o0<90; o0++, i0+=1) {
 		for( int32_t o1=0, i1=-1; o1<90; o1++, i1+=1) {
@@ -575,10 +534,7 @@ static inline void node_Conv_19( const float x[1][256][90][90], const float w[25
 static inline void node_Relu_20( const float X[1][256][90][90], float Y[1][256][90][90] )
 {
 	/*Relu*/
-	float *X_ptr = (float*)X;
-	float *Y_ptr = (float*)Y;
-	for( uint32_t i=0; i<2073600; i++ )
-		Y_ptr[i] = X_ptr[i] > 0 ? X_ptr[i] : 0;
+	bevfusion::relu((const float*)X, (float*)Y, 2073600);
 
 }
 
@@ -598,6 +554,7 @@ static inline void node_Conv_21( const float x[1][256][90][90], const float w[25
 	 * strides: 1 1 
 	 */
 	for( uint32_t b=0; b<1; b++ ) {
+	#pragma omp parallel for
 	for( uint32_t m=0; m<256; m++) {
 		for( int32_t o0=0, i0=-1; o0<90; o0++, i0+=1) {
 		for( int32_t o1=0, i1=-1; o1<90; o1++, i1+=1) {
@@ -628,10 +585,7 @@ static inline void node_Conv_21( const float x[1][256][90][90], const float w[25
 static inline void node_Relu_22( const float X[1][256][90][90], float Y[1][256][90][90] )
 {
 	/*Relu*/
-	float *X_ptr = (float*)X;
-	float *Y_ptr = (float*)Y;
-	for( uint32_t i=0; i<2073600; i++ )
-		Y_ptr[i] = X_ptr[i] > 0 ? X_ptr[i] : 0;
+	bevfusion::relu((const float*)X, (float*)Y, 2073600);
 
 }
 
@@ -651,6 +605,7 @@ static inline void node_Conv_23( const float x[1][256][90][90], const float w[25
 	 * strides: 1 1 
 	 */
 	for( uint32_t b=0; b<1; b++ ) {
+	#pragma omp parallel for
 	for( uint32_t m=0; m<256; m++) {
 		for( int32_t o0=0, i0=-1; o0<90; o0++, i0+=1) {
 		for( int32_t o1=0, i1=-1; o1<90; o1++, i1+=1) {
@@ -681,10 +636,7 @@ static inline void node_Conv_23( const float x[1][256][90][90], const float w[25
 static inline void node_Relu_24( const float X[1][256][90][90], float Y[1][256][90][90] )
 {
 	/*Relu*/
-	float *X_ptr = (float*)X;
-	float *Y_ptr = (float*)Y;
-	for( uint32_t i=0; i<2073600; i++ )
-		Y_ptr[i] = X_ptr[i] > 0 ? X_ptr[i] : 0;
+	bevfusion::relu((const float*)X, (float*)Y, 2073600);
 
 }
 
@@ -704,6 +656,7 @@ static inline void node_Conv_25( const float x[1][256][90][90], const float w[25
 	 * strides: 1 1 
 	 */
 	for( uint32_t b=0; b<1; b++ ) {
+	#pragma omp parallel for
 	for( uint32_t m=0; m<256; m++) {
 		for( int32_t o0=0, i0=-1; o0<90; o0++, i0+=1) {
 		for( int32_t o1=0, i1=-1; o1<90; o1++, i1+=1) {
@@ -734,241 +687,25 @@ static inline void node_Conv_25( const float x[1][256][90][90], const float w[25
 static inline void node_Relu_26( const float X[1][256][90][90], float Y[1][256][90][90] )
 {
 	/*Relu*/
-	float *X_ptr = (float*)X;
-	float *Y_ptr = (float*)Y;
-	for( uint32_t i=0; i<2073600; i++ )
-		Y_ptr[i] = X_ptr[i] > 0 ? X_ptr[i] : 0;
-
-}
-
-/*
- * Operand:           Conv
- * Name in ONNX file: Conv_27
- */
-static inline void node_Conv_27( const float x[1][128][180][180], const float w[256][128][1][1], const float bias[256], float y[1][256][180][180] )
-{
-	/* Conv
-	 *
-	 * auto_pad: NOTSET
-	 * dilations: 1 1 
-	 * group: 1
-	 * kernel_shape: 1 1 
-	 * pads: 0 0 0 0 
-	 * strides: 1 1 
-	 */
-	for( uint32_t b=0; b<1; b++ ) {
-	for( uint32_t m=0; m<256; m++) {
-		for( int32_t o0=0, i0=0; o0<180; o0++, i0+=1) {
-		for( int32_t o1=0, i1=0; o1<180; o1++, i1+=1) {
-			y[b][m][o0][o1] = bias[m];
-			for( int32_t c=0; c<128; c++ ) {
-			for( uint32_t k0=0; k0<1; k0++ ) {
-			for( uint32_t k1=0; k1<1; k1++ ) {
-				int ii0 = i0+k0 * 1;
-				if( ii0<0) continue;
-				if( ii0>=180) continue;
-				int ii1 = i1+k1 * 1;
-				if( ii1<0) continue;
-				if( ii1>=180) continue;
-				y[b][m][o0][o1] += x[b][c][ii0][ii1] *w[m][c][k0][k1];
-			} /* k */
-			} /* k */
-			} /* c */
-		} /* o */
-		} /* o */
-	} /* m */
-	} /* b */
-}
-
-/*
- * Operand:           Relu
- * Name in ONNX file: Relu_28
- */
-static inline void node_Relu_28( const float X[1][256][180][180], float Y[1][256][180][180] )
-{
-	/*Relu*/
-	float *X_ptr = (float*)X;
-	float *Y_ptr = (float*)Y;
-	for( uint32_t i=0; i<8294400; i++ )
-		Y_ptr[i] = X_ptr[i] > 0 ? X_ptr[i] : 0;
-
-}
-
-/*
- * Operand:           ConvTranspose
- * Name in ONNX file: ConvTranspose_29
- */
-static inline void node_ConvTranspose_29( const float x[1][256][90][90], const float w[256][256][2][2], float y[1][256][180][180] )
-{
-	/* ConvTranspose
-	 *
-	 * auto_pad: NOTSET
-	 * dilations: 1 1 
-	 * group: 1
-	 * kernel_shape: 2 2 
-	 * pads: 0 0 0 0 
-	 * strides: 2 2 
-	 * output_padding: 0 0 
-	 * output_shape: 180 180 
-	 * output_shape explicitly given in ONNX model: false
-	 */
-	memset(y, 0,33177600);
-
-	for( uint32_t b=0; b<1; b++ ) {
-	for( uint32_t m=0; m<256; m++) {
-		for( int32_t i0=0; i0<90; i0++) {
-		for( int32_t i1=0; i1<90; i1++) {
-			for( int32_t c=0; c<256; c++ ) {
-			for( int32_t k0=0, o0=i0*2-0; k0<2; k0++, o0+=1) {
-			for( int32_t k1=0, o1=i1*2-0; k1<2; k1++, o1+=1) {
-				if( o0<0) continue;
-				if( o0>=180) continue;
-				if( o1<0) continue;
-				if( o1>=180) continue;
-				y[b][m][o0][o1] += x[b][c][i0][i1] * w[c][m][k0][k1];
-			} /* k */
-			} /* k */
-			} /* c */
-		} /* o */
-		} /* o */
-	} /* m */
-	} /* b */
-}
-
-/*
- * Operand:           BatchNormalization
- * Name in ONNX file: BatchNormalization_30
- */
-static inline void node_BatchNormalization_30( const float X[1][256][180][180], const float scale[256], const float bias[256], const float mean[256], const float var[256], float output[1][256][180][180] )
-{
-	/* BatchNormalization
-	 * epsilon = 0.0010000000474974513054
-	 * momentum = 0.99000000953674316406
-	 */
-
-	for( int32_t b=0; b<1; b++ ) {
-	for( int32_t c=0; c<256; c++ ) {
-	for( uint32_t i2=0; i2<180; i2++ ) {
-	for( uint32_t i3=0; i3<180; i3++ ) {
-		float tmp_X = ( X[b][c][i2][i3] - mean[c] ) / ( var[c] );
-		output[b][c][i2][i3] = tmp_X * scale[c] + bias[c];
-	}
-	}
-	}
-	}
-}
-
-/*
- * Operand:           Relu
- * Name in ONNX file: Relu_31
- */
-static inline void node_Relu_31( const float X[1][256][180][180], float Y[1][256][180][180] )
-{
-	/*Relu*/
-	float *X_ptr = (float*)X;
-	float *Y_ptr = (float*)Y;
-	for( uint32_t i=0; i<8294400; i++ )
-		Y_ptr[i] = X_ptr[i] > 0 ? X_ptr[i] : 0;
+	bevfusion::relu((const float*)X, (float*)Y, 2073600);
 
 }
 
 /*
- * Operand:           Concat
- * Name in ONNX file: Concat_32
+ * ConvTranspose_29 + BatchNormalization_30 + Relu_31 融合
+ * 转置卷积（kernel 2、stride 2，输出互不重叠）拆成 GEMM（见 conv_transpose.h），BN 与 ReLU 在写出时完成。
+ * BN 与 onnx2c 生成的 BatchNormalization_30 相同: (x - mean) / var * scale + bias
  */
-static inline void node_Concat_32( const float input_0[1][256][180][180], const float input_1[1][256][180][180], float output[1][512][180][180] )
+static inline void node_ConvTranspose_29_BN_30_Relu_31( const float x[1][256][90][90], const float w[256][256][2][2], const float scale[256], const float bias[256], const float mean[256], const float var[256], float y[1][256][180][180] )
 {
-	/* Concat */
-	int64_t outputOffset;
-	outputOffset = 0;
-	for (int64_t i = 0, j = 0; i < 8294400; i++) {
-		*((float*)output + (outputOffset + i)) = *((float*)input_0 + i);
-		if (++j == 8294400) {
-			outputOffset += (8294400);
-			j = 0;
-		}
-	}
-	outputOffset = 8294400;
-	for (int64_t i = 0, j = 0; i < 8294400; i++) {
-		*((float*)output + (outputOffset + i)) = *((float*)input_1 + i);
-		if (++j == 8294400) {
-			outputOffset += (8294400);
-			j = 0;
-		}
-	}
+	conv_transpose_nonoverlap(256, 256, 90, 90, 2, &x[0][0][0][0], &w[0][0][0][0], &y[0][0][0][0], [&](int m, float v) {
+		float tmp_X = ( v - mean[m] ) / ( var[m] );
+		float out = tmp_X * scale[m] + bias[m];
+		return out > 0 ? out : 0.0f;
+	});
 }
 
-//获取$BENCHMARK_ROOT
-std::string benchmark_root = std::string(getenv("BENCHMARK_ROOT"));
-
-auto temp_parent_fuser_0_weight = read4DTensorFromFile<256,336,3,3>(benchmark_root + "/fuser/parent.fuser.0.weight.txt");
-
-auto temp_parent_fuser_0_bias = read1DTensorFromFile<256>(benchmark_root + "/fuser/parent.fuser.0.bias.txt");
-
-auto temp_parent_decoder_backbone_blocks_0_0_weight = read4DTensorFromFile<128,256,3,3>(benchmark_root + "/fuser/parent.decoder.backbone.blocks.0.0.weight.txt");
-
-auto temp_parent_decoder_backbone_blocks_0_0_bias = read1DTensorFromFile<128>(benchmark_root + "/fuser/parent.decoder.backbone.blocks.0.0.bias.txt");
-
-auto temp_parent_decoder_backbone_blocks_0_3_weight = read4DTensorFromFile<128,128,3,3>(benchmark_root + "/fuser/parent.decoder.backbone.blocks.0.3.weight.txt");
-
-auto temp_parent_decoder_backbone_blocks_0_3_bias = read1DTensorFromFile<128>(benchmark_root + "/fuser/parent.decoder.backbone.blocks.0.3.bias.txt");
-
-auto temp_parent_decoder_backbone_blocks_0_6_weight = read4DTensorFromFile<128,128,3,3>(benchmark_root + "/fuser/parent.decoder.backbone.blocks.0.6.weight.txt");
-
-auto temp_parent_decoder_backbone_blocks_0_6_bias = read1DTensorFromFile<128>(benchmark_root + "/fuser/parent.decoder.backbone.blocks.0.6.bias.txt");
-
-auto temp_parent_decoder_backbone_blocks_0_9_weight = read4DTensorFromFile<128,128,3,3>(benchmark_root + "/fuser/parent.decoder.backbone.blocks.0.9.weight.txt");
-
-auto temp_parent_decoder_backbone_blocks_0_9_bias = read1DTensorFromFile<128>(benchmark_root + "/fuser/parent.decoder.backbone.blocks.0.9.bias.txt");
-
-auto temp_parent_decoder_backbone_blocks_0_12_weight = read4DTensorFromFile<128,128,3,3>(benchmark_root + "/fuser/parent.decoder.backbone.blocks.0.12.weight.txt");
-
-auto temp_parent_decoder_backbone_blocks_0_12_bias = read1DTensorFromFile<128>(benchmark_root + "/fuser/parent.decoder.backbone.blocks.0.12.bias.txt");
-
-auto temp_parent_decoder_backbone_blocks_0_15_weight = read4DTensorFromFile<128,128,3,3>(benchmark_root + "/fuser/parent.decoder.backbone.blocks.0.15.weight.txt");
-
-auto temp_parent_decoder_backbone_blocks_0_15_bias = read1DTensorFromFile<128>(benchmark_root + "/fuser/parent.decoder.backbone.blocks.0.15.bias.txt");
-
-auto temp_parent_decoder_backbone_blocks_1_0_weight = read4DTensorFromFile<256,128,3,3>(benchmark_root + "/fuser/parent.decoder.backbone.blocks.1.0.weight.txt");
-
-auto temp_parent_decoder_backbone_blocks_1_0_bias = read1DTensorFromFile<256>(benchmark_root + "/fuser/parent.decoder.backbone.blocks.1.0.bias.txt");
-
-auto temp_parent_decoder_backbone_blocks_1_3_weight = read4DTensorFromFile<256,256,3,3>(benchmark_root + "/fuser/parent.decoder.backbone.blocks.1.3.weight.txt");
-
-auto temp_parent_decoder_backbone_blocks_1_3_bias = read1DTensorFromFile<256>(benchmark_root + "/fuser/parent.decoder.backbone.blocks.1.3.bias.txt");
-
-auto temp_parent_decoder_backbone_blocks_1_6_weight = read4DTensorFromFile<256,256,3,3>(benchmark_root + "/fuser/parent.decoder.backbone.blocks.1.6.weight.txt");
-
-auto temp_parent_decoder_backbone_blocks_1_6_bias = read1DTensorFromFile<256>(benchmark_root + "/fuser/parent.decoder.backbone.blocks.1.6.bias.txt");
-
-auto temp_parent_decoder_backbone_blocks_1_9_weight = read4DTensorFromFile<256,256,3,3>(benchmark_root + "/fuser/parent.decoder.backbone.blocks.1.9.weight.txt");
-
-auto temp_parent_decoder_backbone_blocks_1_9_bias = read1DTensorFromFile<256>(benchmark_root + "/fuser/parent.decoder.backbone.blocks.1.9.bias.txt");
-
-auto temp_parent_decoder_backbone_blocks_1_12_weight = read4DTensorFromFile<256,256,3,3>(benchmark_root + "/fuser/parent.decoder.backbone.blocks.1.12.weight.txt");
-
-auto temp_parent_decoder_backbone_blocks_1_12_bias = read1DTensorFromFile<256>(benchmark_root + "/fuser/parent.decoder.backbone.blocks.1.12.bias.txt");
-
-auto temp_parent_decoder_backbone_blocks_1_15_weight = read4DTensorFromFile<256,256,3,3>(benchmark_root + "/fuser/parent.decoder.backbone.blocks.1.15.weight.txt");
-
-auto temp_parent_decoder_backbone_blocks_1_15_bias = read1DTensorFromFile<256>(benchmark_root + "/fuser/parent.decoder.backbone.blocks.1.15.bias.txt");
-
-auto temp_parent_decoder_neck_deblocks_0_0_weight = read4DTensorFromFile<256,128,1,1>(benchmark_root + "/fuser/parent.decoder.neck.deblocks.0.0.weight.txt");
-
-auto temp_parent_decoder_neck_deblocks_0_0_bias = read1DTensorFromFile<256>(benchmark_root + "/fuser/parent.decoder.neck.deblocks.0.0.bias.txt");
-
-auto temp_parent_decoder_neck_deblocks_1_0_weight = read4DTensorFromFile<256,256,2,2>(benchmark_root + "/fuser/parent.decoder.neck.deblocks.1.0.weight.txt");
-
-auto temp_parent_decoder_neck_deblocks_1_1_weight = read1DTensorFromFile<256>(benchmark_root + "/fuser/parent.decoder.neck.deblocks.1.1.weight.txt");
-
-auto temp_parent_decoder_neck_deblocks_1_1_bias = read1DTensorFromFile<256>(benchmark_root + "/fuser/parent.decoder.neck.deblocks.1.1.bias.txt");
-
-auto temp_parent_decoder_neck_deblocks_1_1_running_mean = read1DTensorFromFile<256>(benchmark_root + "/fuser/parent.decoder.neck.deblocks.1.1.running_mean.txt");
-
-auto temp_parent_decoder_neck_deblocks_1_1_running_var = read1DTensorFromFile<256>(benchmark_root + "/fuser/parent.decoder.neck.deblocks.1.1.running_var.txt");
-
 union tensor_union_0 {
-float tensor_510[1][336][180][180];
 float tensor_512[1][256][180][180];
 float tensor_514[1][128][180][180];
 float tensor_516[1][128][180][180];
@@ -1016,10 +753,13 @@ static union tensor_union_1 tu1;
 
 static union tensor_union_2 tu2;
 
-static float tensor_parent_fuser_0_weight[256][336][3][3];
-
 static float tensor_parent_fuser_0_bias[256];
 
+// Conv_1 权重 [256][336][3][3] 读入时按输入通道拆成 camera / lidar 两块，不保留拼接的原张量
+static float tensor_parent_fuser_0_weight_camera[256][80][3][3];
+
+static float tensor_parent_fuser_0_weight_lidar[256][256][3][3];
+
 static float tensor_parent_decoder_backbone_blocks_0_0_weight[128][256][3][3];
 
 static float tensor_parent_decoder_backbone_blocks_0_0_bias[128];
@@ -1082,407 +822,184 @@ static float tensor_parent_decoder_neck_deblocks_1_1_running_mean[256];
 
 static float tensor_parent_decoder_neck_deblocks_1_1_running_var[256];
 
-void entry(float tensor_camera[1][80][180][180], float tensor_lidar[1][256][180][180], float tensor_middle[1][512][180][180]){
-	node_Concat_0( tensor_camera, tensor_lidar, tu0.tensor_510);
-	node_Conv_1( tu0.tensor_510, tensor_parent_fuser_0_weight, tensor_parent_fuser_0_bias, tu1.tensor_511);
-	node_Relu_2( tu1.tensor_511, tu0.tensor_512);
-	node_Conv_3( tu0.tensor_512, tensor_parent_decoder_backbone_blocks_0_0_weight, tensor_parent_decoder_backbone_blocks_0_0_bias, tu1.tensor_513);
-	node_Relu_4( tu1.tensor_513, tu0.tensor_514);
-	node_Conv_5( tu0.tensor_514, tensor_parent_decoder_backbone_blocks_0_3_weight, tensor_parent_decoder_backbone_blocks_0_3_bias, tu1.tensor_515);
-	node_Relu_6( tu1.tensor_515, tu0.tensor_516);
-	node_Conv_7( tu0.tensor_516, tensor_parent_decoder_backbone_blocks_0_6_weight, tensor_parent_decoder_backbone_blocks_0_6_bias, tu1.tensor_517);
-	node_Relu_8( tu1.tensor_517, tu0.tensor_518);
-	node_Conv_9( tu0.tensor_518, tensor_parent_decoder_backbone_blocks_0_9_weight, tensor_parent_decoder_backbone_blocks_0_9_bias, tu1.tensor_519);
-	node_Relu_10( tu1.tensor_519, tu0.tensor_520);
-	node_Conv_11( tu0.tensor_520, tensor_parent_decoder_backbone_blocks_0_12_weight, tensor_parent_decoder_backbone_blocks_0_12_bias, tu1.tensor_521);
-	node_Relu_12( tu1.tensor_521, tu0.tensor_522);
-	node_Conv_13( tu0.tensor_522, tensor_parent_decoder_backbone_blocks_0_15_weight, tensor_parent_decoder_backbone_blocks_0_15_bias, tu1.tensor_523);
-	node_Relu_14( tu1.tensor_523, tu0.tensor_524);
+// 权重按首次使用的位置分组：第一帧可以在后面几组还在读取时先算 Conv_1
+enum FuserWeightGroup { kWeightsConv1, kWeightsBlock0, kWeightsBlock1, kWeightsNeck0, kWeightsNeck1 };
+
+// 权重登记表，文件在 $BENCHMARK_ROOT/fuser 下。第一次调用时才创建，静态初始化阶段不读环境变量也不读文件
+static bevfusion::WeightRegistry& fuser_weights() {
+	static bevfusion::WeightRegistry registry("fuser", "BENCHMARK_ROOT", "fuser");
+	static const bool registered = [] {
+		registry.add(kWeightsConv1, "parent.fuser.0.weight.txt", 256 * 336 * 3 * 3, [](const float* weight) {
+			const size_t camera = sizeof(tensor_parent_fuser_0_weight_camera[0]) / sizeof(float);
+			const size_t lidar = sizeof(tensor_parent_fuser_0_weight_lidar[0]) / sizeof(float);
+			for (int m = 0; m < 256; ++m) {
+				memcpy(tensor_parent_fuser_0_weight_camera[m], weight + m * (camera + lidar), camera * sizeof(float));
+				memcpy(tensor_parent_fuser_0_weight_lidar[m], weight + m * (camera + lidar) + camera, lidar * sizeof(float));
+			}
+		});
+		registry.add(kWeightsConv1, "parent.fuser.0.bias.txt", tensor_parent_fuser_0_bias);
+		registry.add(kWeightsBlock0, "parent.decoder.backbone.blocks.0.0.weight.txt", tensor_parent_decoder_backbone_blocks_0_0_weight);
+		registry.add(kWeightsBlock0, "parent.decoder.backbone.blocks.0.0.bias.txt", tensor_parent_decoder_backbone_blocks_0_0_bias);
+		registry.add(kWeightsBlock0, "parent.decoder.backbone.blocks.0.3.weight.txt", tensor_parent_decoder_backbone_blocks_0_3_weight);
+		registry.add(kWeightsBlock0, "parent.decoder.backbone.blocks.0.3.bias.txt", tensor_parent_decoder_backbone_blocks_0_3_bias);
+		registry.add(kWeightsBlock0, "parent.decoder.backbone.blocks.0.6.weight.txt", tensor_parent_decoder_backbone_blocks_0_6_weight);
+		registry.add(kWeightsBlock0, "parent.decoder.backbone.blocks.0.6.bias.txt", tensor_parent_decoder_backbone_blocks_0_6_bias);
+		registry.add(kWeightsBlock0, "parent.decoder.backbone.blocks.0.9.weight.txt", tensor_parent_decoder_backbone_blocks_0_9_weight);
+		registry.add(kWeightsBlock0, "parent.decoder.backbone.blocks.0.9.bias.txt", tensor_parent_decoder_backbone_blocks_0_9_bias);
+		registry.add(kWeightsBlock0, "parent.decoder.backbone.blocks.0.12.weight.txt", tensor_parent_decoder_backbone_blocks_0_12_weight);
+		registry.add(kWeightsBlock0, "parent.decoder.backbone.blocks.0.12.bias.txt", tensor_parent_decoder_backbone_blocks_0_12_bias);
+		registry.add(kWeightsBlock0, "parent.decoder.backbone.blocks.0.15.weight.txt", tensor_parent_decoder_backbone_blocks_0_15_weight);
+		registry.add(kWeightsBlock0, "parent.decoder.backbone.blocks.0.15.bias.txt", tensor_parent_decoder_backbone_blocks_0_15_bias);
+		registry.add(kWeightsBlock1, "parent.decoder.backbone.blocks.1.0.weight.txt", tensor_parent_decoder_backbone_blocks_1_0_weight);
+		registry.add(kWeightsBlock1, "parent.decoder.backbone.blocks.1.0.bias.txt", tensor_parent_decoder_backbone_blocks_1_0_bias);
+		registry.add(kWeightsBlock1, "parent.decoder.backbone.blocks.1.3.weight.txt", tensor_parent_decoder_backbone_blocks_1_3_weight);
+		registry.add(kWeightsBlock1, "parent.decoder.backbone.blocks.1.3.bias.txt", tensor_parent_decoder_backbone_blocks_1_3_bias);
+		registry.add(kWeightsBlock1, "parent.decoder.backbone.blocks.1.6.weight.txt", tensor_parent_decoder_backbone_blocks_1_6_weight);
+		registry.add(kWeightsBlock1, "parent.decoder.backbone.blocks.1.6.bias.txt", tensor_parent_decoder_backbone_blocks_1_6_bias);
+		registry.add(kWeightsBlock1, "parent.decoder.backbone.blocks.1.9.weight.txt", tensor_parent_decoder_backbone_blocks_1_9_weight);
+		registry.add(kWeightsBlock1, "parent.decoder.backbone.blocks.1.9.bias.txt", tensor_parent_decoder_backbone_blocks_1_9_bias);
+		registry.add(kWeightsBlock1, "parent.decoder.backbone.blocks.1.12.weight.txt", tensor_parent_decoder_backbone_blocks_1_12_weight);
+		registry.add(kWeightsBlock1, "parent.decoder.backbone.blocks.1.12.bias.txt", tensor_parent_decoder_backbone_blocks_1_12_bias);
+		registry.add(kWeightsBlock1, "parent.decoder.backbone.blocks.1.15.weight.txt", tensor_parent_decoder_backbone_blocks_1_15_weight);
+		registry.add(kWeightsBlock1, "parent.decoder.backbone.blocks.1.15.bias.txt", tensor_parent_decoder_backbone_blocks_1_15_bias);
+		registry.add(kWeightsNeck0, "parent.decoder.neck.deblocks.0.0.weight.txt", tensor_parent_decoder_neck_deblocks_0_0_weight);
+		registry.add(kWeightsNeck0, "parent.decoder.neck.deblocks.0.0.bias.txt", tensor_parent_decoder_neck_deblocks_0_0_bias);
+		registry.add(kWeightsNeck1, "parent.decoder.neck.deblocks.1.0.weight.txt", tensor_parent_decoder_neck_deblocks_1_0_weight);
+		registry.add(kWeightsNeck1, "parent.decoder.neck.deblocks.1.1.weight.txt", tensor_parent_decoder_neck_deblocks_1_1_weight);
+		registry.add(kWeightsNeck1, "parent.decoder.neck.deblocks.1.1.bias.txt", tensor_parent_decoder_neck_deblocks_1_1_bias);
+		registry.add(kWeightsNeck1, "parent.decoder.neck.deblocks.1.1.running_mean.txt", tensor_parent_decoder_neck_deblocks_1_1_running_mean);
+		registry.add(kWeightsNeck1, "parent.decoder.neck.deblocks.1.1.running_var.txt", tensor_parent_decoder_neck_deblocks_1_1_running_var);
+		return true;
+	}();
+	(void)registered;
+	return registry;
+}
+
+void fuser_prefetch_weights() {
+	fuser_weights().prefetch();
+}
+
+// Conv_27 (128->256, 1×1) + Relu_28，走 pointwise_conv.h 的 GEMM。
+// 权重读入后不再变化，第一次调用时打包并缓存
+static void node_Conv_27_Relu_28( const float x[1][128][180][180], float y[1][256][180][180] )
+{
+	static const bevfusion::PointwiseConv conv(128, 256, &tensor_parent_decoder_neck_deblocks_0_0_weight[0][0][0][0], tensor_parent_decoder_neck_deblocks_0_0_bias);
+	conv.forward(&x[0][0][0][0], 1, 180 * 180, &y[0][0][0][0], /*relu=*/true);
+}
+
+// decoder 中两段连续的 3×3 卷积链，交给 conv_chain 深度优先执行
+static std::vector<ChainLayer> decoder_chain_0() {
+	return {
+		{256, 128, &tensor_parent_decoder_backbone_blocks_0_0_weight[0][0][0][0], tensor_parent_decoder_backbone_blocks_0_0_bias},
+		{128, 128, &tensor_parent_decoder_backbone_blocks_0_3_weight[0][0][0][0], tensor_parent_decoder_backbone_blocks_0_3_bias},
+		{128, 128, &tensor_parent_decoder_backbone_blocks_0_6_weight[0][0][0][0], tensor_parent_decoder_backbone_blocks_0_6_bias},
+		{128, 128, &tensor_parent_decoder_backbone_blocks_0_9_weight[0][0][0][0], tensor_parent_decoder_backbone_blocks_0_9_bias},
+		{128, 128, &tensor_parent_decoder_backbone_blocks_0_12_weight[0][0][0][0], tensor_parent_decoder_backbone_blocks_0_12_bias},
+		{128, 128, &tensor_parent_decoder_backbone_blocks_0_15_weight[0][0][0][0], tensor_parent_decoder_backbone_blocks_0_15_bias},
+	};
+}
+
+static std::vector<ChainLayer> decoder_chain_1() {
+	return {
+		{256, 256, &tensor_parent_decoder_backbone_blocks_1_3_weight[0][0][0][0], tensor_parent_decoder_backbone_blocks_1_3_bias},
+		{256, 256, &tensor_parent_decoder_backbone_blocks_1_6_weight[0][0][0][0], tensor_parent_decoder_backbone_blocks_1_6_bias},
+		{256, 256, &tensor_parent_decoder_backbone_blocks_1_9_weight[0][0][0][0], tensor_parent_decoder_backbone_blocks_1_9_bias},
+		{256, 256, &tensor_parent_decoder_backbone_blocks_1_12_weight[0][0][0][0], tensor_parent_decoder_backbone_blocks_1_12_bias},
+		{256, 256, &tensor_parent_decoder_backbone_blocks_1_15_weight[0][0][0][0], tensor_parent_decoder_backbone_blocks_1_15_bias},
+	};
+}
+
+bool entry(float tensor_camera[1][80][180][180], float tensor_lidar[1][256][180][180], float tensor_middle[1][512][180][180], const bevfusion::RowProgress* input_rows){
+	// 行带高度由 L2 大小决定，BEVFUSION_FUSER_TILE_ROWS=0 时退回逐层执行
+	static const int tile_rows_0 = conv_chain_tile_rows(decoder_chain_0(), 180);
+	static const int tile_rows_1 = conv_chain_tile_rows(decoder_chain_1(), 90);
+
+	// Conv_1 / Relu_2 按输入行带推进：第 b 个输出行带只需要输入行 [row0-1, row1]。
+	// 两路输入依次到达（input_rows 非空时先是 LiDAR 的 180 行，再是相机的 180 行，见 fuser.h）：
+	// LiDAR 一到就逐行带算它的部分和，相机到达后再逐行带加上相机部分并做 ReLU
+	// 每组权重在第一次用到之前读入（已由 fuser_prefetch_weights() 在后台读取时只是等待）
+	auto require = [](int group) {
+		if (fuser_weights().require(group)) return true;
+		std::cerr << "fuser 权重读取失败，见上方的错误信息" << std::endl;
+		return false;
+	};
+
+	const bevfusion::BandLayout bands{256, 180, 180};
+	if (!require(kWeightsConv1)) return false;
+	for (int b = 0; b < bands.num_bands(); ++b) {
+		int row0 = bands.row0(b), row1 = row0 + bands.rows(b);
+		int need = row1 < 180 ? row1 + 1 : 180;
+		if (input_rows && !input_rows->wait(need)) return false;
+		node_Conv_1_part( &tensor_lidar[0][0][0][0], 256, &tensor_parent_fuser_0_weight_lidar[0][0][0][0], tensor_parent_fuser_0_bias, tu1.tensor_511, row0, row1);
+	}
+	for (int b = 0; b < bands.num_bands(); ++b) {
+		int row0 = bands.row0(b), row1 = row0 + bands.rows(b);
+		int need = row1 < 180 ? row1 + 1 : 180;
+		if (input_rows && !input_rows->wait(kFuserLidarRows + need)) return false;
+		node_Conv_1_part( &tensor_camera[0][0][0][0], 80, &tensor_parent_fuser_0_weight_camera[0][0][0][0], nullptr, tu1.tensor_511, row0, row1);
+		node_Relu_2( tu1.tensor_511, tu0.tensor_512, row0, row1);
+	}
+	if (!require(kWeightsBlock0)) return false;
+	if (tile_rows_0 > 0) {
+		// Conv_3 ~ Conv_13 (+ReLU) 按行带深度优先执行，tensor_512 与 tensor_524 同在 tu0 中，原地执行
+		ChainStats s = run_conv_chain(decoder_chain_0(), 180, 180, tile_rows_0, &tu0.tensor_512[0][0][0][0], &tu0.tensor_524[0][0][0][0]);
+		print_chain_stats("fuser chain Conv_3-Conv_13", 6, s);
+	} else {
+		node_Conv_3( tu0.tensor_512, tensor_parent_decoder_backbone_blocks_0_0_weight, tensor_parent_decoder_backbone_blocks_0_0_bias, tu1.tensor_513);
+		node_Relu_4( tu1.tensor_513, tu0.tensor_514);
+		node_Conv_5( tu0.tensor_514, tensor_parent_decoder_backbone_blocks_0_3_weight, tensor_parent_decoder_backbone_blocks_0_3_bias, tu1.tensor_515);
+		node_Relu_6( tu1.tensor_515, tu0.tensor_516);
+		node_Conv_7( tu0.tensor_516, tensor_parent_decoder_backbone_blocks_0_6_weight, tensor_parent_decoder_backbone_blocks_0_6_bias, tu1.tensor_517);
+		node_Relu_8( tu1.tensor_517, tu0.tensor_518);
+		node_Conv_9( tu0.tensor_518, tensor_parent_decoder_backbone_blocks_0_9_weight, tensor_parent_decoder_backbone_blocks_0_9_bias, tu1.tensor_519);
+		node_Relu_10( tu1.tensor_519, tu0.tensor_520);
+		node_Conv_11( tu0.tensor_520, tensor_parent_decoder_backbone_blocks_0_12_weight, tensor_parent_decoder_backbone_blocks_0_12_bias, tu1.tensor_521);
+		node_Relu_12( tu1.tensor_521, tu0.tensor_522);
+		node_Conv_13( tu0.tensor_522, tensor_parent_decoder_backbone_blocks_0_15_weight, tensor_parent_decoder_backbone_blocks_0_15_bias, tu1.tensor_523);
+		node_Relu_14( tu1.tensor_523, tu0.tensor_524);
+	}
+	if (!require(kWeightsBlock1)) return false;
 	node_Conv_15( tu0.tensor_524, tensor_parent_decoder_backbone_blocks_1_0_weight, tensor_parent_decoder_backbone_blocks_1_0_bias, tu1.tensor_525);
 	node_Relu_16( tu1.tensor_525, tu2.tensor_526);
-	node_Conv_17( tu2.tensor_526, tensor_parent_decoder_backbone_blocks_1_3_weight, tensor_parent_decoder_backbone_blocks_1_3_bias, tu1.tensor_527);
-	node_Relu_18( tu1.tensor_527, tu2.tensor_528);
-	node_Conv_19( tu2.tensor_528, tensor_parent_decoder_backbone_blocks_1_6_weight, tensor_parent_decoder_backbone_blocks_1_6_bias, tu1.tensor_529);
-	node_Relu_20( tu1.tensor_529, tu2.tensor_530);
-	node_Conv_21( tu2.tensor_530, tensor_parent_decoder_backbone_blocks_1_9_weight, tensor_parent_decoder_backbone_blocks_1_9_bias, tu1.tensor_531);
-	node_Relu_22( tu1.tensor_531, tu2.tensor_532);
-	node_Conv_23( tu2.tensor_532, tensor_parent_decoder_backbone_blocks_1_12_weight, tensor_parent_decoder_backbone_blocks_1_12_bias, tu1.tensor_533);
-	node_Relu_24( tu1.tensor_533, tu2.tensor_534);
-	node_Conv_25( tu2.tensor_534, tensor_parent_decoder_backbone_blocks_1_15_weight, tensor_parent_decoder_backbone_blocks_1_15_bias, tu1.tensor_535);
-	node_Relu_26( tu1.tensor_535, tu2.tensor_536);
-	node_Conv_27( tu0.tensor_524, tensor_parent_decoder_neck_deblocks_0_0_weight, tensor_parent_decoder_neck_deblocks_0_0_bias, tu1.tensor_537);
-	node_Relu_28( tu1.tensor_537, tu0.tensor_538);
-	node_ConvTranspose_29( tu2.tensor_536, tensor_parent_decoder_neck_deblocks_1_0_weight, tu1.tensor_539);
-	node_BatchNormalization_30( tu1.tensor_539, tensor_parent_decoder_neck_deblocks_1_1_weight, tensor_parent_decoder_neck_deblocks_1_1_bias, tensor_parent_decoder_neck_deblocks_1_1_running_mean, tensor_parent_decoder_neck_deblocks_1_1_running_var, tu2.tensor_540);
-	node_Relu_31( tu2.tensor_540, tu1.tensor_541);
-	node_Concat_32( tu0.tensor_538, tu1.tensor_541, tensor_middle);
-}
-
-
-
-float* fuser(float* tensor_camera_copy, float* tensor_lidar_copy){
-	for (size_t i = 0; i < 256; ++i) {
-		for (size_t j = 0; j < 336; ++j) {
-			for (size_t k = 0; k < 3; ++k) {
-				for (size_t l = 0; l < 3; ++l) {
-					tensor_parent_fuser_0_weight[i][j][k][l] = temp_parent_fuser_0_weight[i][j][k][l];
-				}
-			}
-		}
-	}
-
-
-	for (size_t i = 0; i < 256; ++i) {
-		tensor_parent_fuser_0_bias[i] = temp_parent_fuser_0_bias[i];
-	}
-
-
-	for (size_t i = 0; i < 128; ++i) {
-		for (size_t j = 0; j < 256; ++j) {
-			for (size_t k = 0; k < 3; ++k) {
-				for (size_t l = 0; l < 3; ++l) {
-					tensor_parent_decoder_backbone_blocks_0_0_weight[i][j][k][l] = temp_parent_decoder_backbone_blocks_0_0_weight[i][j][k][l];
-				}
-			}
-		}
-	}
-
-
-	for (size_t i = 0; i < 128; ++i) {
-		tensor_parent_decoder_backbone_blocks_0_0_bias[i] = temp_parent_decoder_backbone_blocks_0_0_bias[i];
-	}
-
-
-	for (size_t i = 0; i < 128; ++i) {
-		for (size_t j = 0; j < 128; ++j) {
-			for (size_t k = 0; k < 3; ++k) {
-				for (size_t l = 0; l < 3; ++l) {
-					tensor_parent_decoder_backbone_blocks_0_3_weight[i][j][k][l] = temp_parent_decoder_backbone_blocks_0_3_weight[i][j][k][l];
-				}
-			}
-		}
-	}
-
-
-	for (size_t i = 0; i < 128; ++i) {
-		tensor_parent_decoder_backbone_blocks_0_3_bias[i] = temp_parent_decoder_backbone_blocks_0_3_bias[i];
-	}
-
-
-	for (size_t i = 0; i < 128; ++i) {
-		for (size_t j = 0; j < 128; ++j) {
-			for (size_t k = 0; k < 3; ++k) {
-				for (size_t l = 0; l < 3; ++l) {
-					tensor_parent_decoder_backbone_blocks_0_6_weight[i][j][k][l] = temp_parent_decoder_backbone_blocks_0_6_weight[i][j][k][l];
-				}
-			}
-		}
-	}
-
-
-	for (size_t i = 0; i < 128; ++i) {
-		tensor_parent_decoder_backbone_blocks_0_6_bias[i] = temp_parent_decoder_backbone_blocks_0_6_bias[i];
-	}
-
-
-	for (size_t i = 0; i < 128; ++i) {
-		for (size_t j = 0; j < 128; ++j) {
-			for (size_t k = 0; k < 3; ++k) {
-				for (size_t l = 0; l < 3; ++l) {
-					tensor_parent_decoder_backbone_blocks_0_9_weight[i][j][k][l] = temp_parent_decoder_backbone_blocks_0_9_weight[i][j][k][l];
-				}
-			}
-		}
-	}
-
-
-	for (size_t i = 0; i < 128; ++i) {
-		tensor_parent_decoder_backbone_blocks_0_9_bias[i] = temp_parent_decoder_backbone_blocks_0_9_bias[i];
-	}
-
-
-	for (size_t i = 0; i < 128; ++i) {
-		for (size_t j = 0; j < 128; ++j) {
-			for (size_t k = 0; k < 3; ++k) {
-				for (size_t l = 0; l < 3; ++l) {
-					tensor_parent_decoder_backbone_blocks_0_12_weight[i][j][k][l] = temp_parent_decoder_backbone_blocks_0_12_weight[i][j][k][l];
-				}
-			}
-		}
-	}
-
-
-	for (size_t i = 0; i < 128; ++i) {
-		tensor_parent_decoder_backbone_blocks_0_12_bias[i] = temp_parent_decoder_backbone_blocks_0_12_bias[i];
-	}
-
-
-	for (size_t i = 0; i < 128; ++i) {
-		for (size_t j = 0; j < 128; ++j) {
-			for (size_t k = 0; k < 3; ++k) {
-				for (size_t l = 0; l < 3; ++l) {
-					tensor_parent_decoder_backbone_blocks_0_15_weight[i][j][k][l] = temp_parent_decoder_backbone_blocks_0_15_weight[i][j][k][l];
-				}
-			}
-		}
-	}
-
-
-	for (size_t i = 0; i < 128; ++i) {
-		tensor_parent_decoder_backbone_blocks_0_15_bias[i] = temp_parent_decoder_backbone_blocks_0_15_bias[i];
-	}
-
-
-	for (size_t i = 0; i < 256; ++i) {
-		for (size_t j = 0; j < 128; ++j) {
-			for (size_t k = 0; k < 3; ++k) {
-				for (size_t l = 0; l < 3; ++l) {
-					tensor_parent_decoder_backbone_blocks_1_0_weight[i][j][k][l] = temp_parent_decoder_backbone_blocks_1_0_weight[i][j][k][l];
-				}
-			}
-		}
-	}
-
-
-	for (size_t i = 0; i < 256; ++i) {
-		tensor_parent_decoder_backbone_blocks_1_0_bias[i] = temp_parent_decoder_backbone_blocks_1_0_bias[i];
-	}
-
-
-	for (size_t i = 0; i < 256; ++i) {
-		for (size_t j = 0; j < 256; ++j) {
-			for (size_t k = 0; k < 3; ++k) {
-				for (size_t l = 0; l < 3; ++l) {
-					tensor_parent_decoder_backbone_blocks_1_3_weight[i][j][k][l] = temp_parent_decoder_backbone_blocks_1_3_weight[i][j][k][l];
-				}
-			}
-		}
-	}
-
-
-	for (size_t i = 0; i < 256; ++i) {
-		tensor_parent_decoder_backbone_blocks_1_3_bias[i] = temp_parent_decoder_backbone_blocks_1_3_bias[i];
-	}
-
-
-	for (size_t i = 0; i < 256; ++i) {
-		for (size_t j = 0; j < 256; ++j) {
-			for (size_t k = 0; k < 3; ++k) {
-				for (size_t l = 0; l < 3; ++l) {
-					tensor_parent_decoder_backbone_blocks_1_6_weight[i][j][k][l] = temp_parent_decoder_backbone_blocks_1_6_weight[i][j][k][l];
-				}
-			}
-		}
-	}
-
-
-	for (size_t i = 0; i < 256; ++i) {
-		tensor_parent_decoder_backbone_blocks_1_6_bias[i] = temp_parent_decoder_backbone_blocks_1_6_bias[i];
-	}
-
-
-	for (size_t i = 0; i < 256; ++i) {
-		for (size_t j = 0; j < 256; ++j) {
-			for (size_t k = 0; k < 3; ++k) {
-				for (size_t l = 0; l < 3; ++l) {
-					tensor_parent_decoder_backbone_blocks_1_9_weight[i][j][k][l] = temp_parent_decoder_backbone_blocks_1_9_weight[i][j][k][l];
-				}
-			}
-		}
-	}
-
-
-	for (size_t i = 0; i < 256; ++i) {
-		tensor_parent_decoder_backbone_blocks_1_9_bias[i] = temp_parent_decoder_backbone_blocks_1_9_bias[i];
-	}
-
-
-	for (size_t i = 0; i < 256; ++i) {
-		for (size_t j = 0; j < 256; ++j) {
-			for (size_t k = 0; k < 3; ++k) {
-				for (size_t l = 0; l < 3; ++l) {
-					tensor_parent_decoder_backbone_blocks_1_12_weight[i][j][k][l] = temp_parent_decoder_backbone_blocks_1_12_weight[i][j][k][l];
-				}
-			}
-		}
-	}
-
-
-	for (size_t i = 0; i < 256; ++i) {
-		tensor_parent_decoder_backbone_blocks_1_12_bias[i] = temp_parent_decoder_backbone_blocks_1_12_bias[i];
-	}
-
-
-	for (size_t i = 0; i < 256; ++i) {
-		for (size_t j = 0; j < 256; ++j) {
-			for (size_t k = 0; k < 3; ++k) {
-				for (size_t l = 0; l < 3; ++l) {
-					tensor_parent_decoder_backbone_blocks_1_15_weight[i][j][k][l] = temp_parent_decoder_backbone_blocks_1_15_weight[i][j][k][l];
-				}
-			}
-		}
-	}
-
-
-	for (size_t i = 0; i < 256; ++i) {
-		tensor_parent_decoder_backbone_blocks_1_15_bias[i] = temp_parent_decoder_backbone_blocks_1_15_bias[i];
-	}
-
-
-	for (size_t i = 0; i < 256; ++i) {
-		for (size_t j = 0; j < 128; ++j) {
-			for (size_t k = 0; k < 1; ++k) {
-				for (size_t l = 0; l < 1; ++l) {
-					tensor_parent_decoder_neck_deblocks_0_0_weight[i][j][k][l] = temp_parent_decoder_neck_deblocks_0_0_weight[i][j][k][l];
-				}
-			}
-		}
-	}
-
-
-	for (size_t i = 0; i < 256; ++i) {
-		tensor_parent_decoder_neck_deblocks_0_0_bias[i] = temp_parent_decoder_neck_deblocks_0_0_bias[i];
-	}
-
-
-	for (size_t i = 0; i < 256; ++i) {
-		for (size_t j = 0; j < 256; ++j) {
-			for (size_t k = 0; k < 2; ++k) {
-				for (size_t l = 0; l < 2; ++l) {
-					tensor_parent_decoder_neck_deblocks_1_0_weight[i][j][k][l] = temp_parent_decoder_neck_deblocks_1_0_weight[i][j][k][l];
-				}
-			}
-		}
-	}
-
-
-	for (size_t i = 0; i < 256; ++i) {
-		tensor_parent_decoder_neck_deblocks_1_1_weight[i] = temp_parent_decoder_neck_deblocks_1_1_weight[i];
-	}
-
-
-	for (size_t i = 0; i < 256; ++i) {
-		tensor_parent_decoder_neck_deblocks_1_1_bias[i] = temp_parent_decoder_neck_deblocks_1_1_bias[i];
-	}
-
-
-	for (size_t i = 0; i < 256; ++i) {
-		tensor_parent_decoder_neck_deblocks_1_1_running_mean[i] = temp_parent_decoder_neck_deblocks_1_1_running_mean[i];
-	}
-
-
-	for (size_t i = 0; i < 256; ++i) {
-		tensor_parent_decoder_neck_deblocks_1_1_running_var[i] = temp_parent_decoder_neck_deblocks_1_1_running_var[i];
-	}
-    // 动态分配 tensor_camera 数组
-    float (*tensor_camera)[80][180][180] = (float (*)[80][180][180]) malloc(1 * 80 * 180 * 180 * sizeof(float));
-    if (tensor_camera == nullptr) {
-        std::cerr << "Failed to allocate memory for tensor_camera" << std::endl;
-        return nullptr;
-    }
-    // 初始化 ttensor_camera 
-    for (int i = 0; i < 80; ++i) {
-        for (int j = 0; j < 180; ++j) {
-            for (int k = 0; k < 180; ++k) {
-                (*tensor_camera)[i][j][k] = tensor_camera_copy[i * 180 * 180 + j * 180 + k];
-            }
-        }
-    }
-
-    // 动态分配 tensor_lidar 数组
-    float (*tensor_lidar)[256][180][180] = (float (*)[256][180][180]) malloc(1 * 256 * 180 * 180 * sizeof(float));
-    if (tensor_lidar == nullptr) {
-        std::cerr << "Failed to allocate memory for tensor_lidar" << std::endl;
-        free(tensor_camera);
-        return nullptr;
-    }
-    // 初始化 tensor_lidar 数组为 1
-    for (int i = 0; i < 256; ++i) {
-        for (int j = 0; j < 180; ++j) {
-            for (int k = 0; k < 180; ++k) {
-                (*tensor_lidar)[i][j][k] = tensor_lidar_copy[i * 180 * 180 + j * 180 + k];
-            }
-        }
-    }
-    // 动态分配 tensor_middle 数组
-    float (*tensor_middle)[512][180][180] = (float (*)[512][180][180]) malloc(1 * 512 * 180 * 180 * sizeof(float));
-    if (tensor_middle == nullptr) {
-        std::cerr << "Failed to allocate memory for tensor_middle" << std::endl;
-        free(tensor_camera);
-        free(tensor_lidar);  // 释放之前分配的内存
-        return nullptr;
-    }
-
-    // 初始化 tensor_middle 数组 (例如，填充为0)
-    memset(tensor_middle, 0, 1 * 512 * 180 * 180 * sizeof(float));
+	if (tile_rows_1 > 0) {
+		// Conv_17 ~ Conv_25 (+ReLU)，tensor_526 与 tensor_536 同在 tu2 中，原地执行
+		ChainStats s = run_conv_chain(decoder_chain_1(), 90, 90, tile_rows_1, &tu2.tensor_526[0][0][0][0], &tu2.tensor_536[0][0][0][0]);
+		print_chain_stats("fuser chain Conv_17-Conv_25", 5, s);
+	} else {
+		node_Conv_17( tu2.tensor_526, tensor_parent_decoder_backbone_blocks_1_3_weight, tensor_parent_decoder_backbone_blocks_1_3_bias, tu1.tensor_527);
+		node_Relu_18( tu1.tensor_527, tu2.tensor_528);
+		node_Conv_19( tu2.tensor_528, tensor_parent_decoder_backbone_blocks_1_6_weight, tensor_parent_decoder_backbone_blocks_1_6_bias, tu1.tensor_529);
+		node_Relu_20( tu1.tensor_529, tu2.tensor_530);
+		node_Conv_21( tu2.tensor_530, tensor_parent_decoder_backbone_blocks_1_9_weight, tensor_parent_decoder_backbone_blocks_1_9_bias, tu1.tensor_531);
+		node_Relu_22( tu1.tensor_531, tu2.tensor_532);
+		node_Conv_23( tu2.tensor_532, tensor_parent_decoder_backbone_blocks_1_12_weight, tensor_parent_decoder_backbone_blocks_1_12_bias, tu1.tensor_533);
+		node_Relu_24( tu1.tensor_533, tu2.tensor_534);
+		node_Conv_25( tu2.tensor_534, tensor_parent_decoder_backbone_blocks_1_15_weight, tensor_parent_decoder_backbone_blocks_1_15_bias, tu1.tensor_535);
+		node_Relu_26( tu1.tensor_535, tu2.tensor_536);
+	}
+	// 两个 neck 分支直接写入 tensor_middle 的前后 256 个通道，省去 Concat_32 的拷贝
+	float (*middle_0)[256][180][180] = (float (*)[256][180][180])&tensor_middle[0][0][0][0];
+	float (*middle_1)[256][180][180] = (float (*)[256][180][180])&tensor_middle[0][256][0][0];
+	if (!require(kWeightsNeck0) || !require(kWeightsNeck1)) return false;
+	node_Conv_27_Relu_28( tu0.tensor_524, middle_0);
+	node_ConvTranspose_29_BN_30_Relu_31( tu2.tensor_536, tensor_parent_decoder_neck_deblocks_1_0_weight, tensor_parent_decoder_neck_deblocks_1_1_weight, tensor_parent_decoder_neck_deblocks_1_1_bias, tensor_parent_decoder_neck_deblocks_1_1_running_mean, tensor_parent_decoder_neck_deblocks_1_1_running_var, middle_1);
+	return true;
+}
+
+
+
+bool fuser(const float* camera_features, const float* lidar_features, float* fused_features, const bevfusion::RowProgress* input_rows){
+    // 输入只被 Conv_1 读取，输出由 Conv_27 / ConvTranspose_29 完整写满，
+    // 因此直接在调用方的缓冲上计算，不再拷贝输入、清零和拷出结果
+    auto tensor_camera = (float (*)[80][180][180])const_cast<float*>(camera_features);
+    auto tensor_lidar = (float (*)[256][180][180])const_cast<float*>(lidar_features);
+    auto tensor_middle = (float (*)[512][180][180])fused_features;
 
     // 调用 entry 函数
-    entry(tensor_camera, tensor_lidar, tensor_middle);
-
-    // 创建一个一维数组来存储结果并返回
-    float* result = (float*)malloc(1 * 512 * 180 * 180 * sizeof(float));
-    if (result == nullptr) {
-        std::cerr << "Failed to allocate memory for result" << std::endl;
-        free(tensor_camera);
-        free(tensor_lidar);
-        free(tensor_middle);
-        return nullptr;
+    if (!entry(tensor_camera, tensor_lidar, tensor_middle, input_rows)) {
+        std::cerr << "fuser 计算中止" << std::endl;
+        return false;
     }
-    
-    // 复制数据到一维数组
-    memcpy(result, tensor_middle, 1 * 512 * 180 * 180 * sizeof(float));
-
-    // 释放动态分配的内存
-    free(tensor_camera);
-    free(tensor_lidar); 
-    free(tensor_middle);
     printf("************success**************\n");
-	return result;
-}
-
-int main(int argc, char** argv) {
-	int idX = atoi(argv[1]);
-	int idY = atoi(argv[2]);
-	float *tensor_camera = new float[1 * 80 * 180 * 180];
-	float *tensor_lidar = new float[1 * 256 * 180 * 180];
-	// // 初始化
-	// for (size_t i = 0; i < 1 * 80 * 180 * 180; ++i) {
-	// 	tensor_camera[i] = 1.0f;
-	// }
-	// for (size_t i = 0; i < 1 * 256 * 180 * 180; ++i) {
-	// 	tensor_lidar[i] = 1.0f;
-	// }
-	long long unsigned int timeNow = 1;
-	std::string fileName = InterChiplet::receiveSync(5, 5, idX, idY);
-	global_pipe_comm.read_data(fileName.c_str(), tensor_camera, 1 * 80 * 180 * 180 * sizeof(float));
-	long long int time_end = InterChiplet::readSync(timeNow, 5, 5, idX, idY, 1 * 80 * 180 * 180 * sizeof(float), 0);
-	std::cout<<"--------------------------------"<<std::endl;
-	fileName = InterChiplet::receiveSync(5, 5, idX, idY);
-	global_pipe_comm.read_data(fileName.c_str(), tensor_lidar, 1 * 256 * 180 * 180 * sizeof(float));
-	time_end = InterChiplet::readSync(timeNow, 5, 5, idX, idY, 1 * 256 * 180 * 180 * sizeof(float), 0);
-	std::cout<<"--------------------------------"<<std::endl;
-	float *fuser_output = fuser(tensor_camera, tensor_lidar);
-	if (fuser_output == nullptr) {
-		printf("Failed to allocate memory for fuser_output\n");
-		return 1;
-	}
-	fileName = InterChiplet::sendSync(idX, idY, 5, 5);
-	global_pipe_comm.write_data(fileName.c_str(), fuser_output, 1 * 512 * 180 * 180 * sizeof(float));
-	time_end = InterChiplet::writeSync(time_end, idX, idY, 5, 5, 1 * 512 * 180 * 180 * sizeof(float), 0);
-	
-	// 正确访问一维数组中的元素
-	// for (size_t i = 0; i < 256; ++i) {
-	// 	for (size_t j = 0; j < 180; ++j) {
-	// 		for (size_t k = 0; k < 180; ++k) {
-	// 			size_t index = i * 180 * 180 + j * 180 + k;
-	// 			printf("%f ", lidar_backbone_output[index]);
-	// 		}
-	// 	}
-	// }
-	
-	// 释放内存
-	free(fuser_output);
-	return 0;
+	return true;
 }
-
-
@@ -1,6 +1,19 @@
 #ifndef FUSER_H
 #define FUSER_H
 
-float* fuser(float* tensor_camera_copy, float* tensor_lidar_copy);
+namespace bevfusion { class RowProgress; }
+
+// camera_features: 1×80×180×180，lidar_features: 1×256×180×180，
+// fused_features: 1×512×180×180，均由调用方分配；失败时返回 false。
+// input_rows 非空时两路输入仍在按行带到达，Conv_1 逐行带等待（见 common/band_stream.h）。
+// 进度按到达顺序计数：先是 LiDAR 的 kFuserLidarRows 行，之后 kFuserLidarRows + r 表示相机已到 r 行。
+// LiDAR 一路先到，Conv_1 的 LiDAR 部分和在相机分支还在计算时就开始
+constexpr int kFuserLidarRows = 180;
+
+bool fuser(const float* camera_features, const float* lidar_features, float* fused_features,
+           const bevfusion::RowProgress* input_rows = nullptr);
+
+// 在后台开始读取权重后立即返回，不调用时 fuser() 在第一次用到各组权重时读取
+void fuser_prefetch_weights();
 
 #endif
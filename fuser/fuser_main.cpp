@@ -0,0 +1,53 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "fuser.h"
+#include "chiplet_link.h"
+#include "stage_pipeline.h"
+#include "weight_registry.h"
+
+struct FuserInput {
+	std::vector<float> camera = std::vector<float>(1 * 80 * 180 * 180);
+	std::vector<float> lidar = std::vector<float>(1 * 256 * 180 * 180);
+};
+
+struct FuserOutput {
+	std::vector<float> fused = std::vector<float>(1 * 512 * 180 * 180);
+};
+
+// 用法: fuser <idX> <idY> [帧数]
+int main(int argc, char** argv) {
+	int idX = atoi(argv[1]);
+	int idY = atoi(argv[2]);
+	int num_frames = argc > 3 ? atoi(argv[3]) : 1;
+	bevfusion::ChipletLink link(idX, idY);
+	if (!link.open()) return 1;
+	// 等第一帧输入的同时在后台读取权重
+	fuser_prefetch_weights();
+	bevfusion::StagePipeline<FuserInput, FuserOutput> pipeline;
+	pipeline.set_cancel([&] { link.abort(); });
+	const bevfusion::BandLayout camera_layout{80, 180, 180};
+	const bevfusion::BandLayout lidar_layout{256, 180, 180};
+	bool ok = pipeline.run(num_frames,
+		[&](FuserInput& in, int frame, bevfusion::RowProgress& rows) {
+			// 主控先转发 LiDAR 的全部行带，再转发相机的；进度先数 LiDAR 的行，再接着数相机的（见 fuser.h）
+			if (!bevfusion::receive_bands(link, lidar_layout, frame, in.lidar.data(), &rows)) return false;
+			for (int b = 0; b < camera_layout.num_bands(); ++b) {
+				if (!bevfusion::receive_band(link, camera_layout, frame, b, in.camera.data(), &rows, kFuserLidarRows)) return false;
+			}
+			return true;
+		},
+		[&](const FuserInput& in, FuserOutput& out, int frame, const bevfusion::RowProgress& rows) {
+			std::cout << "-------------------------------- 帧 " << frame << std::endl;
+			return fuser(in.camera.data(), in.lidar.data(), out.fused.data(), &rows);
+		},
+		[&](const FuserOutput& out, int frame) {
+			return bevfusion::send_bands(link, bevfusion::BandLayout{512, 180, 180}, frame, out.fused.data());
+		},
+		true);
+	pipeline.print_stats("fuser");
+	std::cout << "fuser 峰值 RSS " << bevfusion::peak_rss_mb() << " MB" << std::endl;
+	return ok ? 0 : 1;
+}
@@ -1,51 +1,85 @@
 #include <iostream>
 #include </usr/local/include/onnxruntime/onnxruntime_cxx_api.h>
+#include <memory>
+#include <string>
 #include <vector>
 #include <cstdint>
 #include <cassert>
 #include "head.h"
-#include "pipe_comm.h"
-#include "apis_c.h"
-
-InterChiplet::PipeComm global_pipe_comm;
-
-// Convert float32 to float16 (IEEE 754 Half-precision)
-uint16_t float32_to_float16(float value) {
-    uint32_t f = *(uint32_t*)&value;
-    uint16_t h = ((f >> 16) & 0x8000) | ((((f & 0x7f800000) - 0x38000000) >> 13) & 0x7c00) | ((f >> 13) & 0x03ff);
-    return h;
+#include "kernels.h"
+#include "band_stream.h"
+
+static_assert(sizeof(Ort::Float16_t) == sizeof(uint16_t), "Ort::Float16_t 应与 uint16_t 布局一致");
+
+// ORT 环境与会话只创建一次：常驻的 head 进程逐帧复用，模型加载时间不计入每帧
+struct HeadModel {
+    Ort::Env env{ORT_LOGGING_LEVEL_WARNING, "ONNXRuntime"};
+    Ort::Session session{nullptr};
+    std::string input_name;
+    std::vector<int64_t> input_shape;
+    std::vector<std::string> output_names;
+};
+
+// 第一次调用时加载，失败时打印原因并返回 nullptr（之后的调用也返回 nullptr，不重复尝试）
+static HeadModel* head_model() {
+    static std::unique_ptr<HeadModel> model = []() -> std::unique_ptr<HeadModel> {
+        try {
+            std::unique_ptr<HeadModel> m(new HeadModel());
+            // Create session options and load the .ort model
+            Ort::SessionOptions session_options;
+            std::string model_path = "/home/ting/SourceCode/BEVfusion-code/head/optimized_model.ort";
+            m->session = Ort::Session(m->env, model_path.c_str(), session_options);
+            std::cout << " ORT model loaded successfully!" << std::endl;
+
+            // Get input / output information
+            Ort::AllocatorWithDefaultOptions allocator;
+            m->input_name = m->session.GetInputNameAllocated(0, allocator).get();
+            m->input_shape = m->session.GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+            std::cout << " Input name: " << m->input_name << std::endl;
+            std::cout << " Input shape: [";
+            for (size_t i = 0; i < m->input_shape.size(); i++) {
+                std::cout << m->input_shape[i] << (i < m->input_shape.size() - 1 ? ", " : "");
+            }
+            std::cout << "]" << std::endl;
+            size_t num_outputs = m->session.GetOutputCount();
+            std::cout << " Number of outputs: " << num_outputs << std::endl;
+            for (size_t i = 0; i < num_outputs; i++) {
+                m->output_names.push_back(m->session.GetOutputNameAllocated(i, allocator).get());
+                std::cout << " Output " << i << " name: " << m->output_names.back() << std::endl;
+            }
+            return m;
+        } catch (const Ort::Exception& e) {
+            std::cerr << "head 模型加载失败: " << e.what() << std::endl;
+            return nullptr;
+        }
+    }();
+    return model.get();
 }
 
-void head(float* input) {
-    // 1. Create ONNX Runtime environment
-    Ort::Env env(ORT_LOGGING_LEVEL_WARNING, "ONNXRuntime");
-
-    // 2. Create session options
-    Ort::SessionOptions session_options;
+bool head_load_model() { return head_model() != nullptr; }
 
-    // 3. Load .ort model
-    std::string model_path = "/home/ting/SourceCode/BEVfusion-code/head/optimized_model.ort";
-    Ort::Session session(env, model_path.c_str(), session_options);
-
-    std::cout << " ORT model loaded successfully!" << std::endl;
-
-    // 4. Get input information
-    Ort::AllocatorWithDefaultOptions allocator;
-    auto input_name = session.GetInputNameAllocated(0, allocator);
-    auto input_shape = session.GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
-
-    std::cout << " Input name: " << input_name.get() << std::endl;
-    std::cout << " Input shape: [";
-    for (size_t i = 0; i < input_shape.size(); i++) {
-        std::cout << input_shape[i] << (i < input_shape.size() - 1 ? ", " : "");
-    }
-    std::cout << "]" << std::endl;
+bool head(const float* input, const bevfusion::RowProgress* rows) {
+    HeadModel* model = head_model();
+    if (!model) return false;
+    const std::vector<int64_t>& input_shape = model->input_shape;
 
-    // 5. Convert float32 to float16 and create input tensor
+    // 5. Convert float32 to float16 (round-to-nearest-even, dispatched by CPU ISA) and create input tensor
+    //    When rows is given the input is still arriving in row bands: convert each band as soon as it lands.
     std::vector<Ort::Float16_t> input_tensor(input_shape[0] * input_shape[1] * input_shape[2] * input_shape[3]);
-    for (size_t i = 0; i < input_tensor.size(); i++) {
-        uint16_t f16 = float32_to_float16(input[i]);
-        input_tensor[i].val = f16;
+    uint16_t* input_f16 = reinterpret_cast<uint16_t*>(input_tensor.data());
+    if (rows) {
+        const bevfusion::BandLayout layout{512, 180, 180};
+        const size_t plane = 180 * 180;
+        for (int b = 0; b < layout.num_bands(); ++b) {
+            if (!rows->wait(layout.row0(b) + layout.rows(b))) return false;
+            size_t offset = static_cast<size_t>(layout.row0(b)) * layout.width;
+            size_t n = static_cast<size_t>(layout.rows(b)) * layout.width;
+            for (int c = 0; c < layout.channels; ++c) {
+                bevfusion::f32_to_f16(input + c * plane + offset, input_f16 + c * plane + offset, n);
+            }
+        }
+    } else {
+        bevfusion::f32_to_f16(input, input_f16, input_tensor.size());
     }
 
     // 6. Create ONNX Runtime tensor with float16 data
@@ -57,21 +91,11 @@ void head(float* input) {
     assert(input_tensor_value.IsTensor());
 
     // 7. Run inference
-    // 获取输出数量
-    size_t num_outputs = session.GetOutputCount();
-    std::cout << " Number of outputs: " << num_outputs << std::endl;
-
-    // 准备输出名称
-    std::vector<const char*> output_names(num_outputs);
-    std::vector<Ort::AllocatedStringPtr> output_names_ptr;
-    for (size_t i = 0; i < num_outputs; i++) {
-        output_names_ptr.push_back(session.GetOutputNameAllocated(i, allocator));
-        output_names[i] = output_names_ptr.back().get();
-        std::cout << " Output " << i << " name: " << output_names[i] << std::endl;
-    }
-
-    const char* input_names[] = {input_name.get()};
-    auto output_tensors = session.Run(
+    std::vector<const char*> output_names;
+    for (const std::string& name : model->output_names) output_names.push_back(name.c_str());
+    size_t num_outputs = output_names.size();
+    const char* input_names[] = {model->input_name.c_str()};
+    auto output_tensors = model->session.Run(
         Ort::RunOptions{nullptr}, 
         input_names, 
         &input_tensor_value, 
@@ -102,25 +126,5 @@ void head(float* input) {
     }
 
     // return output_data;
-}
-
-int main(int argc, char** argv) {
-    int idX = atoi(argv[1]);
-    int idY = atoi(argv[2]);
-    float* input = new float[512 * 180 * 180];
-    // for (size_t i = 0; i < 512 * 180 * 180; ++i) {
-    //     input[i] = 1.0f;
-    // }
-    long long unsigned int timeNow = 1;
-    std::string fileName = InterChiplet::receiveSync(5, 5, idX, idY);
-    global_pipe_comm.read_data(fileName.c_str(), input, 512 * 180 * 180 * sizeof(float));
-    long long int time_end = InterChiplet::readSync(timeNow, 5, 5, idX, idY, 512 * 180 * 180 * sizeof(float), 0);
-    std::cout<<"--------------------------------"<<std::endl;
-    head(input);
-    bool finished = true;
-    fileName = InterChiplet::sendSync(idX, idY, 5, 5);
-    global_pipe_comm.write_data(fileName.c_str(), &finished, sizeof(bool));
-    time_end = InterChiplet::writeSync(time_end, idX, idY, 5, 5, sizeof(bool), 0);
-    std::cout << "head done" << std::endl;
-    return 0;
+    return true;
 }
@@ -1,6 +1,12 @@
 #ifndef HEAD_H
 #define HEAD_H
 
-void head(float* input);
+namespace bevfusion { class RowProgress; }
+
+// 创建 ORT 会话并读入模型，进程内只做一次（head() 第一次调用时也会自动完成）；失败时打印原因并返回 false
+bool head_load_model();
+
+// input: 1×512×180×180。rows 非空时输入仍在按行带到达，fp16 转换逐行带等待；接收中止或模型加载失败时返回 false
+bool head(const float* input, const bevfusion::RowProgress* rows = nullptr);
 
 #endif
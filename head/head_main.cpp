@@ -0,0 +1,45 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "head.h"
+#include "chiplet_link.h"
+#include "stage_pipeline.h"
+
+struct HeadInput {
+    std::vector<float> features = std::vector<float>(512 * 180 * 180);
+};
+
+struct HeadOutput {
+    bool finished = false;
+};
+
+// 用法: head <idX> <idY> [帧数]
+int main(int argc, char** argv) {
+    int idX = atoi(argv[1]);
+    int idY = atoi(argv[2]);
+    int num_frames = argc > 3 ? atoi(argv[3]) : 1;
+    bevfusion::ChipletLink link(idX, idY);
+    if (!link.open()) return 1;
+    // 模型在进入流水线之前加载，之后每帧复用同一个会话
+    if (!head_load_model()) return 1;
+    bevfusion::StagePipeline<HeadInput, HeadOutput> pipeline;
+    pipeline.set_cancel([&] { link.abort(); });
+    const bevfusion::BandLayout layout{512, 180, 180};
+    bool ok = pipeline.run(num_frames,
+        [&](HeadInput& in, int frame, bevfusion::RowProgress& rows) {
+            return bevfusion::receive_bands(link, layout, frame, in.features.data(), &rows);
+        },
+        [&](const HeadInput& in, HeadOutput& out, int frame, const bevfusion::RowProgress& rows) {
+            std::cout << "-------------------------------- 帧 " << frame << std::endl;
+            // 边收边把已到达的行带转成 fp16
+            out.finished = head(in.features.data(), &rows);
+            return out.finished;
+        },
+        [&](const HeadOutput& out, int) {
+            return link.send(&out.finished, sizeof(bool));
+        },
+        true);
+    pipeline.print_stats("head");
+    std::cout << "head done" << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,270 @@
+#ifndef INDICE_KEY_H
+#define INDICE_KEY_H
+
+// 子流形稀疏卷积的坐标哈希与规则表（rulebook）
+//
+// 子流形卷积的输出位置就是输入的活跃体素，同一分辨率下连续的几层共享同一组活跃体素，
+// 因此邻居关系只需按分辨率建一次：各层以相同的 indice key（如 "subm1"）取同一份规则表。
+// 规则表按输出行存放：neighbors[o][k] 为输出行 o 在核偏移 k 上的输入行，没有时为 -1，
+// 由 sparse_gemm.h 按输出行分块计算。子流形卷积的输出行就是活跃体素在输入中的行号，不需要合并或排序。
+// 建表时顺带统计 gather 的局部性：输入行与输出行的距离越小，邻居特征越可能还在缓存里。
+// 带 stride 的普通稀疏卷积先由输入散射生成输出坐标集合（并发哈希去重），再按同样的方式建规则表。
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "morton.h"
+
+namespace bevfusion {
+
+// 体素坐标 → 行号的开放寻址哈希表（线性探测），容量为 2 的幂且不小于 2N
+class CoordHash {
+public:
+    // coords: N×3 (d0, d1, d2)，size: 三个维度的尺寸
+    void build(const int32_t* coords, int64_t n, const int64_t size[3]) {
+        size_[0] = size[0];
+        size_[1] = size[1];
+        size_[2] = size[2];
+        uint64_t capacity = 16;
+        while (capacity < static_cast<uint64_t>(n) * 2) capacity <<= 1;
+        mask_ = capacity - 1;
+        keys_.assign(capacity, kEmpty);
+        rows_.assign(capacity, -1);
+        for (int64_t i = 0; i < n; ++i) {
+            const int32_t* c = coords + i * 3;
+            int64_t key = pack(c[0], c[1], c[2]);
+            uint64_t slot = hash(key) & mask_;
+            while (keys_[slot] != kEmpty && keys_[slot] != key) slot = (slot + 1) & mask_;
+            if (keys_[slot] == kEmpty) {
+                keys_[slot] = key;
+                rows_[slot] = static_cast<int32_t>(i);
+            }
+        }
+    }
+
+    // 坐标对应的行号，越界或不存在时返回 -1
+    int32_t find(int64_t d0, int64_t d1, int64_t d2) const {
+        if (d0 < 0 || d0 >= size_[0] || d1 < 0 || d1 >= size_[1] || d2 < 0 || d2 >= size_[2]) return -1;
+        int64_t key = pack(d0, d1, d2);
+        for (uint64_t slot = hash(key) & mask_;; slot = (slot + 1) & mask_) {
+            if (keys_[slot] == key) return rows_[slot];
+            if (keys_[slot] == kEmpty) return -1;
+        }
+    }
+
+private:
+    static constexpr int64_t kEmpty = -1;
+
+    int64_t pack(int64_t d0, int64_t d1, int64_t d2) const { return (d0 * size_[1] + d1) * size_[2] + d2; }
+
+    static uint64_t hash(int64_t key) {
+        uint64_t h = static_cast<uint64_t>(key) * 0x9e3779b97f4a7c15ull;
+        return h ^ (h >> 32);
+    }
+
+    int64_t size_[3] = {0, 0, 0};
+    uint64_t mask_ = 0;
+    std::vector<int64_t> keys_;
+    std::vector<int32_t> rows_;
+};
+
+// 子流形卷积的规则表：neighbors 为 [N][K]，k 为展平的核偏移；中心偏移（center）把每行映射到自身
+struct SubmRulebook {
+    // 统计 gather 局部性时视为“近邻”的行距
+    static constexpr int32_t kNearRows = 64;
+
+    int kernel_volume = 0;
+    int center = -1;
+    int64_t num_rows = 0;
+    int64_t num_pairs = 0;              // 不含中心偏移的配对数
+    std::vector<int32_t> neighbors;
+    double mean_gather_distance = 0.0;  // 非中心配对的 |输入行 - 输出行| 均值
+    double near_gather_ratio = 0.0;     // 其中行距不超过 kNearRows 的比例
+};
+
+// 按 out(p) = Σ_k W[k]·in(p + k - padding) 建立规则表，coords 为 N×3 的活跃体素坐标
+inline SubmRulebook build_subm_rulebook(const int32_t* coords, int64_t n, const int64_t size[3], const int64_t kernel[3],
+                                        const int64_t padding[3]) {
+    SubmRulebook rb;
+    rb.kernel_volume = static_cast<int>(kernel[0] * kernel[1] * kernel[2]);
+    rb.num_rows = n;
+    if (kernel[0] == 2 * padding[0] + 1 && kernel[1] == 2 * padding[1] + 1 && kernel[2] == 2 * padding[2] + 1) {
+        rb.center = static_cast<int>((padding[0] * kernel[1] + padding[1]) * kernel[2] + padding[2]);
+    }
+
+    CoordHash hash;
+    hash.build(coords, n, size);
+
+    const int K = rb.kernel_volume;
+    rb.neighbors.resize(static_cast<size_t>(n) * K);
+    int64_t pairs = 0, near_pairs = 0;
+    double distance_sum = 0.0;
+    #pragma omp parallel for schedule(static) reduction(+ : pairs, near_pairs, distance_sum)
+    for (int64_t i = 0; i < n; ++i) {
+        const int32_t* c = coords + i * 3;
+        int32_t* nb = rb.neighbors.data() + i * K;
+        int k = 0;
+        for (int64_t k0 = 0; k0 < kernel[0]; ++k0) {
+            for (int64_t k1 = 0; k1 < kernel[1]; ++k1) {
+                for (int64_t k2 = 0; k2 < kernel[2]; ++k2, ++k) {
+                    if (k == rb.center) {
+                        nb[k] = static_cast<int32_t>(i);
+                        continue;
+                    }
+                    nb[k] = hash.find(c[0] + k0 - padding[0], c[1] + k1 - padding[1], c[2] + k2 - padding[2]);
+                    if (nb[k] < 0) continue;
+                    const int64_t d = std::llabs(static_cast<int64_t>(nb[k]) - i);
+                    pairs++;
+                    near_pairs += d <= SubmRulebook::kNearRows;
+                    distance_sum += static_cast<double>(d);
+                }
+            }
+        }
+    }
+    rb.num_pairs = pairs;
+    if (pairs > 0) {
+        rb.mean_gather_distance = distance_sum / pairs;
+        rb.near_gather_ratio = static_cast<double>(near_pairs) / pairs;
+    }
+    return rb;
+}
+
+// 输出尺寸：(in + 2·padding - kernel) / stride + 1（dilation 为 1）
+inline int64_t conv_output_size(int64_t in, int64_t kernel, int64_t stride, int64_t padding) {
+    return (in + 2 * padding - kernel) / stride + 1;
+}
+
+// 普通稀疏卷积的规则表：输出活跃体素 out_coords（M×3，按 (d0, d1, d2) 字典序），
+// neighbors 为 [M][K]：同一输出位置在每个核偏移上至多对应一个输入
+struct ConvRulebook {
+    int kernel_volume = 0;
+    int64_t out_size[3] = {0, 0, 0};
+    int64_t num_out = 0;
+    int64_t num_pairs = 0;
+    std::vector<int32_t> out_coords;
+    std::vector<int32_t> neighbors;
+};
+
+// 按 out(o) = Σ_k W[k]·in(o·stride + k - padding) 建立规则表：输入 x 经偏移 k 落到
+// o = (x + padding - k) / stride，只有整除且落在输出范围内时才构成配对
+inline ConvRulebook build_conv_rulebook(const int32_t* coords, int64_t n, const int64_t size[3], const int64_t kernel[3],
+                                        const int64_t stride[3], const int64_t padding[3]) {
+    ConvRulebook rb;
+    rb.kernel_volume = static_cast<int>(kernel[0] * kernel[1] * kernel[2]);
+    for (int d = 0; d < 3; ++d) rb.out_size[d] = conv_output_size(size[d], kernel[d], stride[d], padding[d]);
+    const int K = rb.kernel_volume;
+    const int64_t* out_size = rb.out_size;
+
+    // 每个维度上坐标 v 经核下标 kd 落到的输出坐标，不整除或越界时为 -1；查表代替逐配对的除法
+    std::vector<int32_t> axis[3];
+    for (int d = 0; d < 3; ++d) {
+        axis[d].resize(static_cast<size_t>(size[d]) * kernel[d]);
+        for (int64_t v = 0; v < size[d]; ++v) {
+            for (int64_t kd = 0; kd < kernel[d]; ++kd) {
+                const int64_t w = v + padding[d] - kd;
+                const bool hit = w >= 0 && w % stride[d] == 0 && w / stride[d] < out_size[d];
+                axis[d][v * kernel[d] + kd] = hit ? static_cast<int32_t>(w / stride[d]) : -1;
+            }
+        }
+    }
+    // 对输入行 i 的每个有效配对调用 fn(k, 输出坐标的打包键)
+    auto for_each_target = [&](int64_t i, const auto& fn) {
+        const int32_t* c = coords + i * 3;
+        const int32_t* a0 = axis[0].data() + c[0] * kernel[0];
+        const int32_t* a1 = axis[1].data() + c[1] * kernel[1];
+        const int32_t* a2 = axis[2].data() + c[2] * kernel[2];
+        int k = 0;
+        for (int64_t k0 = 0; k0 < kernel[0]; ++k0) {
+            if (a0[k0] < 0) {
+                k += static_cast<int>(kernel[1] * kernel[2]);
+                continue;
+            }
+            for (int64_t k1 = 0; k1 < kernel[1]; ++k1) {
+                if (a1[k1] < 0) {
+                    k += static_cast<int>(kernel[2]);
+                    continue;
+                }
+                const int64_t row = (a0[k0] * out_size[1] + a1[k1]) * out_size[2];
+                for (int64_t k2 = 0; k2 < kernel[2]; ++k2, ++k) {
+                    if (a2[k2] >= 0) fn(k, row + a2[k2]);
+                }
+            }
+        }
+    };
+
+    // 1. 统计配对数，决定去重哈希表的容量（不小于 2 倍）
+    int64_t num_pairs = 0;
+    #pragma omp parallel for schedule(static) reduction(+ : num_pairs)
+    for (int64_t i = 0; i < n; ++i) {
+        for_each_target(i, [&](int, int64_t) { num_pairs++; });
+    }
+    rb.num_pairs = num_pairs;
+    uint64_t capacity = 16;
+    while (capacity < static_cast<uint64_t>(num_pairs) * 2) capacity <<= 1;
+    const uint64_t mask = capacity - 1;
+
+    // 2. 并发插入：线性探测 + CAS，记下每个配对所在的槽位
+    constexpr int64_t kEmpty = -1;
+    std::unique_ptr<std::atomic<int64_t>[]> slots_key(new std::atomic<int64_t>[capacity]);
+    #pragma omp parallel for schedule(static)
+    for (int64_t s = 0; s < static_cast<int64_t>(capacity); ++s) slots_key[s].store(kEmpty, std::memory_order_relaxed);
+    std::vector<int32_t> pair_slot(static_cast<size_t>(n) * K, -1);
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < n; ++i) {
+        for_each_target(i, [&](int k, int64_t key) {
+            uint64_t h = static_cast<uint64_t>(key) * 0x9e3779b97f4a7c15ull;
+            uint64_t slot = (h ^ (h >> 32)) & mask;
+            for (;; slot = (slot + 1) & mask) {
+                int64_t current = slots_key[slot].load(std::memory_order_relaxed);
+                if (current == kEmpty &&
+                    slots_key[slot].compare_exchange_strong(current, key, std::memory_order_relaxed)) {
+                    break;
+                }
+                if (current == key) break;
+            }
+            pair_slot[i * K + k] = static_cast<int32_t>(slot);
+        });
+    }
+
+    // 3. 取出去重后的键并排序，排序后的位置即输出行号
+    std::vector<uint64_t> keys;
+    std::vector<int32_t> key_slot;
+    for (uint64_t s = 0; s < capacity; ++s) {
+        int64_t key = slots_key[s].load(std::memory_order_relaxed);
+        if (key == kEmpty) continue;
+        keys.push_back(static_cast<uint64_t>(key));
+        key_slot.push_back(static_cast<int32_t>(s));
+    }
+    rb.num_out = static_cast<int64_t>(keys.size());
+    std::vector<int32_t> order = radix_sort_order(keys);
+    std::vector<int32_t> slot_row(capacity, -1);
+    rb.out_coords.resize(static_cast<size_t>(rb.num_out) * 3);
+    #pragma omp parallel for schedule(static)
+    for (int64_t r = 0; r < rb.num_out; ++r) {
+        const int32_t u = order[r];
+        const int64_t key = static_cast<int64_t>(keys[u]);
+        slot_row[key_slot[u]] = static_cast<int32_t>(r);
+        rb.out_coords[r * 3] = static_cast<int32_t>(key / (out_size[1] * out_size[2]));
+        rb.out_coords[r * 3 + 1] = static_cast<int32_t>(key / out_size[2] % out_size[1]);
+        rb.out_coords[r * 3 + 2] = static_cast<int32_t>(key % out_size[2]);
+    }
+
+    // 4. 按输出行填表：(输出行, k) 只会由一个输入写入，并行无冲突
+    rb.neighbors.assign(static_cast<size_t>(rb.num_out) * K, -1);
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < n; ++i) {
+        for (int k = 0; k < K; ++k) {
+            const int32_t slot = pair_slot[i * K + k];
+            if (slot >= 0) rb.neighbors[static_cast<int64_t>(slot_row[slot]) * K + k] = static_cast<int32_t>(i);
+        }
+    }
+    return rb;
+}
+
+}  // namespace bevfusion
+
+#endif  // INDICE_KEY_H
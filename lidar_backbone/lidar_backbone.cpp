@@ -1,50 +1,208 @@
 #include "lidar_backbone.h"
-#include "pipe_comm.h"
-#include "apis_c.h"
-
-InterChiplet::PipeComm global_pipe_comm;
-
-float* lidar_backbone(float* input){
-    // 创建输入 - 使用正确的空间尺寸
-    auto indices = torch::tensor({
-        {0, 0, 0},      // batch index
-        {720, 720, 720}, // z
-        {720, 720, 720}, // y
-        {20, 20, 20}     // x
-    }, torch::kLong);
-    
-    auto values = torch::from_blob(input, {3, 5}); // 5个输入通道
-    std::vector<int64_t> spatial_size = {1440, 1440, 41}; // 初始空间尺寸
+#include "point_filter.h"
+#include "sweep_voxelizer.h"
+#include "weight_bundle.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// 点云范围与体素尺寸（nuScenes 配置），得到 1440×1440×41 的体素网格
+static const bevfusion::VoxelGrid kVoxelGrid = {
+    {-54.0f, -54.0f, -5.0f, 54.0f, 54.0f, 3.0f}, {0.075f, 0.075f, 0.2f}, {1440, 1440, 41}};
+
+static bool env_flag(const char* name, bool fallback) {
+    const char* env = std::getenv(name);
+    if (!env || !*env) return fallback;
+    if (strcmp(env, "0") == 0) return false;
+    if (strcmp(env, "1") == 0) return true;
+    std::cerr << name << " 取值无效: " << env << "（可选 0 / 1）" << std::endl;
+    return fallback;
+}
+
+static bool morton_enabled = env_flag("BEVFUSION_LIDAR_MORTON", true);
+static bool profile_enabled = env_flag("BEVFUSION_LIDAR_PROFILE", false);
+
+// 累积的帧数，默认 1（只用当前帧）
+static int sweeps_from_env() {
+    const char* env = std::getenv("BEVFUSION_LIDAR_SWEEPS");
+    if (!env || !*env) return 1;
+    int sweeps = std::atoi(env);
+    if (sweeps < 1) {
+        std::cerr << "BEVFUSION_LIDAR_SWEEPS 取值无效: " << env << "（应为正整数）" << std::endl;
+        return 1;
+    }
+    return sweeps;
+}
+
+// 带时间戳和位姿的调用按帧累积；不带时间戳的调用（基准测试反复喂同一帧点云）用只保留一帧的体素化器，
+// 不进入累积的环形缓冲，也不受 BEVFUSION_LIDAR_SWEEPS 影响
+static bevfusion::SweepVoxelizer voxelizer(kVoxelGrid, sweeps_from_env());
+static bevfusion::SweepVoxelizer single_sweep_voxelizer(kVoxelGrid, 1);
+
+// 体素化前的预处理：始终裁剪到点云范围；BEVFUSION_LIDAR_GROUND=1 去除地面，
+// BEVFUSION_LIDAR_MIN_INTENSITY=x 丢弃强度低于 x 的点
+static bevfusion::PointFilterConfig filter_from_env() {
+    bevfusion::PointFilterConfig config;
+    std::copy(kVoxelGrid.range, kVoxelGrid.range + 6, config.range);
+    config.remove_ground = env_flag("BEVFUSION_LIDAR_GROUND", false);
+    const char* env = std::getenv("BEVFUSION_LIDAR_MIN_INTENSITY");
+    if (env && *env) {
+        char* end = nullptr;
+        float v = std::strtof(env, &end);
+        if (*end == '\0' && std::isfinite(v)) {
+            config.min_intensity = v;
+        } else {
+            std::cerr << "BEVFUSION_LIDAR_MIN_INTENSITY 取值无效: " << env << std::endl;
+        }
+    }
+    return config;
+}
+
+static bevfusion::PointFilter point_filter(filter_from_env());
+static std::vector<float> filtered_points;
+
+void lidar_backbone_set_morton(bool enabled) { morton_enabled = enabled; }
+
+void lidar_backbone_set_profile(bool enabled) { profile_enabled = enabled; }
+
+// libtorch 可能自带一份 OpenMP 运行时，两边分别设置
+void lidar_backbone_set_threads(int threads) {
+    at::set_num_threads(threads);
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#endif
+}
 
-    // 创建模型
-    auto model = LidarBackbone();
+// 把权重包中与模块参数同名的张量拷入参数，形状必须一致；任一参数缺失或不符时返回 false
+static bool load_weights(LidarBackboneImpl& model, const std::string& path) {
+    bevfusion::WeightBundle bundle;
+    if (!bundle.open(path)) return false;
+    bool ok = true;
+    size_t bytes = 0;
+    for (auto& param : model.named_parameters()) {
+        const bevfusion::BundleTensor* t = bundle.find(param.key());
+        torch::Tensor& dst = param.value();
+        if (!t) {
+            std::cerr << "权重包缺少 " << param.key() << ": " << path << std::endl;
+            ok = false;
+            continue;
+        }
+        if (c10::IntArrayRef(t->dims) != dst.sizes()) {
+            std::cerr << "权重 " << param.key() << " 形状不符: 文件 " << c10::IntArrayRef(t->dims) << "，模型 "
+                      << dst.sizes() << std::endl;
+            ok = false;
+            continue;
+        }
+        std::memcpy(dst.data_ptr<float>(), t->data, t->count * sizeof(float));
+        bytes += t->count * sizeof(float);
+    }
+    if (ok) std::cout << "lidar_backbone 权重已读入: " << path << "（" << bytes / (1 << 20) << " MB）" << std::endl;
+    return ok;
+}
+
+// 模型只构建一次，第一次调用时从 $BENCHMARK_ROOT/lidar_backbone/lidar_backbone.weights.bin 读入权重。
+// 权重包缺失或不完整时打印原因，沿用构造时的随机权重（输出没有意义，只用于计时）
+static LidarBackbone& lidar_model() {
+    static LidarBackbone model = [] {
+        LidarBackbone m;
+        m->eval();
+        const char* root = std::getenv("BENCHMARK_ROOT");
+        if (!root) {
+            std::cerr << "未设置 BENCHMARK_ROOT，lidar_backbone 使用随机权重" << std::endl;
+        } else if (!load_weights(*m, std::string(root) + "/lidar_backbone/lidar_backbone.weights.bin")) {
+            std::cerr << "lidar_backbone 使用随机权重" << std::endl;
+        }
+        return m;
+    }();
+    return model;
+}
+
+// 缓存计数只覆盖调用线程，以 OMP_NUM_THREADS=1 运行时即为整层的数字
+static void print_profile(const std::vector<LidarLayerProfile>& profile, bool morton) {
+    std::cout << "lidar_backbone 逐层剖析（" << (morton ? "Morton 序" : "字典序") << "）" << std::endl;
+    std::cout << std::left << std::setw(8) << "layer" << std::right << std::setw(10) << "voxels" << std::setw(10)
+              << "ms" << std::setw(10) << "reorder" << std::setw(10) << "gather" << std::setw(8) << "near%"
+              << std::setw(14) << "L1D miss" << std::setw(10) << "L2 miss%" << std::setw(10) << "LLC miss%"
+              << std::endl;
+    bool counted = false;
+    for (const auto& p : profile) {
+        std::cout << std::left << std::setw(8) << p.name << std::right << std::setw(10) << p.voxels << std::fixed
+                  << std::setprecision(2) << std::setw(10) << p.ms << std::setw(10) << p.reorder_ms;
+        if (p.mean_gather_distance >= 0) {
+            std::cout << std::setprecision(1) << std::setw(10) << p.mean_gather_distance << std::setw(8)
+                      << p.near_gather_ratio * 100;
+        } else {
+            std::cout << std::setw(10) << "-" << std::setw(8) << "-";
+        }
+        if (p.cache.valid) {
+            counted = true;
+            std::cout << std::setw(14) << p.cache.l1d_misses << std::setprecision(1) << std::setw(10)
+                      << p.cache.l2_miss_rate() * 100 << std::setw(10) << p.cache.llc_miss_rate() * 100;
+        } else {
+            std::cout << std::setw(14) << "-" << std::setw(10) << "-" << std::setw(10) << "-";
+        }
+        std::cout << std::defaultfloat << std::endl;
+    }
+    if (!counted) std::cout << "（硬件缓存计数器不可用，检查 /proc/sys/kernel/perf_event_paranoid）" << std::endl;
+}
+
+static bool run_backbone(bevfusion::SweepVoxelizer& sweeps, const float* points, int64_t num_points,
+                         uint64_t timestamp_us, const float* pose, float* output_ptr) {
+    torch::NoGradGuard no_grad;
+    // 预处理：范围裁剪、强度阈值、地面去除
+    const int64_t kept = point_filter.apply(points, num_points, 5, filtered_points);
+    const bevfusion::PointFilterStats& fs = point_filter.last_stats();
+    std::cout << "点云预处理: 输入 " << fs.points_in << "，范围外 " << fs.out_of_range << "，低强度 " << fs.low_intensity
+              << "，地面 " << fs.ground << "，保留 " << fs.points_out << "，耗时 " << fs.ms << " ms" << std::endl;
+
+    // 体素化本帧点云，并与环形缓冲中的前几帧合并
+    const bevfusion::VoxelSet& voxels = sweeps.add_sweep(filtered_points.data(), kept, timestamp_us, pose);
+    const bevfusion::SweepStats& st = sweeps.last_stats();
+    std::cout << "Voxelized " << kept << " points into " << st.new_voxels << " voxels，" << st.sweeps
+              << " 帧合并为 " << st.merged_voxels << " 个体素，体素化 " << st.voxelize_ms << " ms，合并 " << st.merge_ms
+              << " ms" << std::endl;
+    const int64_t num_voxels = voxels.num_voxels();
+    auto indices = torch::zeros({4, num_voxels}, torch::kLong);
+    if (num_voxels > 0) {
+        indices.slice(0, 1, 4).copy_(
+            torch::from_blob(const_cast<int32_t*>(voxels.coords.data()), {num_voxels, 3}, torch::kInt).t());
+    }
+    auto values = torch::from_blob(const_cast<float*>(voxels.features.data()), {num_voxels, 5}, torch::kFloat).clone();
+    std::vector<int64_t> spatial_size = {kVoxelGrid.size[0], kVoxelGrid.size[1], kVoxelGrid.size[2]};
+
+    auto& model = lidar_model();
+    model->morton = morton_enabled;
+    model->profile = profile_enabled;
     
     // 前向传播
     auto output = model->forward(indices, values, spatial_size);
     
+    if (profile_enabled) print_profile(model->last_profile, morton_enabled);
+
     // 验证输出形状是否符合预期 [1, 256, 180, 180]
     std::cout << "Output shape: " << output.sizes() << std::endl;
+    if (output.numel() != 1 * 256 * 180 * 180) {
+        std::cerr << "lidar_backbone 输出尺寸与 1×256×180×180 不符: " << output.sizes() << std::endl;
+        return false;
+    }
 
-    // 将output转换为float*
-    float* output_ptr = output.data_ptr<float>();
-    float* output_ptr_copy = (float*)malloc(1 * 256 * 180 * 180 * sizeof(float));
-    memcpy(output_ptr_copy, output_ptr, 1 * 256 * 180 * 180 * sizeof(float));
-    
-    return output_ptr_copy;
-}
-
-int main(int argc, char** argv) {
-    int idX = atoi(argv[1]);
-    int idY = atoi(argv[2]);
-    float* input = new float[3 * 5];
-    long long unsigned int timeNow = 1;
-    std::string fileName = InterChiplet::receiveSync(5, 5, idX, idY);
-    global_pipe_comm.read_data(fileName.c_str(), input, 3 * 5 * sizeof(float));
-    long long int time_end = InterChiplet::readSync(timeNow, 5, 5, idX, idY, 3 * 5 * sizeof(float), 0);
-    std::cout<<"--------------------------------"<<std::endl;  
-    float* lidar_backbone_output = lidar_backbone(input);
-    fileName = InterChiplet::sendSync(idX, idY, 5, 5);
-    global_pipe_comm.write_data(fileName.c_str(), lidar_backbone_output, 1 * 256 * 180 * 180 * sizeof(float));
-    time_end = InterChiplet::writeSync(time_end, idX, idY, 5, 5, 1 * 256 * 180 * 180 * sizeof(float), 0);
-    return 0;
+    // 写入调用方提供的输出缓冲
+    output = output.contiguous();
+    memcpy(output_ptr, output.data_ptr<float>(), 1 * 256 * 180 * 180 * sizeof(float));
+    return true;
+}
+
+bool lidar_backbone(const float* points, int64_t num_points, float* output_ptr) {
+    static const float identity[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+    return run_backbone(single_sweep_voxelizer, points, num_points, 0, identity, output_ptr);
+}
+
+bool lidar_backbone(const float* points, int64_t num_points, uint64_t timestamp_us, const float* pose,
+                    float* output_ptr) {
+    return run_backbone(voxelizer, points, num_points, timestamp_us, pose, output_ptr);
 }
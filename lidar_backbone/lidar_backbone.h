@@ -1,6 +1,19 @@
 #pragma once
 #include <torch/torch.h>
+#include <chrono>
 #include "sparse_conv.h"
+#include "perf_counters.h"
+
+// 逐层剖析记录，LidarBackboneImpl::profile 开启时由 forward 填写
+struct LidarLayerProfile {
+    std::string name;
+    int64_t voxels = 0;                 // 本层输出的活跃体素数
+    double ms = 0.0;
+    double reorder_ms = 0.0;            // 本层输出的 Morton 重排耗时
+    double mean_gather_distance = -1;   // 子流形层规则表的 gather 局部性，普通稀疏卷积为 -1
+    double near_gather_ratio = -1;
+    bevfusion::CacheCounts cache;
+};
 
 class LidarBackboneImpl : public torch::nn::Module {
 public:
@@ -8,192 +21,203 @@ public:
         auto create_conv = [](int64_t in_channels, int64_t out_channels, 
                              std::vector<int64_t> kernel_size,
                              std::vector<int64_t> padding,
-                             bool subm = true) {
-            auto conv = SubMConv3d(std::make_shared<SubMConv3dImpl>(
+                             std::vector<int64_t> stride,
+                             std::string indice_key = "") {
+            return SubMConv3d(std::make_shared<SubMConv3dImpl>(
                 in_channels, 
                 out_channels,
                 torch::ExpandingArray<3>(kernel_size),
-                torch::ExpandingArray<3>(padding)
+                torch::ExpandingArray<3>(padding),
+                torch::ExpandingArray<3>(stride),
+                indice_key
             ));
-            if(!subm) conv->set_stride({2,2,2});
-            return conv;
         };
 
+        // 同一 block 内的子流形层作用在同一组活跃体素上，以 indice key 共享规则表
         // Block 1 (subm=True)
-        conv0_ = register_module("conv0", create_conv(5, 16, {3,3,3}, {1,1,1}));
-        conv1_ = register_module("conv1", create_conv(16, 16, {3,3,3}, {1,1,1}));
-        conv2_ = register_module("conv2", create_conv(16, 16, {3,3,3}, {1,1,1}));
-        conv3_ = register_module("conv3", create_conv(16, 16, {3,3,3}, {1,1,1}));
-        conv4_ = register_module("conv4", create_conv(16, 16, {3,3,3}, {1,1,1}));
-
-        // Block 2 (subm=False, stride=2)
-        conv5_ = register_module("conv5", create_conv(16, 32, {3,3,3}, {1,1,1}, false));
-        // 根据ONNX设置stride=2
-        conv5_->set_stride({2,2,2});
-        conv6_ = register_module("conv6", create_conv(32, 32, {3,3,3}, {1,1,1}));
-        conv7_ = register_module("conv7", create_conv(32, 32, {3,3,3}, {1,1,1}));
-        conv8_ = register_module("conv8", create_conv(32, 32, {3,3,3}, {1,1,1}));
-        conv9_ = register_module("conv9", create_conv(32, 32, {3,3,3}, {1,1,1}));
-
-        // 第三个block: 64通道
-        conv10_ = register_module("conv10", create_conv(32, 64, {3,3,3}, {1,1,1}));
-        conv11_ = register_module("conv11", create_conv(64, 64, {3,3,3}, {1,1,1}));
-        conv12_ = register_module("conv12", create_conv(64, 64, {3,3,3}, {1,1,1}));
-        conv13_ = register_module("conv13", create_conv(64, 64, {3,3,3}, {1,1,1}));
-        conv14_ = register_module("conv14", create_conv(64, 64, {3,3,3}, {1,1,1}));
-
-        // 第四个block: 128通道
-        conv15_ = register_module("conv15", create_conv(64, 128, {3,3,3}, {1,1,1}));
-        conv16_ = register_module("conv16", create_conv(128, 128, {3,3,3}, {1,1,1}));
-        conv17_ = register_module("conv17", create_conv(128, 128, {3,3,3}, {1,1,1}));
-        conv18_ = register_module("conv18", create_conv(128, 128, {3,3,3}, {1,1,1}));
-        conv19_ = register_module("conv19", create_conv(128, 128, {3,3,3}, {1,1,1}));
-
-        // 最后的1x1x3卷积
-        conv20_ = register_module("conv20", create_conv(128, 128, {1,1,3}, {0,0,0}, false));
-        // 根据ONNX设置stride=2
-        conv20_->set_stride({1,1,2});
+        conv0_ = register_module("conv0", create_conv(5, 16, {3,3,3}, {1,1,1}, {1,1,1}, "subm1"));
+        conv1_ = register_module("conv1", create_conv(16, 16, {3,3,3}, {1,1,1}, {1,1,1}, "subm1"));
+        conv2_ = register_module("conv2", create_conv(16, 16, {3,3,3}, {1,1,1}, {1,1,1}, "subm1"));
+        conv3_ = register_module("conv3", create_conv(16, 16, {3,3,3}, {1,1,1}, {1,1,1}, "subm1"));
+        conv4_ = register_module("conv4", create_conv(16, 16, {3,3,3}, {1,1,1}, {1,1,1}, "subm1"));
+
+        // Block 2：conv5 是 stride 2 的普通稀疏卷积，[1440, 1440, 41] -> [720, 720, 21]
+        conv5_ = register_module("conv5", create_conv(16, 32, {3,3,3}, {1,1,1}, {2,2,2}));
+        conv6_ = register_module("conv6", create_conv(32, 32, {3,3,3}, {1,1,1}, {1,1,1}, "subm2"));
+        conv7_ = register_module("conv7", create_conv(32, 32, {3,3,3}, {1,1,1}, {1,1,1}, "subm2"));
+        conv8_ = register_module("conv8", create_conv(32, 32, {3,3,3}, {1,1,1}, {1,1,1}, "subm2"));
+        conv9_ = register_module("conv9", create_conv(32, 32, {3,3,3}, {1,1,1}, {1,1,1}, "subm2"));
+
+        // 第三个block: 64通道；conv10 同 conv5，[720, 720, 21] -> [360, 360, 11]
+        conv10_ = register_module("conv10", create_conv(32, 64, {3,3,3}, {1,1,1}, {2,2,2}));
+        conv11_ = register_module("conv11", create_conv(64, 64, {3,3,3}, {1,1,1}, {1,1,1}, "subm3"));
+        conv12_ = register_module("conv12", create_conv(64, 64, {3,3,3}, {1,1,1}, {1,1,1}, "subm3"));
+        conv13_ = register_module("conv13", create_conv(64, 64, {3,3,3}, {1,1,1}, {1,1,1}, "subm3"));
+        conv14_ = register_module("conv14", create_conv(64, 64, {3,3,3}, {1,1,1}, {1,1,1}, "subm3"));
+
+        // 第四个block: 128通道；conv15 的 d2 方向不补零，[360, 360, 11] -> [180, 180, 5]
+        conv15_ = register_module("conv15", create_conv(64, 128, {3,3,3}, {1,1,0}, {2,2,2}));
+        conv16_ = register_module("conv16", create_conv(128, 128, {3,3,3}, {1,1,1}, {1,1,1}, "subm4"));
+        conv17_ = register_module("conv17", create_conv(128, 128, {3,3,3}, {1,1,1}, {1,1,1}, "subm4"));
+        conv18_ = register_module("conv18", create_conv(128, 128, {3,3,3}, {1,1,1}, {1,1,1}, "subm4"));
+        conv19_ = register_module("conv19", create_conv(128, 128, {3,3,3}, {1,1,1}, {1,1,1}, "subm4"));
+
+        // 最后的1x1x3卷积，只在 d2 方向 stride 2：[180, 180, 5] -> [180, 180, 2]
+        conv20_ = register_module("conv20", create_conv(128, 128, {1,1,3}, {0,0,0}, {1,1,2}));
     }
 
+    // 活跃体素按 Morton 序存放：体素化结果和 conv5/10/15 的输出（下一级子流形层的输入）各重排一次。
+    // 关闭时保持体素化顺序和 coalesce() 的字典序
+    bool morton = true;
+    // 开启时 forward 把每层的耗时、gather 局部性和缓存计数写入 last_profile
+    bool profile = false;
+    std::vector<LidarLayerProfile> last_profile;
+
+    // conv0~4、conv6~9、conv11~14、conv16~19 是子流形卷积：输出与输入的活跃体素相同、行序不变，
+    // 残差在特征矩阵上就地逐行计算。conv5/10/15/20 是普通稀疏卷积，其输出给出下一级的活跃体素
     torch::Tensor forward(torch::Tensor indices, 
                          torch::Tensor values,
                          c10::ArrayRef<int64_t> spatial_size) {
-        // 初始空间尺寸 [1440, 1440, 41]
-        std::vector<int64_t> curr_size = {1440, 1440, 41};
-        
-        // Block 1
-        auto x1 = conv0_->forward(indices, values, curr_size);
-        auto x2 = conv1_->forward(x1.indices(), x1.values(), curr_size);
-        auto x3 = conv2_->forward(x2.indices(), x2.values(), curr_size);
-        x3 = x3 + x1;  // residual connection
-        x3 = torch::relu(x3);
-        
-        auto x4 = conv3_->forward(x3.indices(), x3.values(), curr_size);
-        auto x5 = conv4_->forward(x4.indices(), x4.values(), curr_size);
-        x5 = x5 + x3;  // residual connection
-        x5 = torch::relu(x5);
-        std::cout << "Block 1 output shape: " << x5.sizes() << std::endl;
-
-        // Block 2 - 调整padding保持尺寸匹配
-        curr_size = {720, 720, 21};
-        auto x6 = conv5_->forward(x5.indices(), x5.values(), curr_size);
-        auto x7 = conv6_->forward(x6.indices(), x6.values(), curr_size);
-        auto x8 = conv7_->forward(x7.indices(), x7.values(), curr_size);
-        
-        // 添加尺寸调整操作
-        if (x8.sizes()[0] != x6.sizes()[0]) {
-            x6 = adjust_spatial_size(x6, x8.sizes().slice(0,3));
+        auto keys = std::make_shared<IndiceKeyCache>();
+        SparseConvTensor input{indices, values.contiguous(), spatial_size.vec(), keys};
+        last_profile.clear();
+        if (profile && !counters_) counters_ = std::make_unique<bevfusion::CacheCounters>();
+        auto level_start = std::chrono::steady_clock::now();
+        if (morton) {
+            auto t0 = std::chrono::steady_clock::now();
+            input.morton_sort_();
+            if (profile) {
+                LidarLayerProfile p;
+                p.name = "input";
+                p.voxels = input.num_voxels();
+                p.reorder_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+                last_profile.push_back(p);
+            }
         }
-        x8 = x8 + x6;  // residual connection
-        x8 = torch::relu(x8);
+        report_level("input", input, level_start);
 
-        auto x9 = conv8_->forward(x8.indices(), x8.values(), curr_size);
-        auto x10 = conv9_->forward(x9.indices(), x9.values(), curr_size);
-        x10 = x10 + x8;  // residual connection
-        x10 = torch::relu(x10);
-        std::cout << "Block 2 output shape: " << x10.sizes() << std::endl;
+        // Block 1
+        auto x1 = run_layer("conv0", conv0_, input);
+        auto x2 = run_layer("conv1", conv1_, x1);
+        auto x3 = run_layer("conv2", conv2_, x2);
+        x3.add_relu_(x1);  // residual connection
+        
+        auto x4 = run_layer("conv3", conv3_, x3);
+        auto x5 = run_layer("conv4", conv4_, x4);
+        x5.add_relu_(x3);  // residual connection
+        report_level("block1", x5, level_start);
+
+        // Block 2
+        auto x6 = run_layer("conv5", conv5_, x5, true);
+        auto x7 = run_layer("conv6", conv6_, x6);
+        auto x8 = run_layer("conv7", conv7_, x7);
+        x8.add_relu_(x6);  // residual connection
+
+        auto x9 = run_layer("conv8", conv8_, x8);
+        auto x10 = run_layer("conv9", conv9_, x9);
+        x10.add_relu_(x8);  // residual connection
+        report_level("block2", x10, level_start);
 
         // Block 3
-        curr_size = {360, 360, 11};
-        auto x11 = conv10_->forward(x10.indices(), x10.values(), curr_size);
-        auto x12 = conv11_->forward(x11.indices(), x11.values(), curr_size);
-        auto x13 = conv12_->forward(x12.indices(), x12.values(), curr_size);
-        x13 = x13 + x11;  // residual connection
-        x13 = torch::relu(x13);
-
-        auto x14 = conv13_->forward(x13.indices(), x13.values(), curr_size);
-        auto x15 = conv14_->forward(x14.indices(), x14.values(), curr_size);
-        x15 = x15 + x13;  // residual connection
-        x15 = torch::relu(x15);
-        std::cout << "Block 3 output shape: " << x15.sizes() << std::endl;
+        auto x11 = run_layer("conv10", conv10_, x10, true);
+        auto x12 = run_layer("conv11", conv11_, x11);
+        auto x13 = run_layer("conv12", conv12_, x12);
+        x13.add_relu_(x11);  // residual connection
 
-        // Block 4
-        curr_size = {180, 180, 5};
-        auto x16 = conv15_->forward(x15.indices(), x15.values(), curr_size);
-        auto x17 = conv16_->forward(x16.indices(), x16.values(), curr_size);
-        auto x18 = conv17_->forward(x17.indices(), x17.values(), curr_size);
-        x18 = x18 + x16;  // residual connection
-        x18 = torch::relu(x18);
-
-        auto x19 = conv18_->forward(x18.indices(), x18.values(), curr_size);
-        auto x20 = conv19_->forward(x19.indices(), x19.values(), curr_size);
-        x20 = x20 + x18;  // residual connection
-        x20 = torch::relu(x20);
-        std::cout << "Block 4 output shape: " << x20.sizes() << std::endl;
+        auto x14 = run_layer("conv13", conv13_, x13);
+        auto x15 = run_layer("conv14", conv14_, x14);
+        x15.add_relu_(x13);  // residual connection
+        report_level("block3", x15, level_start);
 
-        // Final 1x1 conv
-        auto x21 = conv20_->forward(x20.indices(), x20.values(), curr_size);
-        std::cout << "Block 5 output shape: " << x21.sizes() << std::endl;
+        // Block 4
+        auto x16 = run_layer("conv15", conv15_, x15, true);
+        auto x17 = run_layer("conv16", conv16_, x16);
+        auto x18 = run_layer("conv17", conv17_, x17);
+        x18.add_relu_(x16);  // residual connection
 
-        // 最终输出处理
-        auto dense_output = sparse_to_dense(x21, {180, 180, 2});
-        std::cout << "dense_output output shape: " << dense_output.sizes() << std::endl;
-        auto output = dense_output.permute({0, 4, 1, 2, 3}); // [1, C, D, H, W]
-        std::cout << "output output shape: " << output.sizes() << std::endl;
-        output = output.reshape({1, 256, 180, 180}); // 最终reshape到目标形状
-        std::cout << "output_reshape output shape: " << output.sizes() << std::endl;
+        auto x19 = run_layer("conv18", conv18_, x18);
+        auto x20 = run_layer("conv19", conv19_, x19);
+        x20.add_relu_(x18);  // residual connection
+        report_level("block4", x20, level_start);
+        keys->print_summary();
 
+        // Final 1x1 conv
+        auto x21 = run_layer("conv20", conv20_, x20);
+        report_level("conv20", x21, level_start);
+
+        // 稠密化后把 d2 并入通道：[1, d0, d1, d2, C] -> [1, C, d2, d0, d1] -> [1, C·d2, d0, d1]，
+        // 通道下标为 c·d2 + z，与 SparseEncoder 的 BEV 展平顺序一致
+        auto dense_output = x21.to_dense();
+        const int64_t C = dense_output.size(4);
+        const auto& size = x21.spatial_size;
+        auto output = dense_output.permute({0, 4, 3, 1, 2}).reshape({1, C * size[2], size[0], size[1]});
         return output;
     }
 
 private:
+    // reorder: 本层输出是下一组子流形层的输入，按 Morton 序重排后再建规则表
+    SparseConvTensor run_layer(const char* name, SubMConv3d& conv, const SparseConvTensor& x, bool reorder = false) {
+        if (!profile) {
+            SparseConvTensor y = conv->forward(x);
+            if (reorder && morton) y.morton_sort_();
+            return y;
+        }
+        using clock = std::chrono::steady_clock;
+        LidarLayerProfile p;
+        p.name = name;
+        counters_->start();
+        auto t0 = clock::now();
+        SparseConvTensor y = conv->forward(x);
+        auto t1 = clock::now();
+        p.cache = counters_->stop();
+        if (reorder && morton) {
+            y.morton_sort_();
+            p.reorder_ms = std::chrono::duration<double, std::milli>(clock::now() - t1).count();
+        }
+        p.ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        p.voxels = y.num_voxels();
+        if (const SubmRules* rules = conv->indice_key().empty() ? nullptr : x.keys->find(conv->indice_key())) {
+            p.mean_gather_distance = rules->rulebook.mean_gather_distance;
+            p.near_gather_ratio = rules->rulebook.near_gather_ratio;
+        }
+        last_profile.push_back(p);
+        return y;
+    }
+
+    // 每级输出的空间尺寸、活跃体素数和自上一级以来的耗时
+    static void report_level(const char* name, const SparseConvTensor& x,
+                             std::chrono::steady_clock::time_point& start) {
+        auto now = std::chrono::steady_clock::now();
+        std::cout << name << ": 空间 " << c10::IntArrayRef(x.spatial_size) << "，体素 " << x.num_voxels() << " × "
+                  << x.features.size(1) << "，耗时 " << std::chrono::duration<double, std::milli>(now - start).count()
+                  << " ms" << std::endl;
+        start = now;
+    }
+
+    std::unique_ptr<bevfusion::CacheCounters> counters_;
     SubMConv3d conv0_{nullptr}, conv1_{nullptr}, conv2_{nullptr}, conv3_{nullptr}, conv4_{nullptr};
     SubMConv3d conv5_{nullptr}, conv6_{nullptr}, conv7_{nullptr}, conv8_{nullptr}, conv9_{nullptr};
     SubMConv3d conv10_{nullptr}, conv11_{nullptr}, conv12_{nullptr}, conv13_{nullptr}, conv14_{nullptr};
     SubMConv3d conv15_{nullptr}, conv16_{nullptr}, conv17_{nullptr}, conv18_{nullptr}, conv19_{nullptr};
     SubMConv3d conv20_{nullptr};
-
-    // Helper function to convert sparse tensor to dense
-    torch::Tensor sparse_to_dense(const torch::Tensor& sparse_tensor, 
-                                c10::ArrayRef<int64_t> spatial_size) {
-        auto indices = sparse_tensor.indices();
-        auto values = sparse_tensor.values();
-        
-        // 创建5维输出张量 [1, D, H, W, C]
-        auto output_shape = std::vector<int64_t>{1}; // batch dimension
-        output_shape.insert(output_shape.end(), 
-                          spatial_size.begin(), spatial_size.end());
-        output_shape.push_back(values.size(1)); // channels
-        
-        auto dense = torch::zeros(output_shape);
-        
-        for (int64_t i = 0; i < indices.size(1); ++i) {
-            auto z = indices[0][i].item<int64_t>();
-            auto y = indices[1][i].item<int64_t>();
-            auto x = indices[2][i].item<int64_t>();
-            dense.index({0, z, y, x}) = values[i];
-        }
-        return dense;
-    }
-
-    // 修改 adjust_spatial_size 函数
-    torch::Tensor adjust_spatial_size(const torch::Tensor& input, 
-                                    c10::ArrayRef<int64_t> target_size) {
-        auto indices = input.indices();
-        auto values = input.values();
-        
-        auto mask = (indices[0] < target_size[0]) & 
-                   (indices[1] < target_size[1]) & 
-                   (indices[2] < target_size[2]);
-        
-        auto filtered_indices = indices.masked_select(mask).view({3, -1});
-        auto filtered_values = values.masked_select(
-            mask.unsqueeze(1).expand({-1, values.size(1)})).view({-1, values.size(1)});
-        
-        // 创建4维稀疏张量 [D, H, W, C]
-        std::vector<int64_t> output_shape = {
-            target_size[0], target_size[1], target_size[2], values.size(1)
-        };
-        
-        return torch::sparse_coo_tensor(
-            filtered_indices,
-            filtered_values,
-            output_shape,
-            torch::kFloat
-        ).coalesce();
-    }
 };
 
 TORCH_MODULE(LidarBackbone);
 
-float* lidar_backbone();
\ No newline at end of file
+// points: N×5 (x, y, z, intensity, time_lag)，output: 1×256×180×180，由调用方分配。
+// 输出尺寸不符时打印原因并返回 false，output 不写入。每次调用只处理本帧，不与之前的调用合并
+bool lidar_backbone(const float* points, int64_t num_points, float* output);
+
+// 带位姿的一帧：pose 为本帧 LiDAR 到全局坐标系的 4×4 变换（行主序），timestamp_us 为本帧时间戳。
+// BEVFUSION_LIDAR_SWEEPS=N（默认 1）时与最近 N-1 帧合并后再进入骨干网络（lidar_backbone/sweep_voxelizer.h），
+// 只有本重载累积多帧
+bool lidar_backbone(const float* points, int64_t num_points, uint64_t timestamp_us, const float* pose, float* output);
+
+// 活跃体素是否按 Morton 序存放，默认开启；环境变量 BEVFUSION_LIDAR_MORTON=0 关闭
+void lidar_backbone_set_morton(bool enabled);
+
+// 逐层剖析：开启后每帧打印各层耗时、gather 局部性与缓存未命中率（BEVFUSION_LIDAR_PROFILE=1 同样开启）
+void lidar_backbone_set_profile(bool enabled);
+
+// 计算线程数：稀疏卷积、建表和排序的 OpenMP 并行区，以及 libtorch 的 intra-op 线程
+void lidar_backbone_set_threads(int threads);
\ No newline at end of file
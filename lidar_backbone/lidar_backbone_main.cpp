@@ -0,0 +1,46 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "lidar_backbone.h"
+#include "frame_archive.h"
+#include "chiplet_link.h"
+#include "stage_pipeline.h"
+
+struct LidarInput {
+    bevfusion::LidarFrameHeader header{0, 0, {}};
+    bevfusion::ReceiveBuffer points;  // N×5，shm 后端时直接位于共享内存槽位，否则按帧点数扩容、容量只增不减
+};
+
+struct LidarOutput {
+    std::vector<float> features = std::vector<float>(1 * 256 * 180 * 180);
+};
+
+// 用法: lidar_backbone <idX> <idY> [帧数]
+int main(int argc, char** argv) {
+    int idX = atoi(argv[1]);
+    int idY = atoi(argv[2]);
+    int num_frames = argc > 3 ? atoi(argv[3]) : 1;
+    bevfusion::ChipletLink link(idX, idY);
+    if (!link.open()) return 1;
+    bevfusion::StagePipeline<LidarInput, LidarOutput> pipeline;
+    pipeline.set_cancel([&] { link.abort(); });
+    bool ok = pipeline.run(num_frames,
+        [&](LidarInput& in, int, bevfusion::RowProgress&) {
+            // 先收消息头得到点数，再收 N×5 点云
+            if (!link.receive(&in.header, sizeof(in.header))) return false;
+            return in.points.receive(link, in.header.num_points * bevfusion::kPointDim);
+        },
+        [&](const LidarInput& in, LidarOutput& out, int frame, const bevfusion::RowProgress&) {
+            std::cout << "-------------------------------- 帧 " << frame << std::endl;
+            bool ok = lidar_backbone(in.points.data(), in.header.num_points, in.header.timestamp_us,
+                                     in.header.lidar2global, out.features.data());
+            in.points.release(link);
+            return ok;
+        },
+        [&](const LidarOutput& out, int frame) {
+            // 按行带发出，fuser 收到前几个行带即可开始 Conv_1
+            return bevfusion::send_bands(link, bevfusion::BandLayout{256, 180, 180}, frame, out.features.data());
+        });
+    pipeline.print_stats("lidar_backbone");
+    return ok ? 0 : 1;
+}
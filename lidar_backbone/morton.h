@@ -0,0 +1,95 @@
+#ifndef MORTON_H
+#define MORTON_H
+
+// 体素的 Morton（Z 序）排序
+//
+// 三个坐标按位交织成 63 位 Morton 码，空间上相邻的体素在码序中也大多相邻，
+// 3×3×3 邻域的 gather 因此集中在附近的行上。排序用 8 位一趟的 LSD 基数排序（也供 indice_key.h 排序输出坐标），
+// 趟数按最大码的位数决定（1440×1440×41 的网格为 5 趟）；每趟把输入切成若干块，
+// 各块并行统计直方图、并行散射（调用方链接 OpenMP 时），结果是稳定排序。
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace bevfusion {
+
+// 把 21 位整数的各位分散到每 3 位的最低位
+inline uint64_t morton_spread(uint64_t v) {
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffffull;
+    v = (v | v << 16) & 0x1f0000ff0000ffull;
+    v = (v | v << 8) & 0x100f00f00f00f00full;
+    v = (v | v << 4) & 0x10c30c30c30c30c3ull;
+    v = (v | v << 2) & 0x1249249249249249ull;
+    return v;
+}
+
+inline uint64_t morton_code(int32_t d0, int32_t d1, int32_t d2) {
+    return morton_spread(static_cast<uint32_t>(d0)) << 2 | morton_spread(static_cast<uint32_t>(d1)) << 1 |
+           morton_spread(static_cast<uint32_t>(d2));
+}
+
+// 对 64 位键做稳定的 LSD 基数排序，返回排序后各位置上的原下标；keys 按值传入作为工作区
+inline std::vector<int32_t> radix_sort_order(std::vector<uint64_t> keys) {
+    const int64_t n = static_cast<int64_t>(keys.size());
+    std::vector<uint64_t> keys_tmp(n);
+    std::vector<int32_t> rows(n), rows_tmp(n);
+    std::iota(rows.begin(), rows.end(), 0);
+
+    uint64_t max_key = 0;
+    for (int64_t i = 0; i < n; ++i) max_key = std::max(max_key, keys[i]);
+    int passes = 0;
+    while (passes < 8 && (max_key >> (passes * 8)) != 0) passes++;
+
+    constexpr int64_t kChunkRows = 1 << 14;
+    const int64_t chunks = std::max<int64_t>(1, (n + kChunkRows - 1) / kChunkRows);
+    std::vector<int64_t> offsets(static_cast<size_t>(chunks) * 256);
+    for (int pass = 0; pass < passes; ++pass) {
+        const int shift = pass * 8;
+        std::fill(offsets.begin(), offsets.end(), 0);
+        #pragma omp parallel for schedule(static)
+        for (int64_t c = 0; c < chunks; ++c) {
+            int64_t* hist = offsets.data() + c * 256;
+            for (int64_t i = c * kChunkRows, end = std::min(n, i + kChunkRows); i < end; ++i) {
+                hist[(keys[i] >> shift) & 0xff]++;
+            }
+        }
+        // 各块内每个数字的起始位置：数字小的在前，同一数字按块的先后排
+        int64_t pos = 0;
+        for (int d = 0; d < 256; ++d) {
+            for (int64_t c = 0; c < chunks; ++c) {
+                int64_t count = offsets[c * 256 + d];
+                offsets[c * 256 + d] = pos;
+                pos += count;
+            }
+        }
+        #pragma omp parallel for schedule(static)
+        for (int64_t c = 0; c < chunks; ++c) {
+            int64_t* next = offsets.data() + c * 256;
+            for (int64_t i = c * kChunkRows, end = std::min(n, i + kChunkRows); i < end; ++i) {
+                int64_t dst = next[(keys[i] >> shift) & 0xff]++;
+                keys_tmp[dst] = keys[i];
+                rows_tmp[dst] = rows[i];
+            }
+        }
+        keys.swap(keys_tmp);
+        rows.swap(rows_tmp);
+    }
+    return rows;
+}
+
+// coords: N×3，返回按 Morton 码升序排列的原行号（码相同时保持原顺序）
+inline std::vector<int32_t> morton_order(const int32_t* coords, int64_t n) {
+    std::vector<uint64_t> keys(n);
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < n; ++i) keys[i] = morton_code(coords[i * 3], coords[i * 3 + 1], coords[i * 3 + 2]);
+    return radix_sort_order(std::move(keys));
+}
+
+}  // namespace bevfusion
+
+#endif  // MORTON_H
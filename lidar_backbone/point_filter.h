@@ -0,0 +1,125 @@
+#ifndef POINT_FILTER_H
+#define POINT_FILTER_H
+
+// 体素化之前的点云预处理：范围裁剪、按强度阈值丢点、可选的栅格地面去除
+//
+// 第一遍对每个点算保留标记（无分支，OpenMP 下按块并行、块内 simd）：落在点云范围 [x0, x1) × [y0, y1) × [z0, z1) 内
+// 且强度不低于阈值。开启地面去除时第二遍在 xy 平面上按 ground_cell 米的栅格求每格最低点，
+// 最低点不高于 ground_max_z 的格视为地面，格内高出最低点不到 ground_height 的点丢弃；
+// 没有地面的格（例如只有车顶或树冠）保留全部点。最后按标记把保留的点压紧到输出缓冲。
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace bevfusion {
+
+struct PointFilterConfig {
+    float range[6];                                          // [x0, y0, z0, x1, y1, z1]，与体素网格一致
+    float min_intensity = -std::numeric_limits<float>::infinity();  // 低于此强度的点丢弃，默认不过滤
+    bool remove_ground = false;
+    float ground_cell = 1.0f;      // 地面栅格边长（米）
+    float ground_height = 0.2f;    // 高出格内最低点不到此值的点视为地面
+    float ground_max_z = -1.4f;    // 格内最低点高于此值时该格没有地面（LiDAR 坐标系，nuScenes 安装高度约 1.8 米）
+};
+
+struct PointFilterStats {
+    int64_t points_in = 0;
+    int64_t points_out = 0;
+    int64_t out_of_range = 0;
+    int64_t low_intensity = 0;     // 在范围内、强度低于阈值
+    int64_t ground = 0;
+    double ms = 0.0;
+};
+
+class PointFilter {
+public:
+    explicit PointFilter(const PointFilterConfig& config) : config_(config) {}
+
+    const PointFilterConfig& config() const { return config_; }
+
+    // points: N×dim，保留的点按原顺序写入 out（N'×dim），返回 N'
+    int64_t apply(const float* points, int64_t num_points, int dim, std::vector<float>& out) {
+        auto t0 = std::chrono::steady_clock::now();
+        const PointFilterConfig& c = config_;
+        keep_.resize(num_points);
+        uint8_t* keep = keep_.data();
+        int64_t in_range = 0, kept = 0;
+
+        // 1. 范围与强度
+        #pragma omp parallel for simd reduction(+ : in_range, kept) schedule(static)
+        for (int64_t i = 0; i < num_points; ++i) {
+            const float* p = points + i * dim;
+            const int inside = (p[0] >= c.range[0]) & (p[0] < c.range[3]) & (p[1] >= c.range[1]) & (p[1] < c.range[4]) &
+                               (p[2] >= c.range[2]) & (p[2] < c.range[5]);
+            const int bright = p[3] >= c.min_intensity;
+            in_range += inside;
+            kept += inside & bright;
+            keep[i] = static_cast<uint8_t>(inside & bright);
+        }
+
+        // 2. 地面：每格最低点，再丢弃贴近地面格最低点的点
+        int64_t ground = 0;
+        if (c.remove_ground) {
+            const int gx = static_cast<int>(std::ceil((c.range[3] - c.range[0]) / c.ground_cell));
+            const int gy = static_cast<int>(std::ceil((c.range[4] - c.range[1]) / c.ground_cell));
+            const float inv = 1.0f / c.ground_cell;
+            auto cell_of = [&](const float* p) {
+                const int x = std::min(static_cast<int>((p[0] - c.range[0]) * inv), gx - 1);
+                const int y = std::min(static_cast<int>((p[1] - c.range[1]) * inv), gy - 1);
+                return static_cast<size_t>(x) * gy + y;
+            };
+            min_z_.assign(static_cast<size_t>(gx) * gy, std::numeric_limits<float>::infinity());
+            for (int64_t i = 0; i < num_points; ++i) {
+                if (!keep[i]) continue;
+                const float* p = points + i * dim;
+                float& z = min_z_[cell_of(p)];
+                z = std::min(z, p[2]);
+            }
+            const float* min_z = min_z_.data();
+            #pragma omp parallel for reduction(+ : ground) schedule(static)
+            for (int64_t i = 0; i < num_points; ++i) {
+                if (!keep[i]) continue;
+                const float* p = points + i * dim;
+                const float z0 = min_z[cell_of(p)];
+                if (z0 <= c.ground_max_z && p[2] < z0 + c.ground_height) {
+                    keep[i] = 0;
+                    ground++;
+                }
+            }
+        }
+
+        // 3. 压紧
+        const int64_t num_out = kept - ground;
+        out.resize(static_cast<size_t>(num_out) * dim);
+        float* dst = out.data();
+        for (int64_t i = 0; i < num_points; ++i) {
+            if (!keep[i]) continue;
+            std::copy(points + i * dim, points + (i + 1) * dim, dst);
+            dst += dim;
+        }
+
+        stats_.points_in = num_points;
+        stats_.points_out = num_out;
+        stats_.out_of_range = num_points - in_range;
+        stats_.low_intensity = in_range - kept;
+        stats_.ground = ground;
+        stats_.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        return num_out;
+    }
+
+    const PointFilterStats& last_stats() const { return stats_; }
+
+private:
+    PointFilterConfig config_;
+    std::vector<uint8_t> keep_;
+    std::vector<float> min_z_;
+    PointFilterStats stats_;
+};
+
+}  // namespace bevfusion
+
+#endif  // POINT_FILTER_H
@@ -1,194 +1,195 @@
 #include <torch/torch.h>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <string>
 #include <vector>
 
+#include "indice_key.h"
+#include "morton.h"
+#include "sparse_gemm.h"
+
+// 本帧共用的一份子流形规则表
+struct SubmRules {
+    bevfusion::SubmRulebook rulebook;
+    int uses = 0;                          // 本帧共用这份规则表的层数
+};
+
+// 每帧一份：按 indice key 缓存各分辨率的规则表。
+// 同一 key 的子流形层必须作用在同一组活跃体素上，第一层建表，之后各层直接复用
+class IndiceKeyCache {
+public:
+    // indices: [4, N]（batch, d0, d1, d2）
+    const SubmRules& get(const std::string& key, const torch::Tensor& indices, c10::ArrayRef<int64_t> spatial_size,
+                         c10::ArrayRef<int64_t> kernel, c10::ArrayRef<int64_t> padding) {
+        auto it = rules_.find(key);
+        if (it == rules_.end()) {
+            const int64_t n = indices.size(1);
+            auto coords = indices.slice(0, 1, 4).t().to(torch::kInt).contiguous();  // [N, 3]
+            const int64_t size[3] = {spatial_size[0], spatial_size[1], spatial_size[2]};
+            const int64_t k[3] = {kernel[0], kernel[1], kernel[2]};
+            const int64_t p[3] = {padding[0], padding[1], padding[2]};
+            SubmRules rules;
+            rules.rulebook = bevfusion::build_subm_rulebook(coords.data_ptr<int32_t>(), n, size, k, p);
+            it = rules_.emplace(key, std::move(rules)).first;
+        }
+        it->second.uses++;
+        return it->second;
+    }
+
+    // 本帧已建立的规则表，不存在时返回 nullptr
+    const SubmRules* find(const std::string& key) const {
+        auto it = rules_.find(key);
+        return it == rules_.end() ? nullptr : &it->second;
+    }
+
+    void print_summary() const {
+        std::cout << "子流形规则表:";
+        for (const auto& [key, rules] : rules_) {
+            const bevfusion::SubmRulebook& rb = rules.rulebook;
+            std::cout << " " << key << "（" << rb.num_pairs << " 对，" << rules.uses << " 层共用，平均行距 "
+                      << rb.mean_gather_distance << "，近邻 " << rb.near_gather_ratio * 100 << "%）";
+        }
+        std::cout << std::endl;
+    }
+
+private:
+    std::map<std::string, SubmRules> rules_;
+};
+
+// lidar_backbone 层间传递的稀疏张量：活跃体素坐标 + 连续的特征矩阵 + 本帧共享的 indice key 缓存。
+// 子流形层的输出与输入共用同一个 indices 张量，残差两侧因此可以直接逐行计算
+struct SparseConvTensor {
+    torch::Tensor indices;                   // [4, N] Long（batch, d0, d1, d2）
+    torch::Tensor features;                  // [N, C] float，连续
+    std::vector<int64_t> spatial_size;
+    std::shared_ptr<IndiceKeyCache> keys;
+
+    int64_t num_voxels() const { return features.size(0); }
+
+    // 残差：this = relu(this + other)，在特征矩阵上就地一遍完成，两侧必须是同一组活跃体素
+    SparseConvTensor& add_relu_(const SparseConvTensor& other) {
+        TORCH_CHECK(indices.is_same(other.indices), "残差两侧的活跃体素不同");
+        at::_add_relu_(features, other.features);
+        return *this;
+    }
+
+    // 按 (d0, d1, d2) 的 Morton 码重排活跃体素，indices 与 features 同步置换。
+    // 只能在建立规则表之前调用：同一 indice key 的各层依赖同一份行序
+    SparseConvTensor& morton_sort_() {
+        const int64_t n = num_voxels();
+        if (n < 2) return *this;
+        auto coords = indices.slice(0, 1, 4).t().to(torch::kInt).contiguous();  // [N, 3]
+        std::vector<int32_t> order = bevfusion::morton_order(coords.data_ptr<int32_t>(), n);
+        auto perm = torch::from_blob(order.data(), {n}, torch::kInt).to(torch::kLong);
+        indices = indices.index_select(1, perm);
+        features = features.index_select(0, perm);
+        return *this;
+    }
+
+    // 稠密张量 [1, d0, d1, d2, C]
+    torch::Tensor to_dense() const {
+        auto dense = torch::zeros({1, spatial_size[0], spatial_size[1], spatial_size[2], features.size(1)});
+        dense.index_put_({indices[0], indices[1], indices[2], indices[3]}, features);
+        return dense;
+    }
+};
+
 class SubMConv3dImpl : public torch::nn::Module {
 public:
     SubMConv3dImpl(int64_t in_channels, int64_t out_channels, 
                    torch::ExpandingArray<3> kernel_size,
                    torch::ExpandingArray<3> padding,
-                   torch::ExpandingArray<3> stride = {1,1,1})
+                   torch::ExpandingArray<3> stride = {1,1,1},
+                   std::string indice_key = "")
         : kernel_size_(kernel_size),
           padding_(padding),
-          stride_(stride) 
+          stride_(stride),
+          indice_key_(std::move(indice_key))
     {
-        // 正确访问ExpandingArray元素的方式
         auto kRef = kernel_size_.operator c10::ArrayRef<int64_t>();
-        auto pRef = padding_.operator c10::ArrayRef<int64_t>();
-        auto sRef = stride_.operator c10::ArrayRef<int64_t>();
-
-        // 确保 stride = 1， dilation = 1（适用于 SubM 卷积）
-        dilation_ = {1, 1, 1}; 
-
-        // 计算输出空间尺寸
-        output_size_.resize(3);
-        for (size_t i = 0; i < 3; ++i) {
-            output_size_[i] = (1 + (0 + 2 * pRef[i] - (kRef[i] - 1) - 1) / sRef[i]);
-        }
 
-        // 设定权重大小: [out_channels, in_channels, kd, kh, kw]
+        // 权重按 spconv 检查点的布局存放: [kd, kh, kw, in_channels, out_channels]，
+        // 展平前三维即 gather-GEMM 逐核偏移的 [K, C_in, C_out]，与规则表的核偏移顺序一致，前向时不再重排
         std::vector<int64_t> weight_size = {
-            out_channels,
+            kRef[0], kRef[1], kRef[2],
             in_channels,
-            kRef[0], kRef[1], kRef[2]
+            out_channels
         };
 
-        // 注册可学习参数
+        // 注册可学习参数；随机初始值只在没有权重包时使用
         weight_ = register_parameter("weight", torch::randn(weight_size));
         bias_ = register_parameter("bias", torch::randn({out_channels}));
     }
 
-    void set_stride(torch::ExpandingArray<3> stride) {
-        stride_ = stride;
+    const std::string& indice_key() const { return indice_key_; }
+
+    // 带 indice key 的层为子流形卷积，输出与输入共用活跃体素；
+    // 其余为普通稀疏卷积，输出的活跃体素和空间尺寸由本层的 kernel / stride / padding 从输入生成
+    SparseConvTensor forward(const SparseConvTensor& x) {
+        if (!indice_key_.empty()) {
+            SparseConvTensor out = x;
+            out.features = subm_forward(x.indices, x.features, x.spatial_size, *x.keys);
+            return out;
+        }
+        return sparse_forward(x);
     }
 
-    torch::Tensor forward(torch::Tensor indices, 
-                          torch::Tensor values,
-                          c10::ArrayRef<int64_t> spatial_size)
+private:
+    // 子流形卷积：输出的活跃体素就是输入的活跃体素，行序不变。
+    // indices: [4, N]，features: [N, C_in]，返回 [N, C_out]。规则表按本层的 indice key 从 keys 中取，
+    // 同一 key 的各层只建一次
+    torch::Tensor subm_forward(const torch::Tensor& indices,
+                          const torch::Tensor& features,
+                          c10::ArrayRef<int64_t> spatial_size,
+                          IndiceKeyCache& keys)
     {
+        const SubmRules& rules = keys.get(indice_key_, indices, spatial_size,
+                                          kernel_size_.operator c10::ArrayRef<int64_t>(),
+                                          padding_.operator c10::ArrayRef<int64_t>());
+        const bevfusion::SubmRulebook& rb = rules.rulebook;
+        return gather_gemm(rb.neighbors.data(), rb.num_rows, features);
+    }
+
+    // 普通稀疏卷积：输入经各核偏移落到 (x + padding - k) / stride（整除时）的输出位置，
+    // 这些位置去重后即输出的活跃体素（按 (d0, d1, d2) 字典序），再按规则表逐输出行 gather-GEMM
+    SparseConvTensor sparse_forward(const SparseConvTensor& x) {
         auto kRef = kernel_size_.operator c10::ArrayRef<int64_t>();
         auto pRef = padding_.operator c10::ArrayRef<int64_t>();
         auto sRef = stride_.operator c10::ArrayRef<int64_t>();
-
-        const int64_t D_in = spatial_size[0];
-        const int64_t H_in = spatial_size[1];
-        const int64_t W_in = spatial_size[2];
-        
-        int64_t D_out = (D_in + 2*pRef[0] - kRef[0]) / sRef[0] + 1;
-        int64_t H_out = (H_in + 2*pRef[1] - kRef[1]) / sRef[1] + 1;
-        int64_t W_out = (W_in + 2*pRef[2] - kRef[2]) / sRef[2] + 1;
-
-        // 输出通道数
-        int64_t C_out = weight_.size(0);
-
-        // 修改：添加通道维度作为第四维
-        std::vector<int64_t> output_shape = {D_out, H_out, W_out, C_out};
-
-        // 检查输入是否为空
-        if (indices.size(1) == 0) {
-            return torch::sparse_coo_tensor(
-                torch::zeros({3, 0}, torch::kLong),
-                torch::zeros({0, C_out}),
-                output_shape,
-                torch::kFloat
-            );
-        }
-
-        // 存储输出的 indices 和 values
-        std::vector<torch::Tensor> out_indices;
-        std::vector<torch::Tensor> out_values;
-
-        // 访问输入 indices
-        auto indices_a = indices.accessor<int64_t, 2>();
-        auto batch_idx = indices_a[0][0];  // 获取batch索引
-
-        // 遍历所有非零坐标
-        for (int64_t n = 0; n < indices.size(1); ++n) {
-            const int64_t z = indices_a[1][n];  // 注意：indices现在是4维的，第一维是batch
-            const int64_t y = indices_a[2][n];
-            const int64_t x = indices_a[3][n];
-
-            // 遍历 3D 卷积窗口
-            for (int64_t kz = 0; kz < kRef[0]; ++kz) {
-                for (int64_t ky = 0; ky < kRef[1]; ++ky) {
-                    for (int64_t kx = 0; kx < kRef[2]; ++kx) {
-                        // 计算输出坐标 (考虑 padding)
-                        const int64_t z_out = z - kz + pRef[0];
-                        const int64_t y_out = y - ky + pRef[1];
-                        const int64_t x_out = x - kx + pRef[2];
-
-                        // 边界检查
-                        if (z_out >= 0 && z_out < D_out &&
-                            y_out >= 0 && y_out < H_out &&
-                            x_out >= 0 && x_out < W_out)
-                        {
-                            // 修改权重切片方式
-                            torch::Tensor w = weight_
-                                .narrow(2, kz, 1)
-                                .narrow(3, ky, 1)
-                                .narrow(4, kx, 1)
-                                .squeeze();
-
-                            // 调整矩阵乘法
-                            torch::Tensor val = torch::matmul(
-                                values[n].view({1, -1}),  // [1, C_in]
-                                w.transpose(0, 1)         // [C_in, C_out]
-                            ).squeeze(0);  // [C_out]
-
-                            // 加上 bias
-                            val += bias_;
-
-                            // 保存坐标和特征
-                            out_indices.push_back(
-                                torch::tensor({z_out, y_out, x_out}, torch::kLong)
-                                    .unsqueeze(1)
-                            );
-                            out_values.push_back(val);
-                        }
-                    }
-                }
-            }
-        }
-
-        // 检查是否有有效输出
-        if (out_indices.empty()) {
-            return torch::sparse_coo_tensor(
-                torch::zeros({3, 0}, torch::kLong),
-                torch::zeros({0, C_out}),
-                output_shape,
-                torch::kFloat
-            );
+        const int64_t n = x.num_voxels();
+        auto coords = x.indices.slice(0, 1, 4).t().to(torch::kInt).contiguous();  // [N, 3]
+        const int64_t size[3] = {x.spatial_size[0], x.spatial_size[1], x.spatial_size[2]};
+        const int64_t k[3] = {kRef[0], kRef[1], kRef[2]};
+        const int64_t s[3] = {sRef[0], sRef[1], sRef[2]};
+        const int64_t p[3] = {pRef[0], pRef[1], pRef[2]};
+        bevfusion::ConvRulebook rb = bevfusion::build_conv_rulebook(coords.data_ptr<int32_t>(), n, size, k, s, p);
+        torch::Tensor out = gather_gemm(rb.neighbors.data(), rb.num_out, x.features);
+
+        auto out_indices = torch::zeros({4, rb.num_out}, torch::kLong);
+        if (rb.num_out > 0) {
+            out_indices.slice(0, 1, 4).copy_(
+                torch::from_blob(rb.out_coords.data(), {rb.num_out, 3}, torch::kInt).t());
         }
+        return SparseConvTensor{out_indices, out, {rb.out_size[0], rb.out_size[1], rb.out_size[2]}, x.keys};
+    }
 
-        // 合并输出
-        auto out_indices_tensor = torch::cat(out_indices, 1);  // [3, N]
-        auto out_values_tensor = torch::stack(out_values, 0);  // [N, C_out]
-
-        // 创建稀疏张量，使用4维形状
-        return torch::sparse_coo_tensor(
-            out_indices_tensor,
-            out_values_tensor,
-            output_shape,
-            torch::kFloat
-        ).coalesce();
+    // out[o] = bias + Σ_k features[table[o][k]] · W[k]，见 sparse_gemm.h
+    torch::Tensor gather_gemm(const int32_t* table, int64_t num_out, const torch::Tensor& features) {
+        const int64_t K = weight_.size(0) * weight_.size(1) * weight_.size(2);
+        const int64_t C_in = weight_.size(3);
+        const int64_t C_out = weight_.size(4);
+        auto out = torch::empty({num_out, C_out});
+        bevfusion::sparse_conv_gemm(table, num_out, static_cast<int>(K), features.data_ptr<float>(),
+                                    static_cast<int>(C_in), weight_.data_ptr<float>(), bias_.data_ptr<float>(),
+                                    static_cast<int>(C_out), out.data_ptr<float>());
+        return out;
     }
 
-private:
     torch::ExpandingArray<3> kernel_size_, padding_, stride_;
-    std::vector<int64_t> output_size_;
-    std::vector<int64_t> dilation_;
+    std::string indice_key_;
 
     torch::Tensor weight_, bias_;
 };
 
 TORCH_MODULE(SubMConv3d);
-
-// // **main 函数保持不变**
-// int main() {
-//     // 修改输入参数以匹配期望维度
-//     int64_t D = 1440, H = 1440, W = 41;
-//     int64_t C_in = 16, C_out = 16;
-//     int64_t batch_size = 1;
-
-//     torch::ExpandingArray<3> kernel_size{3, 3, 3};
-//     torch::ExpandingArray<3> padding{1, 1, 1};
-
-//     // 构造稀疏输入，确保包含batch维度
-//     auto indices = torch::tensor({
-//         {0},    // batch index
-//         {720},  // z
-//         {720},  // y
-//         {20}    // x
-//     }, torch::kLong);  // [4, 1]
-//     auto values = torch::randn({1, C_in});  // [1, 16]
-
-//     auto conv = SubMConv3d(C_in, C_out, kernel_size, padding);
-
-//     // 前向传播
-//     auto output = conv->forward(indices, values, {D, H, W});
-
-//     std::cout << "Output size: " << output.sizes() << std::endl;
-//     std::cout << "Number of non-zero outputs: " << output._nnz() << std::endl;
-
-//     return 0;
-// }
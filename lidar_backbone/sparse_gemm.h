@@ -0,0 +1,97 @@
+#ifndef SPARSE_GEMM_H
+#define SPARSE_GEMM_H
+
+// 稀疏卷积的 gather-GEMM，按输出行划分（output-stationary）
+//
+// out(o) = bias + Σ_k in(table[o][k]) · W[k]，table 为 [M][K] 的输入行号，没有对应输入时为 -1
+// （子流形卷积的中心偏移指向自身）。输出按 kTileRows 行一块分给线程（调用方链接 OpenMP 时），
+// 每块在线程私有的累加缓冲里依次处理 K 个偏移：每个偏移只 gather 本块中有输入的行，
+// 每 4 行一组共享一次权重行的读取，再把整块写回。各块的输出行互不重叠，写回不需要原子操作或归约；
+// 配对很少的偏移也只是块内的一小段循环，不再单独发起一次小 GEMM。
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace bevfusion {
+
+constexpr int kSparseTileRows = 32;
+
+// acc[r] += x[r] · w，r = 0..3，w: [cin][cout]
+inline void sparse_gemm_rows4(int cin, int cout, const float* w, const float* x0, const float* x1, const float* x2,
+                              const float* x3, float* __restrict a0, float* __restrict a1, float* __restrict a2,
+                              float* __restrict a3) {
+    for (int c = 0; c < cin; ++c) {
+        const float* __restrict wr = w + static_cast<size_t>(c) * cout;
+        const float v0 = x0[c], v1 = x1[c], v2 = x2[c], v3 = x3[c];
+        for (int o = 0; o < cout; ++o) {
+            const float wv = wr[o];
+            a0[o] += v0 * wv;
+            a1[o] += v1 * wv;
+            a2[o] += v2 * wv;
+            a3[o] += v3 * wv;
+        }
+    }
+}
+
+inline void sparse_gemm_row(int cin, int cout, const float* w, const float* x, float* __restrict a) {
+    for (int c = 0; c < cin; ++c) {
+        const float* __restrict wr = w + static_cast<size_t>(c) * cout;
+        const float v = x[c];
+        for (int o = 0; o < cout; ++o) a[o] += v * wr[o];
+    }
+}
+
+// in: [N][cin]，weight: [K][cin][cout]，bias: [cout] 或 nullptr，out: [M][cout]（与 in 不能重叠）
+inline void sparse_conv_gemm(const int32_t* table, int64_t num_out, int K, const float* in, int cin,
+                             const float* weight, const float* bias, int cout, float* out) {
+    const int64_t tiles = (num_out + kSparseTileRows - 1) / kSparseTileRows;
+
+    #pragma omp parallel
+    {
+        std::vector<float> acc(static_cast<size_t>(kSparseTileRows) * cout);
+        int rows[kSparseTileRows];
+        int32_t src[kSparseTileRows];
+
+        #pragma omp for schedule(dynamic)
+        for (int64_t t = 0; t < tiles; ++t) {
+            const int64_t o0 = t * kSparseTileRows;
+            const int n = static_cast<int>(std::min<int64_t>(kSparseTileRows, num_out - o0));
+            for (int r = 0; r < n; ++r) {
+                float* a = acc.data() + static_cast<size_t>(r) * cout;
+                if (bias) {
+                    std::memcpy(a, bias, sizeof(float) * cout);
+                } else {
+                    std::fill(a, a + cout, 0.0f);
+                }
+            }
+            for (int k = 0; k < K; ++k) {
+                int m = 0;
+                for (int r = 0; r < n; ++r) {
+                    const int32_t j = table[(o0 + r) * K + k];
+                    if (j < 0) continue;
+                    rows[m] = r;
+                    src[m] = j;
+                    m++;
+                }
+                if (m == 0) continue;
+                const float* w = weight + static_cast<size_t>(k) * cin * cout;
+                auto x = [&](int q) { return in + static_cast<size_t>(src[q]) * cin; };
+                auto a = [&](int q) { return acc.data() + static_cast<size_t>(rows[q]) * cout; };
+                int q = 0;
+                for (; q + 4 <= m; q += 4) {
+                    sparse_gemm_rows4(cin, cout, w, x(q), x(q + 1), x(q + 2), x(q + 3), a(q), a(q + 1), a(q + 2),
+                                      a(q + 3));
+                }
+                for (; q < m; ++q) sparse_gemm_row(cin, cout, w, x(q), a(q));
+            }
+            std::memcpy(out + o0 * cout, acc.data(), sizeof(float) * n * cout);
+        }
+    }
+}
+
+}  // namespace bevfusion
+
+#endif  // SPARSE_GEMM_H
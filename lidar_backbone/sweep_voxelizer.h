@@ -0,0 +1,232 @@
+#ifndef SWEEP_VOXELIZER_H
+#define SWEEP_VOXELIZER_H
+
+// 多帧 LiDAR 的增量体素化
+//
+// 保留最近 max_sweeps 帧各自的体素集合（环形缓冲，坐标为该帧的 LiDAR 坐标系）：每个体素记录点数
+// 以及 5 维特征 (x, y, z, intensity, time_lag) 的均值。每来一帧只体素化这一帧的点并淘汰最旧的一帧，
+// 较旧各帧的体素均值按位姿差变换到本帧坐标系、重新量化后用哈希表按点数加权合并，time_lag 加上两帧的时间差。
+// 刚体变换下均值的像就是像的均值，合并结果与把各帧的点全部变换后重新体素化只差在：
+// 同一源体素的点被整体归入其均值所在的目标体素。max_sweeps 为 1 时结果与逐帧体素化完全相同。
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace bevfusion {
+
+constexpr int kSweepPointDim = 5;
+
+// 体素网格：点云范围 [x0, y0, z0, x1, y1, z1]、体素尺寸和三个维度的格数
+struct VoxelGrid {
+    float range[6];
+    float voxel_size[3];
+    int64_t size[3];
+};
+
+// 合并结果：coords 为 V×3 (d0, d1, d2)，features 为 V×5 的特征均值，按首次出现的顺序（最新一帧在前）
+struct VoxelSet {
+    std::vector<int32_t> coords;
+    std::vector<float> features;
+    std::vector<int32_t> counts;
+
+    int64_t num_voxels() const { return static_cast<int64_t>(counts.size()); }
+    void clear() {
+        coords.clear();
+        features.clear();
+        counts.clear();
+    }
+};
+
+// 按体素线性下标累加的开放寻址哈希表，容量为 2 的幂且不小于 2N；reset 只清键，缓冲留作下次使用
+class VoxelAccumulator {
+public:
+    void reset(int64_t expected, const VoxelGrid& grid) {
+        grid_ = grid;
+        uint64_t capacity = 16;
+        while (capacity < static_cast<uint64_t>(expected) * 2) capacity <<= 1;
+        mask_ = capacity - 1;
+        keys_.assign(capacity, kEmpty);
+        rows_.resize(capacity);
+        sums_.clear();
+        out_.clear();
+    }
+
+    // 把位于 p（本帧坐标系）的 count 个点、特征和为 feature_sum 的一组累加进所在体素；越界时丢弃
+    void add(const float p[3], const float* feature_sum, int32_t count) {
+        int32_t c[3];
+        for (int d = 0; d < 3; ++d) {
+            const float v = std::floor((p[d] - grid_.range[d]) / grid_.voxel_size[d]);
+            if (!(v >= 0.0f && v < static_cast<float>(grid_.size[d]))) return;
+            c[d] = static_cast<int32_t>(v);
+        }
+        const int64_t key = (c[0] * grid_.size[1] + c[1]) * grid_.size[2] + c[2];
+        uint64_t slot = hash(key) & mask_;
+        while (keys_[slot] != kEmpty && keys_[slot] != key) slot = (slot + 1) & mask_;
+        int32_t row;
+        if (keys_[slot] == kEmpty) {
+            keys_[slot] = key;
+            row = static_cast<int32_t>(out_.counts.size());
+            rows_[slot] = row;
+            out_.coords.insert(out_.coords.end(), {c[0], c[1], c[2]});
+            sums_.insert(sums_.end(), kSweepPointDim, 0.0);
+            out_.counts.push_back(0);
+        } else {
+            row = rows_[slot];
+        }
+        double* s = sums_.data() + static_cast<size_t>(row) * kSweepPointDim;
+        for (int k = 0; k < kSweepPointDim; ++k) s[k] += feature_sum[k];
+        out_.counts[row] += count;
+    }
+
+    // 求各体素的特征均值，结果移入 out
+    void finish(VoxelSet& out) {
+        const size_t n = out_.counts.size();
+        out_.features.resize(n * kSweepPointDim);
+        for (size_t v = 0; v < n; ++v) {
+            for (int k = 0; k < kSweepPointDim; ++k) {
+                out_.features[v * kSweepPointDim + k] =
+                    static_cast<float>(sums_[v * kSweepPointDim + k] / out_.counts[v]);
+            }
+        }
+        std::swap(out, out_);
+        out_.clear();
+    }
+
+private:
+    static constexpr int64_t kEmpty = -1;
+
+    static uint64_t hash(int64_t key) {
+        uint64_t h = static_cast<uint64_t>(key) * 0x9e3779b97f4a7c15ull;
+        return h ^ (h >> 32);
+    }
+
+    VoxelGrid grid_{};
+    uint64_t mask_ = 0;
+    std::vector<int64_t> keys_;
+    std::vector<int32_t> rows_;
+    std::vector<double> sums_;   // V×5，双精度累加
+    VoxelSet out_;
+};
+
+// 每帧体素化的统计
+struct SweepStats {
+    int sweeps = 0;            // 参与合并的帧数
+    int64_t new_points = 0;    // 本帧体素化的点数
+    int64_t new_voxels = 0;    // 本帧自身的体素数
+    int64_t merged_voxels = 0; // 合并后的体素数
+    double voxelize_ms = 0.0;  // 本帧点云体素化
+    double merge_ms = 0.0;     // 旧帧变换与合并
+};
+
+class SweepVoxelizer {
+public:
+    SweepVoxelizer(const VoxelGrid& grid, int max_sweeps) : grid_(grid), max_sweeps_(max_sweeps < 1 ? 1 : max_sweeps) {}
+
+    int max_sweeps() const { return max_sweeps_; }
+
+    // points: N×5，pose: 本帧 LiDAR 到全局坐标系的 4×4 刚体变换（行主序），timestamp_us: 本帧时间戳。
+    // 返回合并后的体素集合，下次调用前有效
+    const VoxelSet& add_sweep(const float* points, int64_t num_points, uint64_t timestamp_us, const float pose[16]) {
+        using clock = std::chrono::steady_clock;
+        auto t0 = clock::now();
+
+        // 1. 本帧体素化（本帧坐标系），复用被淘汰帧的缓冲
+        Sweep sweep;
+        if (static_cast<int>(ring_.size()) == max_sweeps_) {
+            sweep = std::move(ring_.back());
+            ring_.pop_back();
+        }
+        sweep.timestamp_us = timestamp_us;
+        for (int i = 0; i < 16; ++i) sweep.pose[i] = pose[i];
+        acc_.reset(num_points, grid_);
+        for (int64_t i = 0; i < num_points; ++i) {
+            const float* p = points + i * kSweepPointDim;
+            acc_.add(p, p, 1);
+        }
+        acc_.finish(sweep.voxels);
+        ring_.push_front(std::move(sweep));
+        const Sweep& now = ring_.front();
+        auto t1 = clock::now();
+
+        // 2. 旧帧按位姿差变换到本帧后与本帧合并；只有一帧时直接使用本帧的体素
+        const VoxelSet* result = &now.voxels;
+        if (ring_.size() > 1) {
+            int64_t total = 0;
+            for (const Sweep& s : ring_) total += s.voxels.num_voxels();
+            acc_.reset(total, grid_);
+            float sum[kSweepPointDim];
+            for (size_t j = 0; j < ring_.size(); ++j) {
+                const Sweep& s = ring_[j];
+                float m[12];
+                relative_pose(now.pose, s.pose, m);
+                const float dt = static_cast<float>(static_cast<int64_t>(now.timestamp_us - s.timestamp_us) * 1e-6);
+                const int64_t n = s.voxels.num_voxels();
+                for (int64_t v = 0; v < n; ++v) {
+                    const float* f = s.voxels.features.data() + v * kSweepPointDim;
+                    const float c = static_cast<float>(s.voxels.counts[v]);
+                    float q[3];
+                    for (int r = 0; r < 3; ++r) {
+                        q[r] = m[r * 4] * f[0] + m[r * 4 + 1] * f[1] + m[r * 4 + 2] * f[2] + m[r * 4 + 3];
+                    }
+                    sum[0] = q[0] * c;
+                    sum[1] = q[1] * c;
+                    sum[2] = q[2] * c;
+                    sum[3] = f[3] * c;
+                    sum[4] = (f[4] + dt) * c;
+                    acc_.add(q, sum, s.voxels.counts[v]);
+                }
+            }
+            acc_.finish(merged_);
+            result = &merged_;
+        }
+        auto t2 = clock::now();
+
+        stats_.sweeps = static_cast<int>(ring_.size());
+        stats_.new_points = num_points;
+        stats_.new_voxels = now.voxels.num_voxels();
+        stats_.merged_voxels = result->num_voxels();
+        stats_.voxelize_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        stats_.merge_ms = std::chrono::duration<double, std::milli>(t2 - t1).count();
+        return *result;
+    }
+
+    const SweepStats& last_stats() const { return stats_; }
+
+private:
+    struct Sweep {
+        uint64_t timestamp_us = 0;
+        float pose[16];
+        VoxelSet voxels;
+    };
+
+    // inv(now) · then 的前三行（3×4），把 then 帧坐标系下的点变换到 now 帧；刚体变换的逆为 [Rᵀ, -Rᵀt]
+    static void relative_pose(const float now[16], const float then[16], float m[12]) {
+        double inv[12];
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 3; ++c) inv[r * 4 + c] = now[c * 4 + r];
+            inv[r * 4 + 3] = -(now[r] * static_cast<double>(now[3]) + now[4 + r] * static_cast<double>(now[7]) +
+                               now[8 + r] * static_cast<double>(now[11]));
+        }
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 4; ++c) {
+                double v = inv[r * 4] * then[c] + inv[r * 4 + 1] * then[4 + c] + inv[r * 4 + 2] * then[8 + c];
+                if (c == 3) v += inv[r * 4 + 3];
+                m[r * 4 + c] = static_cast<float>(v);
+            }
+        }
+    }
+
+    VoxelGrid grid_;
+    int max_sweeps_;
+    std::deque<Sweep> ring_;     // 最新一帧在前
+    VoxelAccumulator acc_;
+    VoxelSet merged_;
+    SweepStats stats_;
+};
+
+}  // namespace bevfusion
+
+#endif  // SWEEP_VOXELIZER_H
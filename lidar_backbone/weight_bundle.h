@@ -0,0 +1,131 @@
+#ifndef WEIGHT_BUNDLE_H
+#define WEIGHT_BUNDLE_H
+
+// lidar_backbone 权重包（.weights.bin）的读取
+//
+// 文件布局（小端）:
+//   uint32 magic "BFLW"，uint32 version，uint32 num_tensors
+//   每个张量: uint32 name_len，name（不含结尾 0），uint32 ndim，int64 dims[ndim]，float data[Π dims]
+// 张量名与模块参数名一致（conv0.weight、conv0.bias ...）。卷积权重按 spconv 检查点的 [k0, k1, k2, C_in, C_out]，
+// 即稀疏 gather-GEMM 逐核偏移使用的 [K][C_in][C_out]，读入后不需要再重排。
+// 文件整体 mmap，张量数据直接指向映射区（不保证 4 字节对齐，拷贝时用 memcpy）。
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace bevfusion {
+
+constexpr uint32_t kWeightBundleMagic = 0x574C4642;  // "BFLW"
+constexpr uint32_t kWeightBundleVersion = 1;
+
+struct BundleTensor {
+    std::string name;
+    std::vector<int64_t> dims;
+    const char* data;       // count 个 float
+    size_t count;
+};
+
+class WeightBundle {
+public:
+    WeightBundle() = default;
+    WeightBundle(const WeightBundle&) = delete;
+    WeightBundle& operator=(const WeightBundle&) = delete;
+    ~WeightBundle() { close(); }
+
+    // 失败时打印原因并返回 false
+    bool open(const std::string& path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "无法打开权重包: " << path << std::endl;
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            std::cerr << "权重包为空: " << path << std::endl;
+            ::close(fd);
+            return false;
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            std::cerr << "权重包 mmap 失败: " << path << std::endl;
+            size_ = 0;
+            return false;
+        }
+        base_ = static_cast<const char*>(p);
+        if (!parse()) {
+            std::cerr << "权重包格式错误: " << path << std::endl;
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (base_) munmap(const_cast<char*>(base_), size_);
+        base_ = nullptr;
+        size_ = 0;
+        tensors_.clear();
+    }
+
+    const std::vector<BundleTensor>& tensors() const { return tensors_; }
+
+    // 不存在时返回 nullptr
+    const BundleTensor* find(const std::string& name) const {
+        for (const auto& t : tensors_) {
+            if (t.name == name) return &t;
+        }
+        return nullptr;
+    }
+
+private:
+    bool parse() {
+        size_t pos = 0;
+        auto read = [&](void* dst, size_t bytes) {
+            if (bytes > size_ - pos) return false;
+            std::memcpy(dst, base_ + pos, bytes);
+            pos += bytes;
+            return true;
+        };
+        uint32_t magic = 0, version = 0, num_tensors = 0;
+        if (!read(&magic, 4) || !read(&version, 4) || !read(&num_tensors, 4)) return false;
+        if (magic != kWeightBundleMagic || version != kWeightBundleVersion) return false;
+        for (uint32_t i = 0; i < num_tensors; ++i) {
+            BundleTensor t;
+            uint32_t name_len = 0, ndim = 0;
+            if (!read(&name_len, 4) || name_len > size_ - pos) return false;
+            t.name.assign(base_ + pos, name_len);
+            pos += name_len;
+            if (!read(&ndim, 4) || ndim > 8) return false;
+            t.dims.resize(ndim);
+            t.count = 1;
+            for (auto& d : t.dims) {
+                if (!read(&d, 8) || d < 0) return false;
+                t.count *= static_cast<size_t>(d);
+            }
+            if (t.count > (size_ - pos) / sizeof(float)) return false;
+            t.data = base_ + pos;
+            pos += t.count * sizeof(float);
+            tensors_.push_back(std::move(t));
+        }
+        return pos == size_;
+    }
+
+    const char* base_ = nullptr;
+    size_t size_ = 0;
+    std::vector<BundleTensor> tensors_;
+};
+
+}  // namespace bevfusion
+
+#endif  // WEIGHT_BUNDLE_H
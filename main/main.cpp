@@ -3,125 +3,149 @@
 #include <memory>
 #include <string>
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
 
-#include "apis_c.h"
+#include "chiplet_link.h"
+#include "frame_archive.h"
+#include "band_stream.h"
 
+// 各阶段 chiplet 的坐标
+constexpr int kCameraBackbone[2] = {0, 0};
+constexpr int kCameraVTransform[2] = {0, 1};
+constexpr int kLidarBackbone[2] = {0, 2};
+constexpr int kFuser[2] = {0, 3};
+constexpr int kHead[2] = {0, 4};
+
+// 用法: main <idX> <idY> [帧数] [帧归档.bfa] [起始帧序号]
+// 不给帧归档时每帧使用相同的常量输入；帧数须与 BEVfusion.yml 中各阶段的帧数参数一致
+//
+// 各阶段是常驻进程，内部双缓冲（common/stage_pipeline.h）。主控按波前调度：
+// 第 t 步给阶段 s 发第 t-d(s) 帧的输入，再收它第 t-d(s)-1 帧的结果，d 为该阶段在流水线中的深度
+// （camera_backbone 0，camera_vtransform / lidar_backbone 1，fuser 2，head 3）。
+// 这样每个阶段在计算第 k 帧时已经能收第 k+1 帧、发第 k-1 帧，各 chiplet 也同时在处理不同的帧。
+// 每步内先发后收，且上游的结果在同一步里就原样转发给下游（ChipletLink::forward），主控不为中间结果分配缓冲。
+//
+// camera_vtransform / lidar_backbone -> fuser 和 fuser -> head 的 BEV 特征按行带传输（common/band_stream.h），
+// 主控每收到一个行带就原样转发，下游不必等整帧到齐。
+//
+// 数据传输后端由 BEVFUSION_TRANSPORT 选择（common/transport.h），六个进程必须一致。
 int main(int argc, char** argv) {
     int idX = atoi(argv[1]);
     int idY = atoi(argv[2]);
-    std::cout << "启动 BEVfusion 推理流程..." << std::endl;
+    int num_frames = argc > 3 ? atoi(argv[3]) : 1;
+    std::cout << "启动 BEVfusion 推理流程，共 " << num_frames << " 帧..." << std::endl;
 
-    // try {
-        // 1. 相机骨干网络 (Camera Backbone)
-        float* camera_features = new float[6*32*88*80];
-        {
-            std::cout << "处理相机骨干网络 (1×6×3×256×704 -> 6×32×88×80)..." << std::endl;
-            
-            // 创建随机输入数据
-            float* img = new float[1 * 6 * 3 * 256 * 704];
-            float* depth = new float[1 * 6 * 1 * 256 * 704];
-            
-            // 初始化输入数据
-            for (int i = 0; i < 1 * 6 * 3 * 256 * 704; ++i) {
-                img[i] = 0.1f;  // 示例数据
-            }
-            
-            for (int i = 0; i < 1 * 6 * 1 * 256 * 704; ++i) {
-                depth[i] = 0.2f;  // 示例数据
-            }
-            
-            // 调用相机骨干网络
-            // camera_backbone(img, depth,camera_features);
-            InterChiplet::sendMessage(0, 0, idX, idY, img, 1 * 6 * 3 * 256 * 704 * sizeof(float));
-            std::cout<<"--------------------------------"<<std::endl;
-            InterChiplet::sendMessage(0, 0, idX, idY, depth, 1 * 6 * 1 * 256 * 704 * sizeof(float));
+    bevfusion::FrameArchiveReader archive;
+    size_t first_frame = 0;
+    if (argc > 4) {
+        if (!archive.open(argv[4]) || archive.num_frames() == 0) return 1;
+        first_frame = argc > 5 ? strtoull(argv[5], nullptr, 10) % archive.num_frames() : 0;
+        std::cout << "回放帧归档 " << argv[4] << " 自第 " << first_frame << " 帧起" << std::endl;
+    }
 
-            InterChiplet::receiveMessage(idX, idY, 0, 0, camera_features, 6*32*88*80 * sizeof(float));
-            // std::cout << "camera_features: " << camera_features[6*32*88] << std::endl;
-            
-            if (!camera_features) {
-                std::cerr << "相机骨干网络处理失败!" << std::endl;
-                return 1;
-            }
-            
-            // 清理输入数据
-            delete[] img;
-            delete[] depth;
+    // 常量示例数据
+    std::vector<float> img_buf(1 * 6 * 3 * 256 * 704, 0.1f);
+    std::vector<float> depth_buf(1 * 6 * 1 * 256 * 704, 0.2f);
+    std::vector<float> points_buf(3 * 5, 1.0f);
+    auto frame_at = [&](int f) {
+        if (archive.is_open()) return archive.frame((first_frame + f) % archive.num_frames());
+        bevfusion::FrameView v;
+        v.img = img_buf.data();
+        v.depth = depth_buf.data();
+        v.points = points_buf.data();
+        v.num_points = 3;
+        return v;
+    };
+    if (archive.is_open()) archive.advise_willneed(first_frame);
+
+    // 与各阶段的链路，主控一侧的对端就是该阶段
+    auto link_to = [&](const int* stage) { return bevfusion::ChipletLink(idX, idY, stage[0], stage[1]); };
+    bevfusion::ChipletLink camera_backbone = link_to(kCameraBackbone);
+    bevfusion::ChipletLink camera_vtransform = link_to(kCameraVTransform);
+    bevfusion::ChipletLink lidar_backbone = link_to(kLidarBackbone);
+    bevfusion::ChipletLink fuser = link_to(kFuser);
+    bevfusion::ChipletLink head = link_to(kHead);
+    bevfusion::ChipletLink* links[] = {&camera_backbone, &camera_vtransform, &lidar_backbone, &fuser, &head};
+    for (bevfusion::ChipletLink* link : links) {
+        if (!link->open()) return 1;
+    }
+
+    // 中间结果在同一步内从上游收到后立即原样转发给下游，不落到主控的缓冲里；行带消息不拆包，整条转发
+    const size_t camera_features_bytes = 6 * 32 * 88 * 80 * sizeof(float);
+    const bevfusion::BandLayout camera_bev_layout{80, 180, 180};
+    const bevfusion::BandLayout lidar_layout{256, 180, 180};
+    const bevfusion::BandLayout fused_layout{512, 180, 180};
+    bool finished = false;
+
+    auto valid = [&](int f) { return f >= 0 && f < num_frames; };
+
+    // 第 t 步的全部收发，任一条失败（对端阶段出错后中断了链路）时返回 false
+    auto step = [&](int t) {
+        // 1. 相机骨干网络 (1×6×3×256×704 -> 6×32×88×80)，深度 0
+        if (valid(t)) {
+            bevfusion::FrameView frame = frame_at(t);
+            if (archive.is_open() && valid(t + 1)) archive.advise_willneed((first_frame + t + 1) % archive.num_frames());
+            std::cout << "帧 " << t << ": 相机骨干网络" << std::endl;
+            if (!camera_backbone.send(frame.img, bevfusion::kImgElems * sizeof(float))) return false;
+            if (!camera_backbone.send(frame.depth, bevfusion::kDepthElems * sizeof(float))) return false;
         }
 
-        // 2. 相机视角变换 (Camera VTransform)
-        float* camera_bev_features = new float[1*80*180*180];
-        {
-            std::cout << "处理相机视角变换 (6×32×88×80 -> 1×80×180×180)..." << std::endl;
-            
-            // 调用相机视角变换模块
-            // camera_bev_features = camera_vtransform();
-            InterChiplet::sendMessage(0, 1, idX, idY, camera_features,  6 * 32 * 88 * 80 * sizeof(float));
-            InterChiplet::receiveMessage(idX, idY, 0, 1, camera_bev_features, 1*80*180*180 * sizeof(float));
-            
-            if (!camera_bev_features) {
-                std::cerr << "相机视角变换失败!" << std::endl;
-                return 1;
-            }
+        // 2. 相机视角变换 (6×32×88×80 -> 1×80×180×180)，深度 1：相机骨干网络第 t-1 帧的结果直接转发过去
+        if (valid(t - 1)) {
+            std::cout << "帧 " << t - 1 << ": 相机视角变换" << std::endl;
+            if (!camera_backbone.forward(camera_vtransform, camera_features_bytes)) return false;
         }
 
-        // 3. LiDAR骨干网络 (LiDAR Backbone)
-        float* lidar_features = new float[1*256*180*180];
-        float* input = new float[3 * 5];
-        for(int i = 0; i < 3 * 5; i++){
-            input[i] = 1.0f;
+        // 3. LiDAR骨干网络 (N×5 -> 1×256×180×180)，深度 1：先发消息头再发点云
+        if (valid(t - 1)) {
+            bevfusion::FrameView frame = frame_at(t - 1);
+            bevfusion::LidarFrameHeader lidar_header{frame.num_points, frame.timestamp_us, {}};
+            bevfusion::lidar_pose(frame.calib, lidar_header.lidar2global);
+            std::cout << "帧 " << t - 1 << ": LiDAR骨干网络 (" << frame.num_points << " 个点)" << std::endl;
+            if (!lidar_backbone.send(&lidar_header, sizeof(lidar_header))) return false;
+            if (!lidar_backbone.send(frame.points, frame.num_points * bevfusion::kPointDim * sizeof(float))) return false;
         }
-        {
-            std::cout << " 处理LiDAR骨干网络 (1×5 -> 1×256×180×180)..." << std::endl;
-            
-            // 调用LiDAR骨干网络
-            // lidar_features = lidar_backbone();
-            InterChiplet::sendMessage(0, 2, idX, idY, input, 3 * 5 * sizeof(float));
-            InterChiplet::receiveMessage(idX, idY, 0, 2, lidar_features, 1*256*180*180 * sizeof(float));
-            
-            if (!lidar_features) {
-                std::cerr << "LiDAR骨干网络处理失败!" << std::endl;
-                return 1;
+
+        // 4. 特征融合 (1×80×180×180 + 1×256×180×180 -> 1×512×180×180)，深度 2
+        //    两路第 t-2 帧的结果先转发 LiDAR 的全部行带、再转发相机的：相机分支较慢，
+        //    fuser 在等相机时已经算完 Conv_1 的 LiDAR 部分。再把 fuser 第 t-3 帧的结果逐行带转发给 head
+        if (valid(t - 2)) {
+            std::cout << "帧 " << t - 2 << ": 特征融合" << std::endl;
+            for (int b = 0; b < lidar_layout.num_bands(); ++b) {
+                if (!lidar_backbone.forward(fuser, lidar_layout.message_bytes(b))) return false;
+            }
+            for (int b = 0; b < camera_bev_layout.num_bands(); ++b) {
+                if (!camera_vtransform.forward(fuser, camera_bev_layout.message_bytes(b))) return false;
             }
         }
 
-        // 4. 特征融合 (Fuser)
-        float *fused_features = new float[1*512*180*180];
-        {
-            std::cout << "处理特征融合 (1×80×180×180 + 1×256×180×180 -> 1×512×180×180)..." << std::endl;
-            
-            // fused_features = fuser(camera_bev_features, lidar_features);
-            InterChiplet::sendMessage(0, 3, idX, idY, camera_bev_features, 1*80*180*180 * sizeof(float));
-            InterChiplet::sendMessage(0, 3, idX, idY, lidar_features, 1*256*180*180 * sizeof(float));
-            InterChiplet::receiveMessage(idX, idY, 0, 3, fused_features, 1*512*180*180 * sizeof(float));
+        // 5. 检测头 (1×512×180×180 -> 多个输出)，深度 3
+        if (valid(t - 3)) {
+            std::cout << "帧 " << t - 3 << ": 检测头" << std::endl;
+            for (int b = 0; b < fused_layout.num_bands(); ++b) {
+                if (!fuser.forward(head, fused_layout.message_bytes(b))) return false;
+            }
         }
-
-        // 5. 检测头 (Head)
-        {
-            std::cout << "处理检测头 (1×512×180×180 -> 多个输出)..." << std::endl;
-            bool* finished = new bool[1];
-            // 调用检测头
-            // head(fused_features);
-            InterChiplet::sendMessage(0, 4, idX, idY, fused_features, 1*512*180*180 * sizeof(float));
-            InterChiplet::receiveMessage(idX, idY, 0, 4, finished, 1 * sizeof(bool));
-            if(finished[0]){
-                std::cout << "检测头处理完成!" << std::endl;
+        if (valid(t - 4)) {
+            if (!head.receive(&finished, sizeof(bool))) return false;
+            if (finished) {
+                std::cout << "帧 " << t - 4 << " 检测头处理完成!" << std::endl;
             }
         }
+        return true;
+    };
 
-        // 释放内存
-        if (camera_features) delete[] camera_features;
-        if (camera_bev_features) delete[] camera_bev_features;
-        if (fused_features) delete[] fused_features;
-        if (lidar_features) delete[] lidar_features;
-        
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < num_frames + 4; ++t) {
+        if (!step(t)) {
+            std::cerr << "第 " << t << " 步与阶段的收发失败，中止全部链路" << std::endl;
+            for (bevfusion::ChipletLink* link : links) link->abort();
+            return 1;
+        }
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 
-        std::cout << " BEVfusion 推理完成!" << std::endl;
-        
-    // } catch (const std::exception& e) {
-    //     std::cerr << "❌ 错误: " << e.what() << std::endl;
-    //     return 1;
-    // }
-    
+    std::cout << " BEVfusion 推理完成! " << num_frames << " 帧, 耗时 " << elapsed << " s" << std::endl;
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,96 @@
+// 从原始转储目录构建帧归档 (.bfa)
+//
+// 用法: build_frame_archive <输出.bfa> <帧目录1> [帧目录2 ...]
+// 每个帧目录包含:
+//   img.bin        1×6×3×256×704 float32
+//   depth.bin      1×6×1×256×704 float32
+//   points.bin     N×5 float32（可直接使用 nuScenes 的 LIDAR_TOP .pcd.bin）
+//   calib.bin      FrameCalib 原始字节（可选，缺省为单位矩阵）
+//   timestamp.txt  微秒时间戳（可选，缺省为帧序号）
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "frame_archive.h"
+
+using namespace bevfusion;
+
+static bool read_file(const std::string& path, std::vector<char>& out) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) return false;
+    std::streamsize size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    out.resize(static_cast<size_t>(size));
+    return static_cast<bool>(file.read(out.data(), size));
+}
+
+static bool read_exact(const std::string& path, size_t bytes, std::vector<char>& out) {
+    if (!read_file(path, out)) {
+        std::cerr << "无法读取: " << path << std::endl;
+        return false;
+    }
+    if (out.size() != bytes) {
+        std::cerr << "文件大小不符: " << path << " (" << out.size() << " != " << bytes << ")" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "用法: " << argv[0] << " <输出.bfa> <帧目录1> [帧目录2 ...]" << std::endl;
+        return 1;
+    }
+
+    FrameArchiveWriter writer;
+    if (!writer.open(argv[1])) return 1;
+
+    std::vector<char> img, depth, points, calib_raw, ts_raw;
+    for (int i = 2; i < argc; ++i) {
+        std::string dir = argv[i];
+        if (!read_exact(dir + "/img.bin", kImgElems * sizeof(float), img)) return 1;
+        if (!read_exact(dir + "/depth.bin", kDepthElems * sizeof(float), depth)) return 1;
+        if (!read_file(dir + "/points.bin", points) || points.size() % (kPointDim * sizeof(float)) != 0) {
+            std::cerr << "点云文件缺失或大小不是 " << kPointDim << " 个 float 的整数倍: " << dir << "/points.bin" << std::endl;
+            return 1;
+        }
+
+        FrameCalib calib;
+        if (read_file(dir + "/calib.bin", calib_raw)) {
+            if (calib_raw.size() != sizeof(FrameCalib)) {
+                std::cerr << "标定文件大小不符: " << dir << "/calib.bin" << std::endl;
+                return 1;
+            }
+            memcpy(&calib, calib_raw.data(), sizeof(FrameCalib));
+        } else {
+            for (int c = 0; c < kNumCameras; ++c) {
+                set_identity(calib.camera_intrinsics[c]);
+                set_identity(calib.camera2lidar[c]);
+            }
+            set_identity(calib.lidar2ego);
+            set_identity(calib.ego2global);
+        }
+
+        uint64_t timestamp_us = static_cast<uint64_t>(i - 2);
+        if (read_file(dir + "/timestamp.txt", ts_raw)) {
+            timestamp_us = std::strtoull(std::string(ts_raw.begin(), ts_raw.end()).c_str(), nullptr, 10);
+        }
+
+        uint64_t num_points = points.size() / (kPointDim * sizeof(float));
+        if (!writer.append(reinterpret_cast<const float*>(img.data()), reinterpret_cast<const float*>(depth.data()),
+                           calib, reinterpret_cast<const float*>(points.data()), num_points, timestamp_us)) {
+            return 1;
+        }
+        std::cout << "已写入帧 " << writer.num_frames() - 1 << ": " << dir << " (" << num_points << " 个点)" << std::endl;
+    }
+
+    if (!writer.finish()) {
+        std::cerr << "写入帧归档索引失败" << std::endl;
+        return 1;
+    }
+    std::cout << "帧归档构建完成: " << argv[1] << " (" << writer.num_frames() << " 帧)" << std::endl;
+    return 0;
+}